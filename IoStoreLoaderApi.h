@@ -0,0 +1,142 @@
+#pragma once
+
+/*
+ * C API exported by IoStoreLoaderMod's main.dll, so other UE4SS mods can mount containers
+ * through the engine objects and hooks this loader already has instead of scanning for them
+ * again. Look the functions up with GetProcAddress on the loader's module, e.g.
+ *
+ *   HMODULE m = GetModuleHandleW(L"<game>/Binaries/Win64/Mods/IoStoreLoaderMod/dlls/main.dll");
+ *   auto version = (IoStoreLoaderApiVersionFunc)GetProcAddress(m, "iostore_loader_api_version");
+ *
+ * and check iostore_loader_api_version() against IOSTORE_LOADER_API_VERSION first. Functions
+ * may be called from any thread; mount callbacks run on the thread that completed the mount,
+ * event callbacks on the game thread inside ProcessEvent.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <wchar.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IOSTORE_LOADER_API_VERSION 3   /* 2: iostore_loader_subscribe_event, 3: iostore_loader_enum_resident */
+
+/* return codes; mount ids are > 0 */
+#define IOSTORE_LOADER_OK               0
+#define IOSTORE_LOADER_E_INVALID_ARG   -1   /* null pointer, or struct_size below IOSTORE_LOADER_MOUNT_INFO_V1_SIZE */
+#define IOSTORE_LOADER_E_NOT_FOUND     -2   /* no such mount id */
+#define IOSTORE_LOADER_E_BAD_CONTAINER -3   /* not a .pak/.utoc, or the file does not exist */
+
+/* when an event callback runs, relative to the UFunction */
+#define IOSTORE_LOADER_EVENT_PRE  0
+#define IOSTORE_LOADER_EVENT_POST 1
+
+typedef enum IoStoreLoaderMountState {
+    IOSTORE_LOADER_QUEUED  = 0,   /* waiting for the engine's mount functions */
+    IOSTORE_LOADER_MOUNTED = 1,
+    IOSTORE_LOADER_FAILED  = 2,
+} IoStoreLoaderMountState;
+
+typedef enum IoStoreLoaderContainerKind {
+    IOSTORE_LOADER_PAK     = 0,
+    IOSTORE_LOADER_IOSTORE = 1,
+} IoStoreLoaderContainerKind;
+
+typedef struct IoStoreLoaderMountInfo {
+    uint32_t struct_size;    /* set to sizeof(IoStoreLoaderMountInfo) before the call; see below */
+    int32_t  id;
+    int32_t  order;
+    int32_t  kind;           /* IoStoreLoaderContainerKind */
+    int32_t  state;          /* IoStoreLoaderMountState */
+    int32_t  io_error;       /* EIoErrorCode from FIoDispatcher::Mount, 0 = Ok */
+    int32_t  external;       /* 1 if mounted through this API, 0 if one of the loader's mods */
+    wchar_t  path[512];      /* .pak or .utoc, truncated to fit */
+    wchar_t  message[128];   /* FIoStatus message, or why the loader did not mount it */
+} IoStoreLoaderMountInfo;
+
+/*
+ * Fields are only ever added at the end. iostore_loader_get_mount fills the first struct_size
+ * bytes (at most the loader's own layout), so a caller built against an older header keeps
+ * working with a newer loader. Callbacks get the loader's full layout, with struct_size set to
+ * its size.
+ */
+#define IOSTORE_LOADER_MOUNT_INFO_V1_SIZE (offsetof(IoStoreLoaderMountInfo, message) + 128 * sizeof(wchar_t))
+
+typedef void (*IoStoreLoaderMountCallback)(int32_t id, const IoStoreLoaderMountInfo* info, void* user);
+
+/* return non-zero to stop enumerating */
+typedef int32_t (*IoStoreLoaderEnumCallback)(const IoStoreLoaderMountInfo* info, void* user);
+
+/* estimated memory the engine keeps for mounted containers, in bytes; see iostore_loader_enum_resident */
+typedef struct IoStoreLoaderResidentInfo {
+    uint32_t struct_size;           /* sizeof(IoStoreLoaderResidentInfo) of the loader */
+    uint32_t open_handles;          /* one per .ucas partition, plus one per pak */
+    uint32_t containers;
+    uint32_t reserved;
+    uint64_t total;
+    uint64_t chunk_map;
+    uint64_t compression_blocks;
+    uint64_t block_signatures;
+    uint64_t compression_methods;
+    uint64_t directory_index;
+    uint64_t package_store;
+    uint64_t partitions;
+    uint64_t pak_index;
+    wchar_t  mod_name[128];         /* empty for the total over all mods */
+} IoStoreLoaderResidentInfo;
+
+/* return non-zero to stop enumerating */
+typedef int32_t (*IoStoreLoaderResidentCallback)(const IoStoreLoaderResidentInfo* info, void* user);
+
+/* `object` and `function` are the UObject* and UFunction* ProcessEvent got, `params` its parameters */
+typedef void (*IoStoreLoaderEventCallback)(void* object, void* function, void* params, void* user);
+
+/* IOSTORE_LOADER_API_VERSION of the loader */
+typedef uint32_t (*IoStoreLoaderApiVersionFunc)(void);
+
+/*
+ * Mounts `path` (absolute, a .pak or a .utoc next to its .ucas) at `order`. Before the engine
+ * has mounted its own paks the request is queued and mounted right after the loader's mods.
+ * `callback`, if set, runs once the mount completed or failed, before this returns when that
+ * happens right away. Returns the mount id or an IOSTORE_LOADER_E_* code.
+ */
+typedef int32_t (*IoStoreLoaderMountFunc)(const wchar_t* path, int32_t order, IoStoreLoaderMountCallback callback, void* user);
+
+/* fills `out` for mount `id`; IOSTORE_LOADER_OK or an error code */
+typedef int32_t (*IoStoreLoaderGetMountFunc)(int32_t id, IoStoreLoaderMountInfo* out);
+
+/* calls `callback` for every mount so far, the loader's and other mods', in id order; returns the count */
+typedef int32_t (*IoStoreLoaderEnumMountsFunc)(IoStoreLoaderEnumCallback callback, void* user);
+
+/*
+ * Runs `callback` when mount `id` completes; right away if it already has. Replaces a callback
+ * passed to iostore_loader_mount. IOSTORE_LOADER_OK or an error code.
+ */
+typedef int32_t (*IoStoreLoaderOnMountedFunc)(int32_t id, IoStoreLoaderMountCallback callback, void* user);
+
+/*
+ * Calls `callback` whenever ProcessEvent runs the UFunction at `function_path`, e.g.
+ * L"/Script/Engine.Actor:ReceiveBeginPlay"; a bare name such as L"ReceiveBeginPlay" matches that
+ * function on any class. A path that is not loaded yet is looked up again every 250 ms, and again
+ * after its class was unloaded. `phase` is IOSTORE_LOADER_EVENT_PRE or _POST. Calls that match no
+ * subscription cost the same however many there are. Returns the subscription id or an
+ * IOSTORE_LOADER_E_* code. Since version 2.
+ */
+typedef int32_t (*IoStoreLoaderSubscribeEventFunc)(const wchar_t* function_path, int32_t phase, IoStoreLoaderEventCallback callback, void* user);
+
+/*
+ * Calls `callback` with the estimated resident memory of everything mounted so far: the total
+ * first, then one call per mod, largest first. Counts containers mounted later by mount = lazy
+ * once they are mounted. Returns the number of mods, or an IOSTORE_LOADER_E_* code. Since
+ * version 3.
+ */
+typedef int32_t (*IoStoreLoaderEnumResidentFunc)(IoStoreLoaderResidentCallback callback, void* user);
+
+/* takes effect once the ProcessEvent call running now, if any, has returned; IOSTORE_LOADER_OK or an error code */
+typedef int32_t (*IoStoreLoaderUnsubscribeEventFunc)(int32_t id);
+
+#ifdef __cplusplus
+}
+#endif
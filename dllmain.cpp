@@ -9,20 +9,35 @@
 #include <Unreal/Hooks.hpp>
 #include <Unreal/UFunction.hpp>
 #include <Unreal/FField.hpp>
+#include <Unreal/FWeakObjectPtr.hpp>
 
 #include <windows.h>
 #include <MinHook.h>
 
+#include "IoStoreLoaderApi.h"
+#include "loader/flat_ptr_map.hpp"
+#include "loader/mount_pipeline.hpp"
+#include "loader/read_order.hpp"
+
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <filesystem>
+#include <mutex>
 #include <system_error>
+#include <thread>
+#include <unordered_map>
 
 namespace fs = std::filesystem;
 
+using loader::widen_ascii;
+
 #define LOG_NOTICE(...) Output::send<LogLevel::Verbose>(STR("[IoStoreLoaderMod] ") __VA_ARGS__)
 #define LOG_INFO(...)   Output::send<LogLevel::Normal>(STR("[IoStoreLoaderMod] ") __VA_ARGS__)
 #define LOG_WARN(...)   Output::send<LogLevel::Warning>(STR("[IoStoreLoaderMod] ") __VA_ARGS__)
@@ -32,7 +47,6 @@ using namespace RC;
 using namespace RC::Unreal;
 
 static const std::wstring kModName = STR("IoStoreLoaderMod");
-static const int          kBaseOrder = 200;
 
 namespace sigscan
 {
@@ -202,134 +216,38 @@ namespace sigscan
     }
 }
 
-static inline std::wstring
-widen_ascii(const std::string& s)
+// the working directory is fixed for the whole session, so it is resolved once
+static inline const fs::path&
+working_dir()
 {
-    return std::wstring(s.begin(), s.end());
+    static const fs::path dir = fs::current_path().lexically_normal();
+    return dir;
 }
 
-static inline fs::path
+static inline const fs::path&
 loader_root()
 {
-    return (fs::current_path() / "Mods" / kModName).lexically_normal();
-}
-
-static inline bool
-file_exists(const fs::path& p)
-{
-    std::error_code ec;
-    return fs::exists(p, ec);
-}
-
-static inline fs::path
-base_to_ext(const fs::path& base_no_ext, const wchar_t* ext)
-{
-    fs::path p = base_no_ext;
-    p.replace_extension(ext);
-    return p;
-}
-
-static bool
-has_ucas_any(const fs::path& base_no_ext)
-{
-    if (file_exists(base_to_ext(base_no_ext, L".ucas"))) {
-        return true;
-    }
-    
-    for (int i = 1; i <= 16; ++i) {
-        fs::path p = base_no_ext;
-        p += L".ucas" + std::to_wstring(i);
-        if (file_exists(p)) {
-            return true;
-        }
-    }
-    return false;
-}
-
-static inline std::vector<fs::path>
-list_files_ext_sorted(const fs::path& dir, std::wstring_view ext)
-{
-    std::vector<fs::path> out;
-    std::error_code ec;
-
-    if (!fs::exists(dir, ec) || !fs::is_directory(dir, ec)) {
-        return out;
-    }
-
-    for (auto& it : fs::directory_iterator(dir, ec)) {
-        if (ec) {
-            break;
-        }
-
-        if (!it.is_regular_file(ec)) {
-            continue;
-        }
-
-        auto p = it.path();
-        if (p.extension() == ext) {
-            out.push_back(p.lexically_normal());
-        }
-    }
-
-    std::sort(out.begin(), out.end());
-    out.erase(std::unique(out.begin(), out.end()), out.end());
-    return out;
+    static const fs::path root = (working_dir() / "Mods" / kModName).lexically_normal();
+    return root;
 }
 
-static inline std::wstring
-to_game_relative_path(const fs::path& absolute_path)
+static void
+log_pipeline(loader::MountLogLevel level, const std::wstring& line)
 {
-    fs::path working_dir = fs::current_path();
-
-    std::error_code ec;
-    fs::path rel_path = fs::relative(absolute_path, working_dir, ec);
-
-    if (ec || rel_path.empty()) {
-        LOG_WARN(STR("Could not compute relative path for: {}\n"), absolute_path.wstring());
-        return absolute_path;
+    switch (level) {
+    case loader::MountLogLevel::Notice: LOG_NOTICE(STR("{}"), line); break;
+    case loader::MountLogLevel::Info:   LOG_INFO(STR("{}"), line); break;
+    case loader::MountLogLevel::Warn:   LOG_WARN(STR("{}"), line); break;
+    case loader::MountLogLevel::Error:  LOG_ERROR(STR("{}"), line); break;
     }
-
-    std::wstring result = rel_path.wstring();
-    std::replace(result.begin(), result.end(), L'\\', L'/');
-
-    return result;
 }
 
-static inline std::vector<fs::path>
-discover_mod_dirs()
+// discovery to mount; also owns the config, the mounted container list and the actor queue
+static inline loader::MountPipeline&
+pipeline()
 {
-    std::vector<fs::path> dirs;
-    std::error_code ec;
-
-    fs::path root = loader_root();
-
-    if (!fs::exists(root, ec) || !fs::is_directory(root, ec)) {
-        return dirs;
-    }
-
-    for (auto& it : fs::directory_iterator(root, ec)) {
-        if (ec) {
-            break;
-        }
-
-        if (!it.is_directory(ec)) {
-            continue;
-        }
-
-        fs::path     p     = it.path().lexically_normal();
-        std::wstring fname = p.filename().wstring();
-
-        if (_wcsicmp(fname.c_str(), L"dlls")     == 0 ||
-            _wcsicmp(fname.c_str(), L"scripts")  == 0 ||
-            _wcsicmp(fname.c_str(), L"disabled") == 0) {
-            continue;
-        }
-
-        dirs.push_back(p);
-    }
-
-    std::sort(dirs.begin(), dirs.end());
-    return dirs;
+    static loader::MountPipeline p(working_dir(), loader_root(), log_pipeline);
+    return p;
 }
 
 static inline void*
@@ -346,117 +264,10 @@ resolve_rip_rel32_mov_target(const uint8_t* mov_inst /*48*/)
 	return (void*)(mov_inst + 7 + rel);
 }
 
-namespace POD
-{
-    enum class EIoErrorCode {
-        Ok,
-        Unknown,
-        InvalidCode,
-        Cancelled,
-        FileOpenFailed,
-        FileNotOpen,
-        ReadError,
-        WriteError,
-        NotFound,
-        CorruptToc,
-        UnknownChunkID,
-        InvalidParameter,
-        SignatureError,
-        InvalidEncryptionKey,
-    };
-
-    struct FIoStatus {
-        EIoErrorCode ErrorCode;
-        wchar_t      ErrorMessage[128];
-    };
+namespace POD = loader::POD;
 
-    template <typename T>
-    struct TArray
-    {
-        T* Data;
-        int32_t Num;
-        int32_t Max;
-    };
-
-    struct FString
-    {
-        TArray<TCHAR> Data{ nullptr, 0, 0 };
-
-        FString() = default;
-        FString(const wchar_t* src, int32_t len, int32_t slack = 256)
-        {
-            const int32_t capacity = len + 1 + slack;
-
-            TCHAR* buffer = static_cast<TCHAR*>(std::malloc(sizeof(TCHAR) * capacity));
-            if (!buffer) {
-                Data = {};
-                return;
-            }
-
-            std::memcpy(buffer, src, sizeof(TCHAR) * len);
-            buffer[len] = L'\0';
-
-            Data.Data = buffer;
-            Data.Num = len + 1;
-            Data.Max = capacity;
-        }
-
-        ~FString()
-        {
-            if (Data.Data) {
-                std::free(Data.Data);
-                Data = {};
-            }
-        }
-
-        // disable copy
-        FString(const FString&) = delete;
-        FString& operator=(const FString&) = delete;
-
-        // allow move
-        FString(FString&& other) noexcept
-        {
-            Data = other.Data;
-            other.Data = {};
-        }
-
-        FString& operator=(FString&& other) noexcept
-        {
-            if (this != &other) {
-                if (Data.Data) {
-                    std::free(Data.Data);
-                }
-                Data = other.Data;
-                other.Data = {};
-            }
-            return *this;
-        }
-    };
-
-    struct FIoEnvironment {
-        FString Path;
-        int32_t   Order = 0;
-
-        FIoEnvironment(const std::wstring& path, int order)
-            : Path(path.c_str(), static_cast<int32_t>(path.size()), 512), Order(order)
-        {
-        }
-    };
-
-    struct FGuid {
-        uint32_t A;
-        uint32_t B;
-        uint32_t C;
-        uint32_t D;
-    };
-
-    struct FAES {
-        uint8_t Key[32];
-    };
-};
-
-using FIoDispatcherMountFunc               = POD::FIoStatus* (__fastcall*)(void* self, POD::FIoStatus* status, POD::FIoEnvironment* env, POD::FGuid* guid, POD::FAES* key);
-using FPakPlatformFileMountFunc            = bool (__fastcall*)(void* self, const wchar_t* pak_filename, int pak_order, const wchar_t* path, bool load_index);
+using loader::FIoDispatcherMountFunc;
+using loader::FPakPlatformFileMountFunc;
 using FPakPlatformFileMountAllPakFilesFunc = int (__fastcall*)(void* self, TArray<FString>* pak_folders, FString* wildcard);
 using StaticLoadClassFunc                  = UClass* (__fastcall*)(UClass*, UObject*, const wchar_t*, const wchar_t*, uint32_t);
 
@@ -464,9 +275,12 @@ static FIoDispatcherMountFunc               g_real_io_mount  = nullptr;
 static FPakPlatformFileMountFunc            g_real_pak_mount = nullptr;
 static FPakPlatformFileMountAllPakFilesFunc g_real_mount_all = nullptr;
 
-static StaticLoadClassFunc static_load_class = nullptr;
+static StaticLoadClassFunc static_load_class        = nullptr;
+static StaticLoadClassFunc g_real_static_load_class = nullptr;
+
+static loader::LoadPackageAsyncFunc load_package_async = nullptr;
 
-static std::vector<std::wstring> g_pending_mod_actor_classes;
+static POD::FMalloc** g_gmalloc = nullptr;
 
 static void* g_io_dispatcher     = nullptr;
 static void* g_pak_platform_file = nullptr;
@@ -475,12 +289,106 @@ static bool g_mount_hook_installed = false;
 static bool g_user_mounted_once    = false;
 static bool g_spawn_hook_installed = false;
 
+// verify = background
+static std::thread       g_verify_thread;
+static std::atomic<bool> g_verify_cancel{ false };
+
+// record_reads: which chunks of mod containers the engine reads, in order, for tools/ucas_reorder
+using CreateFileWFunc = HANDLE (WINAPI*)(LPCWSTR, DWORD, DWORD, LPSECURITY_ATTRIBUTES, DWORD, DWORD, HANDLE);
+using ReadFileFunc    = BOOL (WINAPI*)(HANDLE, LPVOID, DWORD, LPDWORD, LPOVERLAPPED);
+
+static CreateFileWFunc           g_real_create_file   = nullptr;
+static ReadFileFunc              g_real_read_file     = nullptr;
+static void*                     g_create_file_target = nullptr;
+static void*                     g_read_file_target   = nullptr;
+static loader::ReadOrderRecorder g_read_order;
+static std::atomic<bool>         g_recording_reads{ false };
+static std::thread               g_record_thread;
+static std::atomic<bool>         g_record_cancel{ false };
+
+// ModActor classes requested through LoadPackageAsync; each is rooted once it has loaded so the
+// GC of the next level load does not throw it away before BeginPlay, and unrooted once the spawns
+// are done, after which the spawned actors keep it alive
+struct ClassPreload {
+    std::wstring   class_path;
+    bool           loaded = false;
+    FWeakObjectPtr rooted;
+};
+
+static std::vector<ClassPreload>             g_class_preloads;
+static size_t                                g_class_preloads_pending = 0;
+static bool                                  g_class_preload_started  = false;
+static std::chrono::steady_clock::time_point g_class_preload_start;
+static std::chrono::steady_clock::time_point g_class_preload_next_poll;
+
+// ModActor spawns left from the last PlayerController BeginPlay, drained on engine ticks; the
+// budget is read once per world so a tick never waits on the pipeline lock behind a lazy mount
+static loader::SpawnQueue g_spawn_queue;
+static FWeakObjectPtr     g_spawn_world;
+static double             g_spawn_budget_ms = 0;
+
+// The ReceiveBeginPlay subscription, dropped once a world's spawns are done and taken again when
+// the next world's game mode initializes, so gameplay in between does not pay for it
+static uint32_t       g_spawn_listener = 0;
+static FWeakObjectPtr g_spawn_retry_pc;   // PlayerController whose BeginPlay came before its world
+
 static POD::FIoStatus* __fastcall
 io_mount_hook(void* self, POD::FIoStatus* status, POD::FIoEnvironment* env, POD::FGuid* guid, POD::FAES* key);
 static bool __fastcall
 pak_mount_hook(void* self, const wchar_t* pak_filename, int pak_order, const wchar_t* path, bool load_index);
 static int __fastcall
 mount_all_hook(void* self, TArray<FString>* pak_folders, FString* wildcard);
+static bool
+resolve_static_load_class(void);
+static void
+install_lazy_mount_hook(void);
+
+static bool
+resolve_gmalloc(void)
+{
+    // same pattern as UE4SS_Signatures/GMalloc.lua; the mov that reads GMalloc is 0x1C bytes in
+    const uint8_t* match = sigscan::scan_exec(
+        GetModuleHandleW(nullptr),
+        "48 89 5C 24 10 48 89 6C 24 18 56 57 41 54 41 56 41 57 48 83 EC 40 45 33 E4 48 8B F1 48 8B 0D ?? ?? ?? ?? 41 8B DC 89 5C 24 70 4C 8B F2 48 85 C9 75 0C E8 ?? ?? ?? ?? 48 8B 0D"
+    );
+
+    if (!match) {
+        LOG_WARN(STR("GMalloc not found; FStrings built by the loader stay on the CRT heap\n"));
+        return false;
+    }
+
+    g_gmalloc = reinterpret_cast<POD::FMalloc**>(resolve_rip_rel32_mov_target(match + 0x1C));
+
+    LOG_INFO(STR("Found GMalloc at {:p}\n"), (void*)g_gmalloc);
+    return true;
+}
+
+static void*
+gmalloc_alloc(size_t bytes)
+{
+    POD::FMalloc* m = *g_gmalloc;
+    return m->Vtbl->Malloc(m, bytes, 0);
+}
+
+static void
+gmalloc_free(void* p)
+{
+    POD::FMalloc* m = *g_gmalloc;
+    m->Vtbl->Free(m, p);
+}
+
+// Points POD::FString at GMalloc. Called before the loader builds its first string and after the
+// engine has created its allocator, so no string is freed by an allocator it did not come from.
+static void
+use_engine_allocator(void)
+{
+    if (!g_gmalloc || !*g_gmalloc || loader::fstring_allocator().alloc) {
+        return;
+    }
+
+    loader::fstring_allocator() = { gmalloc_alloc, gmalloc_free };
+    LOG_NOTICE(STR("FStrings built by the loader now come from GMalloc\n"));
+}
 
 static bool
 patch_memory(void* address, const void* data, size_t size)
@@ -526,108 +434,245 @@ patch_get_pak_signkey_helper(void)
     return true;
 }
 
+// verify = background: hashes every mounted container on a worker thread, one container at a
+// time with all cores; corrupt containers stay mounted but are logged
 static void
-mount_one_pak(const fs::path& pak_path, int order)
+start_background_verify(void)
 {
-    if (!g_pak_platform_file || !g_real_pak_mount) {
-        LOG_WARN(STR("Pak mount unavailable (self={:p}, fn={:p})\n"), g_pak_platform_file, (void*)g_real_pak_mount);
+    if (pipeline().config().verify != loader::VerifyMode::Background || pipeline().mounted().empty() || g_verify_thread.joinable()) {
         return;
     }
 
-    std::wstring game_rel_path = to_game_relative_path(pak_path);
+    g_verify_thread = std::thread([bases = pipeline().mounted()]() {
+        uint64_t bytes = 0;
+        size_t   bad   = 0;
+        auto     t0    = std::chrono::steady_clock::now();
 
-    pak_mount_hook(
-        g_pak_platform_file,
-        game_rel_path.c_str(),
-        order,
-        nullptr,
-        true
-    );
+        for (const auto& base : bases) {
+            if (g_verify_cancel.load()) {
+                return;
+            }
+
+            std::string              err;
+            loader::UcasVerifyResult r;
+            if (!loader::verify_iostore_container(base, r, err, &g_verify_cancel)) {
+                LOG_ERROR(STR("Cannot verify {}: {}\n"), base.wstring(), widen_ascii(err));
+                ++bad;
+                continue;
+            }
+
+            pipeline().log_verify_result(base, r);
+            bytes += r.bytes;
+            bad   += r.ok() ? 0 : 1;
+        }
+
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        LOG_INFO(STR("Background verification done: {} container(s), {} corrupt, {} MiB in {:.1f} s ({:.0f} MiB/s)\n"),
+                 bases.size(), bad, bytes >> 20, s, s > 0 ? (bytes / 1048576.0) / s : 0.0);
+    });
+}
+
+static HANDLE WINAPI
+create_file_hook(LPCWSTR name, DWORD access, DWORD share, LPSECURITY_ATTRIBUTES sa, DWORD disposition, DWORD flags, HANDLE tmpl)
+{
+    HANDLE h = g_real_create_file(name, access, share, sa, disposition, flags, tmpl);
+    if (h != INVALID_HANDLE_VALUE && g_recording_reads.load(std::memory_order_relaxed)) {
+        size_t n = name ? wcslen(name) : 0;
+        if (n >= 5 && _wcsicmp(name + n - 5, L".ucas") == 0) {
+            g_read_order.on_open(h, name);
+        } else {
+            g_read_order.forget(h);
+        }
+    }
+    return h;
+}
+
+static BOOL WINAPI
+read_file_hook(HANDLE h, LPVOID buffer, DWORD size, LPDWORD read, LPOVERLAPPED overlapped)
+{
+    if (g_recording_reads.load(std::memory_order_relaxed)) {
+        if (overlapped) {
+            g_read_order.on_read(h, overlapped->Offset | ((uint64_t)overlapped->OffsetHigh << 32), size);
+        } else if (g_read_order.tracks(h)) {
+            LARGE_INTEGER zero{}, pos{};
+            if (SetFilePointerEx(h, zero, &pos, FILE_CURRENT)) {
+                g_read_order.on_read(h, (uint64_t)pos.QuadPart, size);
+            }
+        }
+    }
+    return g_real_read_file(h, buffer, size, read, overlapped);
 }
 
+static bool
+install_read_order_hooks(void)
+{
+    MH_STATUS s = MH_CreateHookApiEx(L"kernel32", "CreateFileW", (LPVOID)create_file_hook, (LPVOID*)&g_real_create_file, &g_create_file_target);
+    if (s == MH_OK) {
+        s = MH_CreateHookApiEx(L"kernel32", "ReadFile", (LPVOID)read_file_hook, (LPVOID*)&g_real_read_file, &g_read_file_target);
+    }
+    if (s == MH_OK) {
+        s = MH_EnableHook(g_create_file_target);
+    }
+    if (s == MH_OK) {
+        s = MH_EnableHook(g_read_file_target);
+    }
+    if (s != MH_OK) {
+        LOG_ERROR(STR("Failed to hook CreateFileW/ReadFile for record_reads: {}\n"), widen_ascii(MH_StatusToString(s)));
+        return false;
+    }
+    return true;
+}
+
+// Hooks file opens and reads before anything is mounted; mount_one_* register the containers.
 static void
-mount_one_utoc_ucas(const fs::path& path, int order)
+begin_read_order_capture(void)
 {
-    if (!g_io_dispatcher || !g_real_io_mount) {
-        LOG_WARN(STR("IoStore mount unavailable (self={:p}, fn={:p})\n"), g_io_dispatcher, (void*)g_real_io_mount);
+    if (!pipeline().config().record_reads || g_recording_reads || g_record_thread.joinable() || !install_read_order_hooks()) {
         return;
     }
+    g_recording_reads = true;
+}
 
-    fs::path base = path;
-    base.replace_extension(L"");
+static void
+record_container_reads(const fs::path& base)
+{
+    if (!g_recording_reads) {
+        return;
+    }
+
+    std::string err;
+    if (!g_read_order.add_container(base, err)) {
+        LOG_WARN(STR("Not recording reads of {}: {}\n"), base.filename().wstring(), widen_ascii(err));
+    }
+}
 
-    if (!file_exists(base_to_ext(base, L".utoc")) || !has_ucas_any(base)) {
-        LOG_WARN(STR("Missing IoStore pair for base: {}\n"), base.wstring());
+// After record_reads seconds (or at shutdown) stops recording, unhooks and merges what was read
+// into read_order.bin, after the chunks earlier sessions recorded.
+static void
+finish_read_order_capture_later(void)
+{
+    if (!g_recording_reads || g_record_thread.joinable()) {
         return;
     }
 
-    std::wstring game_rel_path = to_game_relative_path(base);
+    LOG_INFO(STR("Recording mod container reads for {} s\n"), pipeline().config().record_reads);
+    g_record_thread = std::thread([seconds = pipeline().config().record_reads]() {
+        auto until = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+        while (!g_record_cancel.load() && std::chrono::steady_clock::now() < until) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+
+        g_recording_reads = false;
+        MH_DisableHook(g_read_file_target);
+        MH_DisableHook(g_create_file_target);
+
+        const fs::path path = loader_root() / L"read_order.bin";
 
-    POD::FIoEnvironment env(game_rel_path, order);
-    POD::FIoStatus      status{};
-    POD::FGuid          guid{};
-    POD::FAES           key{};
+        std::string          err;
+        loader::ReadOrderLog log;
+        loader::ReadOrderLog session = g_read_order.snapshot();
+        if (!loader::read_read_order_log(path, log, err)) {
+            log = loader::ReadOrderLog{};
+        }
+        loader::merge_read_order(log, session);
 
-    io_mount_hook(g_io_dispatcher, &status, &env, &guid, &key);
+        if (!loader::write_read_order_log(path, log, err)) {
+            LOG_WARN(STR("Failed to write {}: {}\n"), path.wstring(), widen_ascii(err));
+            return;
+        }
+
+        size_t chunks = 0;
+        for (const auto& c : session.containers) {
+            chunks += c.chunk_count();
+        }
+        LOG_INFO(STR("Recorded {} read(s) of {} chunk(s) in {} container(s) to {}\n"),
+                 g_read_order.reads(), chunks, session.containers.size(), path.wstring());
+    });
 }
 
+// IoStoreLoaderApi.h: completion callbacks by mount id, each run once
+struct ApiCallback {
+    IoStoreLoaderMountCallback fn   = nullptr;
+    void*                      user = nullptr;
+};
+
+static std::mutex                                g_api_mutex;
+static std::unordered_map<int32_t, ApiCallback> g_api_callbacks;
+
 static void
-queue_mod_actor_spawn(const std::wstring& mod_name)
+fill_mount_info(const loader::MountRecord& r, IoStoreLoaderMountInfo& out)
 {
-    // /Game/Mods/<ExampleMod>/ModActor.ModActor_C
-    std::wstring path = L"/Game/Mods/" + mod_name + L"/ModActor.ModActor_C";
-    g_pending_mod_actor_classes.push_back(std::move(path));
+    out.id       = (int32_t)r.id;
+    out.order    = r.order;
+    out.kind     = r.kind == loader::ContainerKind::Pak ? IOSTORE_LOADER_PAK : IOSTORE_LOADER_IOSTORE;
+    out.state    = r.state == loader::MountState::Queued    ? IOSTORE_LOADER_QUEUED
+                 : r.state == loader::MountState::Mounted ? IOSTORE_LOADER_MOUNTED
+                                                          : IOSTORE_LOADER_FAILED;
+    out.io_error = r.io_error;
+    out.external = r.external ? 1 : 0;
+
+    std::wstring path = r.path.wstring();
+    wcsncpy(out.path, path.c_str(), std::size(out.path) - 1);
+    out.path[std::size(out.path) - 1] = L'\0';
+    wcsncpy(out.message, r.message.c_str(), std::size(out.message) - 1);
+    out.message[std::size(out.message) - 1] = L'\0';
 }
 
+// runs and drops the callback registered for `id`, if the mount has completed
 static void
-mount_mod_folder_only_pak(const fs::path& mod_dir, int order_base)
+notify_api_mount(uint32_t id)
 {
-    // preferred: mount all .pak files found in the mod folder
-    auto paks = list_files_ext_sorted(mod_dir, L".pak");
-    if (!paks.empty()) {
-        for (size_t i = 0; i < paks.size(); ++i) {
-            mount_one_pak(paks[i], order_base + (int)i);
-            
-            auto base_name = paks[i].filename().replace_extension("").wstring();
-			queue_mod_actor_spawn(base_name);
-        }
+    loader::MountRecord r;
+    if (!pipeline().find_record(id, r) || r.state == loader::MountState::Queued) {
         return;
     }
 
-    // if user supplied only IoStore (.utoc/.ucas) but no .pak
-    // we cannot mount it without calling IoDispatcher.
-    auto utocs = list_files_ext_sorted(mod_dir, L".utoc");
-    if (!utocs.empty()) {
-        for (size_t i = 0; i < utocs.size(); ++i) {
-			mount_one_utoc_ucas(utocs[i], order_base + (int)i);
-
-            auto base_name = utocs[i].filename().replace_extension("").wstring();
-            queue_mod_actor_spawn(base_name);
+    ApiCallback cb;
+    {
+        std::lock_guard<std::mutex> lock(g_api_mutex);
+        auto it = g_api_callbacks.find((int32_t)id);
+        if (it == g_api_callbacks.end()) {
+            return;
         }
-        return;
+        cb = it->second;
+        g_api_callbacks.erase(it);
     }
 
-    LOG_WARN(STR("No .pak or .utoc/.ucas found in {}\n"), mod_dir.wstring());
+    IoStoreLoaderMountInfo info{};
+    info.struct_size = sizeof(info);
+    fill_mount_info(r, info);
+    cb.fn((int32_t)id, &info, cb.user);
 }
 
 static void
 mount_all_user_mods_once(void)
 {
-    auto mods = discover_mod_dirs();
-    if (mods.empty()) {
-        LOG_INFO(STR("No user mods found under {}\n"), loader_root().wstring());
-        return;
+    loader::MountPipeline& p = pipeline();
+    p.load_config();
+    begin_read_order_capture();
+
+    // mounts go through our hooks, which log each call and forward to the engine
+    loader::MountBackend backend;
+    backend.pak_platform_file = g_pak_platform_file;
+    backend.pak_mount         = g_real_pak_mount ? pak_mount_hook : nullptr;
+    backend.io_dispatcher     = g_io_dispatcher;
+    backend.io_mount          = g_real_io_mount ? io_mount_hook : nullptr;
+
+    p.before_mount = record_container_reads;
+    p.run(backend);
+
+    // mount = lazy: hook the class loader now rather than wait for on_unreal_init, which may
+    // already have run; without the hook the deferred containers are mounted right here
+    if (!static_load_class) {
+        resolve_static_load_class();
     }
-
-    LOG_INFO(STR("Found {} user mod folder(s)\n"), (int)mods.size());
-
-    for (size_t mod_index = 0; mod_index < mods.size(); ++mod_index) {
-        const fs::path& dir   = mods[mod_index];
-        int             order = kBaseOrder + (int)(mod_index);
-
-        LOG_INFO(STR("Mounting mod folder: {} (order {})\n"), dir.filename().wstring(), order);
-        mount_mod_folder_only_pak(dir, order);
+    install_lazy_mount_hook();
+    for (uint32_t id : p.mount_queued_external()) {
+        notify_api_mount(id);
     }
+
+    start_background_verify();
+    finish_read_order_capture_later();
 }
 
 static bool
@@ -730,6 +775,147 @@ resolve_static_load_class(void)
     return true;
 }
 
+static bool
+resolve_load_package_async(void)
+{
+    const uint8_t* target = sigscan::scan_exec(
+        GetModuleHandleW(nullptr),
+        "48 83 EC 48 48 8B 44 24 ? 48 89 44 24 ? 8B 44 24 ? 89 44 24 ? 8B 44 24 ? 89 44 24 ? 8B 44 24 ? 89 44 24 ? 48 8B 44 24 ? 48 89 44 24 ? 48 8B 0D ? ? ? ? 48 8B 01 FF 50"
+    );
+
+    if (!target) {
+        LOG_WARN(STR("LoadPackageAsync not found; ModActor classes will load at BeginPlay\n"));
+        return false;
+    }
+
+    load_package_async = reinterpret_cast<loader::LoadPackageAsyncFunc>(target);
+
+    LOG_INFO(STR("Found LoadPackageAsync at {:p}\n"), (void*)target);
+    return true;
+}
+
+// Starts an async load of every queued ModActor package, on the game thread, once the mods are
+// mounted and the engine is up
+static void
+preload_mod_actor_classes(void)
+{
+    if (g_class_preload_started || !g_user_mounted_once || !load_package_async) {
+        return;
+    }
+    g_class_preload_started = true;
+    g_class_preload_start   = std::chrono::steady_clock::now();
+
+    size_t deferred = 0;
+    for (const auto& [class_path, order] : pipeline().actor_classes()) {
+        // mount = lazy: loading the class at BeginPlay mounts its container
+        if (pipeline().deferred_until_first_use(class_path)) {
+            ++deferred;
+            continue;
+        }
+
+        std::wstring package = class_path.substr(0, class_path.find(L'.'));
+        POD::FString name(package.c_str(), static_cast<int32_t>(package.size()));
+        int32_t      request = load_package_async(name, nullptr, nullptr, POD::FLoadPackageAsyncDelegate{}, 0, -1, 0, nullptr);
+        LOG_NOTICE(STR("Preloading {} (request {})\n"), package, request);
+
+        g_class_preloads.push_back({ class_path });
+    }
+
+    g_class_preloads_pending = g_class_preloads.size();
+    if (g_class_preloads_pending || deferred) {
+        LOG_INFO(STR("Preloading {} ModActor class(es) asynchronously, {} wait for mount = lazy\n"), g_class_preloads_pending, deferred);
+    }
+}
+
+static void
+root_preloaded_classes(void)
+{
+    for (auto& p : g_class_preloads) {
+        if (p.loaded) {
+            continue;
+        }
+
+        UClass* cls = UObjectGlobals::StaticFindObject<UClass*>(nullptr, nullptr, p.class_path.c_str());
+        if (!cls || cls->HasAnyFlags(static_cast<EObjectFlags>(RF_NeedLoad | RF_NeedPostLoad))) {
+            continue;
+        }
+
+        cls->SetRootSet();
+        p.rooted = cls;
+        p.loaded = true;
+        --g_class_preloads_pending;
+    }
+
+    if (!g_class_preloads_pending) {
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - g_class_preload_start).count();
+        LOG_INFO(STR("Preloaded {} ModActor class(es) in {} ms\n"), g_class_preloads.size(), (int64_t)ms);
+    }
+}
+
+static void
+unroot_preloaded_classes(void)
+{
+    for (auto& p : g_class_preloads) {
+        if (UObject* cls = p.rooted.Get()) {
+            cls->UnsetRootSet();
+        }
+        p.rooted.Reset();
+    }
+}
+
+// starts the preloads on the first engine tick after mounting and polls them every 100 ms
+static void
+tick_class_preloads(void)
+{
+    if (!g_class_preload_started) {
+        preload_mod_actor_classes();
+        return;
+    }
+    if (!g_class_preloads_pending) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (now < g_class_preload_next_poll) {
+        return;
+    }
+    g_class_preload_next_poll = now + std::chrono::milliseconds(100);
+    root_preloaded_classes();
+}
+
+// mount = lazy: a class load from a deferred container's package mounts the container first
+static UClass* __fastcall
+static_load_class_hook(UClass* base, UObject* outer, const wchar_t* name, const wchar_t* filename, uint32_t flags)
+{
+    if (name) {
+        pipeline().mount_on_first_use(name);
+    }
+    return g_real_static_load_class(base, outer, name, filename, flags);
+}
+
+static void
+install_lazy_mount_hook(void)
+{
+    size_t pending = pipeline().pending_lazy_mounts();
+    if (!pending || g_real_static_load_class) {
+        return;
+    }
+
+    MH_STATUS s = static_load_class ? MH_CreateHook((LPVOID)static_load_class, (LPVOID)static_load_class_hook, (LPVOID*)&g_real_static_load_class)
+                                    : MH_ERROR_FUNCTION_NOT_FOUND;
+    if (s == MH_OK) {
+        s = MH_EnableHook((LPVOID)static_load_class);
+    }
+    if (s != MH_OK) {
+        LOG_WARN(STR("mount = lazy: cannot hook StaticLoadClass ({}), mounting {} deferred container(s) now\n"),
+                 widen_ascii(MH_StatusToString(s)), pending);
+        pipeline().mount_all_deferred();
+        return;
+    }
+
+    LOG_INFO(STR("mount = lazy: {} container(s) wait for their first class load\n"), pending);
+}
+
 POD::FIoStatus* __fastcall
 io_mount_hook(void* self, POD::FIoStatus* status, POD::FIoEnvironment* env, POD::FGuid* guid, POD::FAES* key)
 {
@@ -777,12 +963,43 @@ mount_all_hook(void* self, TArray<FString>* pak_folders, FString* wildcard)
 
     if (!g_user_mounted_once) {
         g_user_mounted_once = true;
+        use_engine_allocator();
         mount_all_user_mods_once();
     }
 
     return result;
 }
 
+// How each ModActor path resolved last time. A hit keeps the class through a weak reference, so
+// a class still loaded costs no lookup and a collected one costs one, with the form that worked.
+// A miss is remembered until another container is mounted.
+struct ClassResolution {
+    static constexpr int kUnresolved = -2;
+    static constexpr int kMissing    = -1;
+
+    FWeakObjectPtr cls;
+    int            form       = kUnresolved;   // index into kClassPathForms, or one of the above
+    uint32_t       generation = 0;             // pipeline().mount_generation() at the miss
+};
+
+static const wchar_t* const kClassPathForms[][2] = {
+    { L"BlueprintGeneratedClass'", L"'" },
+    { L"Class'", L"'" },
+    { L"", L"" },
+};
+
+static std::unordered_map<std::wstring, ClassResolution> g_class_cache;
+static uint32_t                                          g_class_cache_hits    = 0;
+static uint32_t                                          g_class_cache_lookups = 0;
+
+static UClass*
+load_class_form(const std::wstring& class_path, int form)
+{
+    ++g_class_cache_lookups;
+    std::wstring wrapped = kClassPathForms[form][0] + class_path + kClassPathForms[form][1];
+    return static_load_class(UObject::StaticClass(), nullptr, wrapped.c_str(), nullptr, 0);
+}
+
 static UClass*
 load_bp_actor_class(const std::wstring& class_path)
 {
@@ -790,27 +1007,35 @@ load_bp_actor_class(const std::wstring& class_path)
         return nullptr;
     }
 
-    {
-        std::wstring wrapped = L"BlueprintGeneratedClass'" + class_path + L"'";
-        UClass* c = static_load_class(UObject::StaticClass(), nullptr, wrapped.c_str(), nullptr, 0);
-        if (c) {
-            return c;
+    ClassResolution& r          = g_class_cache[class_path];
+    const uint32_t   generation = pipeline().mount_generation();
+
+    if (r.form >= 0) {
+        if (UObject* c = r.cls.Get()) {
+            ++g_class_cache_hits;
+            return static_cast<UClass*>(c);
         }
-    }
-    {
-        std::wstring wrapped = L"Class'" + class_path + L"'";
-        UClass* c = static_load_class(UObject::StaticClass(), nullptr, wrapped.c_str(), nullptr, 0);
-        if (c) {
+        if (UClass* c = load_class_form(class_path, r.form)) {
+            r.cls = c;
             return c;
         }
+    } else if (r.form == ClassResolution::kMissing && r.generation == generation) {
+        ++g_class_cache_hits;
+        return nullptr;
     }
-    {
-        UClass* c = static_load_class(UObject::StaticClass(), nullptr, class_path.c_str(), nullptr, 0);
-        if (c) {
+
+    for (int form = 0; form < (int)std::size(kClassPathForms); ++form) {
+        if (UClass* c = load_class_form(class_path, form)) {
+            r.cls  = c;
+            r.form = form;
             return c;
         }
     }
 
+    // a lookup can mount a deferred container (mount = lazy), so read the generation again
+    r.cls.Reset();
+    r.form       = ClassResolution::kMissing;
+    r.generation = pipeline().mount_generation();
     return nullptr;
 }
 
@@ -833,76 +1058,384 @@ try_spawn_mod_actor(UWorld* world, const std::wstring& bp_class_path)
 	return (spawned != nullptr);
 }
 
-static inline std::wstring
-to_lower(std::wstring s)
+// ProcessEvent listeners, the loader's and other mods' (IoStoreLoaderApi.h), behind one pre and
+// one post callback. A UFunction* is classified against the subscriptions the first time it is
+// seen and the result kept in a flat pointer map, so any later call costs one probe and one FName
+// compare (which catches a function freed and another allocated at its address) however many
+// listeners there are. Subscriptions change from any thread; the game thread picks the changes up
+// between ProcessEvent calls.
+enum class EventPhase {
+    Pre,
+    Post,
+};
+
+using EventListener = void (*)(UObject* ctx, UFunction* func, void* params, void* user);
+
+struct EventSubscription {
+    uint32_t                   id     = 0;
+    std::wstring               path;             // /Script/Engine.Actor:ReceiveBeginPlay, or a bare function name
+    EventPhase                 phase  = EventPhase::Pre;
+    EventListener              fn     = nullptr;
+    IoStoreLoaderEventCallback api_fn = nullptr;
+    void*                      user   = nullptr;
+
+    // filled in on the game thread
+    bool           by_name  = false;
+    FName          name;
+    UFunction*     resolved = nullptr;
+    FWeakObjectPtr resolved_weak;
+};
+
+struct EventFunction {
+    FName    name;
+    uint32_t listeners = 0;   // index + 1 into g_event_listeners, 0 if nothing listens
+};
+
+struct EventListeners {
+    std::vector<uint32_t> pre;    // indices into g_event_subs
+    std::vector<uint32_t> post;
+};
+
+static std::mutex                     g_event_mutex;
+static std::vector<EventSubscription> g_event_requests;   // the subscriptions as of the last change
+static uint32_t                       g_event_next_id = 1;
+static std::atomic<bool>              g_event_dirty{ false };
+
+// game thread only; neither the subscriptions nor the classifications change while a listener runs
+static std::vector<EventSubscription>        g_event_subs;
+static loader::FlatPtrMap<EventFunction>     g_event_functions(4096);
+static std::deque<EventListeners>            g_event_listeners;
+static uint32_t                              g_event_depth = 0;
+static std::chrono::steady_clock::time_point g_event_next_resolve;
+
+static uint32_t
+subscribe_event(const wchar_t* path, EventPhase phase, EventListener fn, IoStoreLoaderEventCallback api_fn, void* user)
 {
-    std::transform(s.begin(), s.end(), s.begin(), [](wchar_t c) {
-        return (wchar_t)towlower(c);
-    });
-    return s;
+    std::lock_guard<std::mutex> lock(g_event_mutex);
+    EventSubscription s;
+    s.id     = g_event_next_id++;
+    s.path   = path;
+    s.phase  = phase;
+    s.fn     = fn;
+    s.api_fn = api_fn;
+    s.user   = user;
+    g_event_requests.push_back(std::move(s));
+    g_event_dirty = true;
+    return g_event_requests.back().id;
 }
 
-static inline bool
-ends_with_icase(const std::wstring& s, const std::wstring& suffix)
+static bool
+unsubscribe_event(uint32_t id)
 {
-    if (s.size() < suffix.size()) {
+    std::lock_guard<std::mutex> lock(g_event_mutex);
+    auto it = std::find_if(g_event_requests.begin(), g_event_requests.end(), [id](const EventSubscription& s) {
+        return s.id == id;
+    });
+    if (it == g_event_requests.end()) {
         return false;
     }
+    g_event_requests.erase(it);
+    g_event_dirty = true;
+    return true;
+}
 
-    auto ls = to_lower(s);
-    auto lf = to_lower(suffix);
-    return ls.compare(ls.size() - lf.size(), lf.size(), lf) == 0;
+static void
+resolve_event_subscription(EventSubscription& s)
+{
+    s.resolved      = UObjectGlobals::StaticFindObject<UFunction*>(nullptr, nullptr, s.path.c_str());
+    s.resolved_weak = s.resolved;
+    if (s.resolved) {
+        LOG_NOTICE(STR("Resolved {} at {:p}\n"), s.path, (void*)s.resolved);
+    }
 }
 
-static inline bool
-starts_with_icase(const std::wstring& s, const std::wstring& prefix)
+// forgets every classification; functions are classified again as they are next seen
+static void
+reset_event_functions(void)
 {
-    if (s.size() < prefix.size()) {
-        return false;
+    g_event_functions.clear();
+    g_event_listeners.clear();
+}
+
+static void
+apply_event_changes(void)
+{
+    std::vector<EventSubscription> subs;
+    {
+        std::lock_guard<std::mutex> lock(g_event_mutex);
+        subs          = g_event_requests;
+        g_event_dirty = false;
+    }
+
+    for (auto& s : subs) {
+        auto old = std::find_if(g_event_subs.begin(), g_event_subs.end(), [&s](const EventSubscription& o) {
+            return o.id == s.id;
+        });
+        if (old != g_event_subs.end()) {
+            s = std::move(*old);
+            continue;
+        }
+
+        s.by_name = s.path.find(L'/') == std::wstring::npos;
+        if (s.by_name) {
+            s.name = FName(s.path.c_str(), FNAME_Add);
+        } else {
+            resolve_event_subscription(s);
+        }
     }
 
-    auto ls = to_lower(s);
-    auto lp = to_lower(prefix);
-    return ls.compare(0, lp.size(), lp) == 0;
+    g_event_subs = std::move(subs);
+    reset_event_functions();
 }
 
-static inline bool
-contains_icase(const std::wstring& s, const std::wstring& needle)
+static uint32_t
+classify_event_function(UFunction* func, FName name)
 {
-    auto ls = to_lower(s);
-    auto ln = to_lower(needle);
-    return ls.find(ln) != std::wstring::npos;
+    EventListeners l;
+    for (uint32_t i = 0; i < g_event_subs.size(); ++i) {
+        const auto& s = g_event_subs[i];
+        if (s.by_name ? s.name == name : s.resolved == func) {
+            (s.phase == EventPhase::Pre ? l.pre : l.post).push_back(i);
+        }
+    }
+
+    uint32_t listeners = 0;
+    if (!l.pre.empty() || !l.post.empty()) {
+        g_event_listeners.push_back(std::move(l));
+        listeners = static_cast<uint32_t>(g_event_listeners.size());
+    }
+    g_event_functions.insert(func, EventFunction{ name, listeners });
+    return listeners;
 }
 
 static void
-spawn_on_pc_beginplay(UObject* ctx, UFunction* func, void*)
+dispatch_event(EventPhase phase, UObject* ctx, UFunction* func, void* params)
 {
-    if (!ctx || !func) {
+    if (!g_event_depth && g_event_dirty.load(std::memory_order_relaxed)) {
+        apply_event_changes();
+    }
+    if (!func || g_event_subs.empty()) {
         return;
     }
 
-    const std::wstring obj_full  = ctx->GetFullName();   // e.g. "HbkPlayerControllerBP_C /Game/..."
-    const std::wstring func_full = func->GetFullName();  // e.g. "Function ...ReceiveBeginPlay"
+    FName          name      = func->GetNamePrivate();
+    EventFunction* known     = g_event_functions.find(func);
+    uint32_t       listeners = known && known->name == name ? known->listeners : classify_event_function(func, name);
+    if (!listeners) {
+        return;
+    }
 
-    if (!contains_icase(obj_full, L"HbkPlayerControllerBP_C")) {
+    const EventListeners& l = g_event_listeners[listeners - 1];
+    ++g_event_depth;
+    for (uint32_t i : phase == EventPhase::Pre ? l.pre : l.post) {
+        const auto& s = g_event_subs[i];
+        if (!s.by_name && s.resolved_weak.Get() != func) {
+            continue;   // unloaded since it was resolved
+        }
+        if (s.fn) {
+            s.fn(ctx, func, params, s.user);
+        } else {
+            s.api_fn(ctx, func, params, s.user);
+        }
+    }
+    --g_event_depth;
+}
+
+static void
+on_process_event_pre(UObject* ctx, UFunction* func, void* params)
+{
+    dispatch_event(EventPhase::Pre, ctx, func, params);
+}
+
+static void
+on_process_event_post(UObject* ctx, UFunction* func, void* params)
+{
+    dispatch_event(EventPhase::Post, ctx, func, params);
+}
+
+// every 250 ms, looks up path subscriptions whose function is not loaded yet or was unloaded
+static void
+tick_event_subscriptions(void)
+{
+    if (g_event_dirty.load(std::memory_order_relaxed)) {
+        apply_event_changes();
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (now < g_event_next_resolve) {
         return;
     }
+    g_event_next_resolve = now + std::chrono::milliseconds(250);
 
-    if (!ends_with_icase(func_full, L"ReceiveBeginPlay")) {
+    bool changed = false;
+    for (auto& s : g_event_subs) {
+        if (s.by_name) {
+            continue;
+        }
+        if (s.resolved && s.resolved_weak.Get() != s.resolved) {
+            LOG_NOTICE(STR("{} was unloaded\n"), s.path);
+            s.resolved = nullptr;
+            changed    = true;
+        }
+        if (!s.resolved) {
+            resolve_event_subscription(s);
+            changed |= s.resolved != nullptr;
+        }
+    }
+    if (changed) {
+        reset_event_functions();
+    }
+}
+
+// HbkPlayerControllerBP_C, matched by one FName compare on every ReceiveBeginPlay. The name is
+// checked even when the class pointer is the one seen last: a collected class's address can be
+// reused by another class. g_pc_class only records the current one for the log.
+static UClass* g_pc_class = nullptr;
+
+static bool
+is_player_controller(UObject* ctx)
+{
+    static const FName kPcClassName(STR("HbkPlayerControllerBP_C"), FNAME_Add);
+
+    UClass* cls = ctx->GetClassPrivate();
+    if (!cls || cls->GetNamePrivate() != kPcClassName) {
+        return false;
+    }
+    if (cls != g_pc_class) {
+        LOG_NOTICE(STR("Resolved HbkPlayerControllerBP_C at {:p}\n"), (void*)cls);
+        g_pc_class = cls;
+    }
+    return true;
+}
+
+static void
+disarm_spawn_listener(void)
+{
+    if (g_spawn_listener) {
+        unsubscribe_event(g_spawn_listener);
+        g_spawn_listener = 0;
+        LOG_NOTICE(STR("Spawn listener disarmed until the next world\n"));
+    }
+}
+
+// spawns this frame's share of g_spawn_queue
+static void
+drain_spawn_queue(UWorld* world)
+{
+    bool done = g_spawn_queue.drain_frame(g_spawn_budget_ms, [world](const std::wstring& class_path) {
+        bool ok = try_spawn_mod_actor(world, class_path);
+        if (ok) {
+            LOG_INFO(STR("Spawned: {}\n"), class_path);
+        }
+        return ok;
+    });
+    if (!done) {
+        return;
+    }
+
+    const auto& st = g_spawn_queue.stats();
+    LOG_INFO(STR("Spawned {} ModActor(s) over {} frame(s): {:.2f} ms in total, {:.2f} ms in the longest frame, {} failed\n"),
+             st.spawned, st.frames, st.total_ms, st.max_frame_ms, st.failed);
+    LOG_NOTICE(STR("Class cache: {} hit(s), {} StaticLoadClass call(s) so far\n"), g_class_cache_hits, g_class_cache_lookups);
+
+    // whatever the spawns loaded is found now; anything else never will be
+    if (g_class_preloads_pending) {
+        root_preloaded_classes();
+    }
+    for (const auto& p : g_class_preloads) {
+        if (!p.loaded) {
+            LOG_WARN(STR("Preload of {} did not finish before BeginPlay\n"), p.class_path);
+        }
+    }
+    g_class_preloads_pending = 0;
+    unroot_preloaded_classes();
+
+    disarm_spawn_listener();
+}
+
+static void
+start_mod_actor_spawns(UWorld* world)
+{
+    if (!g_spawn_queue.empty()) {
+        LOG_WARN(STR("PC BeginPlay again with {} ModActor(s) still queued; starting over\n"), g_spawn_queue.remaining());
+    }
+    g_spawn_world = world;
+    g_spawn_queue.reset(pipeline().actor_classes());
+    g_spawn_budget_ms = pipeline().config().spawn_budget_ms;
+    if (g_spawn_budget_ms > 0) {
+        LOG_INFO(STR("Spawning {} ModActor(s), {:.1f} ms per frame\n"), g_spawn_queue.remaining(), g_spawn_budget_ms);
+    }
+
+    drain_spawn_queue(world);
+}
+
+static void
+tick_spawn_queue(void)
+{
+    if (UObject* pc = g_spawn_retry_pc.Get()) {
+        if (UWorld* world = reinterpret_cast<AActor*>(pc)->GetWorld()) {
+            g_spawn_retry_pc.Reset();
+            start_mod_actor_spawns(world);
+        }
+        return;
+    }
+    if (g_spawn_queue.empty()) {
+        return;
+    }
+
+    auto* world = static_cast<UWorld*>(g_spawn_world.Get());
+    if (!world) {
+        LOG_WARN(STR("World went away with {} ModActor(s) left to spawn\n"), g_spawn_queue.remaining());
+        g_spawn_queue.clear();
+        return;
+    }
+    drain_spawn_queue(world);
+}
+
+// subscribed to ReceiveBeginPlay
+static void
+spawn_on_pc_beginplay(UObject* ctx, UFunction*, void*, void*)
+{
+    if (!ctx || !is_player_controller(ctx)) {
         return;
     }
 
     UWorld* world = reinterpret_cast<AActor*>(ctx)->GetWorld();
     if (!world) {
-        LOG_WARN(STR("PC BeginPlay matched but world was null; giving up (no retry)\n"));
+        LOG_WARN(STR("PC BeginPlay matched but world was null; retrying every frame\n"));
+        g_spawn_retry_pc = ctx;
         return;
     }
 
-    for (const auto& class_path : g_pending_mod_actor_classes) {
-        if (try_spawn_mod_actor(world, class_path)) {
-            LOG_INFO(STR("Spawned: {}\n"), class_path);
-        }
+    g_spawn_retry_pc.Reset();
+    start_mod_actor_spawns(world);
+}
+
+static void
+arm_spawn_listener(void)
+{
+    if (!g_spawn_listener) {
+        g_spawn_listener = subscribe_event(STR("ReceiveBeginPlay"), EventPhase::Pre, spawn_on_pc_beginplay, nullptr, nullptr);
+    }
+}
+
+// a new world is coming up; its PlayerController's BeginPlay follows
+static void
+spawn_on_init_game_state(AGameModeBase*)
+{
+    if (!g_spawn_listener) {
+        LOG_NOTICE(STR("Spawn listener re-armed for the new world\n"));
     }
+    arm_spawn_listener();
+}
+
+// the loader's per-frame work, on the game thread
+static void
+on_engine_tick(UEngine*, float)
+{
+    tick_class_preloads();
+    tick_event_subscriptions();
+    tick_spawn_queue();
 }
 
 class IOStoreLoaderMod : public RC::CppUserModBase
@@ -921,6 +1454,8 @@ public:
             return;
         }
 
+        resolve_gmalloc();
+
         if (patch_get_pak_signkey_helper() &&
             install_mount_all_hook() &&
             install_pak_mount_hook() &&
@@ -931,15 +1466,32 @@ public:
 
     ~IOStoreLoaderMod() override
     {
+        g_verify_cancel = true;
+        if (g_verify_thread.joinable()) {
+            g_verify_thread.join();
+        }
+        g_record_cancel = true;
+        if (g_record_thread.joinable()) {
+            g_record_thread.join();
+        }
+        pipeline().log_still_deferred();
         MH_Uninitialize();
     }
 
     auto on_unreal_init() -> void override
     {
-        resolve_static_load_class();
+        if (!static_load_class) {
+            resolve_static_load_class();
+        }
+        install_lazy_mount_hook();
         if (!g_spawn_hook_installed) {
             g_spawn_hook_installed = true;
-            Hook::RegisterProcessEventPreCallback(spawn_on_pc_beginplay);
+            resolve_load_package_async();
+            Hook::RegisterProcessEventPreCallback(on_process_event_pre);
+            Hook::RegisterProcessEventPostCallback(on_process_event_post);
+            Hook::RegisterEngineTickPreCallback(on_engine_tick);
+            Hook::RegisterInitGameStatePreCallback(spawn_on_init_game_state);
+            arm_spawn_listener();
             LOG_INFO(STR("Installed ProcessEvent PC BeginPlay listener\n"));
         }
     }
@@ -957,4 +1509,142 @@ extern "C"
     {
         delete mod;
     }
+
+    // IoStoreLoaderApi.h
+    MOD_API uint32_t iostore_loader_api_version(void)
+    {
+        return IOSTORE_LOADER_API_VERSION;
+    }
+
+    MOD_API int32_t iostore_loader_on_mounted(int32_t id, IoStoreLoaderMountCallback callback, void* user)
+    {
+        loader::MountRecord r;
+        if (!callback) {
+            return IOSTORE_LOADER_E_INVALID_ARG;
+        }
+        if (id <= 0 || !pipeline().find_record((uint32_t)id, r)) {
+            return IOSTORE_LOADER_E_NOT_FOUND;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(g_api_mutex);
+            g_api_callbacks[id] = { callback, user };
+        }
+        notify_api_mount((uint32_t)id);
+        return IOSTORE_LOADER_OK;
+    }
+
+    MOD_API int32_t iostore_loader_mount(const wchar_t* path, int32_t order, IoStoreLoaderMountCallback callback, void* user)
+    {
+        if (!path || !*path) {
+            return IOSTORE_LOADER_E_INVALID_ARG;
+        }
+
+        std::string err;
+        uint32_t    id = pipeline().mount_external(fs::path(path), order, err);
+        if (!id) {
+            LOG_WARN(STR("Refusing API mount of {}: {}\n"), path, widen_ascii(err));
+            return IOSTORE_LOADER_E_BAD_CONTAINER;
+        }
+
+        if (callback) {
+            iostore_loader_on_mounted((int32_t)id, callback, user);
+        }
+        return (int32_t)id;
+    }
+
+    MOD_API int32_t iostore_loader_get_mount(int32_t id, IoStoreLoaderMountInfo* out)
+    {
+        if (!out || out->struct_size < IOSTORE_LOADER_MOUNT_INFO_V1_SIZE) {
+            return IOSTORE_LOADER_E_INVALID_ARG;
+        }
+
+        loader::MountRecord r;
+        if (id <= 0 || !pipeline().find_record((uint32_t)id, r)) {
+            return IOSTORE_LOADER_E_NOT_FOUND;
+        }
+
+        // a caller built against an older header gets the part of the struct it knows
+        IoStoreLoaderMountInfo info{};
+        fill_mount_info(r, info);
+        info.struct_size = std::min<uint32_t>(out->struct_size, sizeof(info));
+        std::memcpy(out, &info, info.struct_size);
+        return IOSTORE_LOADER_OK;
+    }
+
+    MOD_API int32_t iostore_loader_enum_mounts(IoStoreLoaderEnumCallback callback, void* user)
+    {
+        if (!callback) {
+            return IOSTORE_LOADER_E_INVALID_ARG;
+        }
+
+        int32_t n = 0;
+        for (const auto& r : pipeline().records()) {
+            IoStoreLoaderMountInfo info{};
+            info.struct_size = sizeof(info);
+            fill_mount_info(r, info);
+            ++n;
+            if (callback(&info, user)) {
+                break;
+            }
+        }
+        return n;
+    }
+
+    MOD_API int32_t iostore_loader_enum_resident(IoStoreLoaderResidentCallback callback, void* user)
+    {
+        if (!callback) {
+            return IOSTORE_LOADER_E_INVALID_ARG;
+        }
+
+        loader::ResidentLedger ledger = pipeline().resident();
+
+        auto fill = [](const std::wstring& mod, const loader::ResidentCost& c, uint32_t containers) {
+            IoStoreLoaderResidentInfo info{};
+            info.struct_size         = sizeof(info);
+            info.open_handles        = c.open_handles;
+            info.containers          = containers;
+            info.total               = c.total();
+            info.chunk_map           = c.chunk_map;
+            info.compression_blocks  = c.compression_blocks;
+            info.block_signatures    = c.block_signatures;
+            info.compression_methods = c.compression_methods;
+            info.directory_index     = c.directory_index;
+            info.package_store       = c.package_store;
+            info.partitions          = c.partitions;
+            info.pak_index           = c.pak_index;
+            wcsncpy(info.mod_name, mod.c_str(), std::size(info.mod_name) - 1);
+            return info;
+        };
+
+        IoStoreLoaderResidentInfo total = fill(std::wstring(), ledger.total(), (uint32_t)ledger.entries().size());
+        if (callback(&total, user)) {
+            return (int32_t)ledger.mods().size();
+        }
+        for (const auto& [mod, cost] : ledger.largest_mods(ledger.mods().size())) {
+            uint32_t containers = (uint32_t)std::count_if(ledger.entries().begin(), ledger.entries().end(),
+                                                          [&mod](const auto& e) { return e.mod_name == mod; });
+            IoStoreLoaderResidentInfo info = fill(mod, cost, containers);
+            if (callback(&info, user)) {
+                break;
+            }
+        }
+        return (int32_t)ledger.mods().size();
+    }
+
+    MOD_API int32_t iostore_loader_subscribe_event(const wchar_t* function_path, int32_t phase, IoStoreLoaderEventCallback callback, void* user)
+    {
+        if (!function_path || !*function_path || !callback ||
+            (phase != IOSTORE_LOADER_EVENT_PRE && phase != IOSTORE_LOADER_EVENT_POST)) {
+            return IOSTORE_LOADER_E_INVALID_ARG;
+        }
+
+        EventPhase p = phase == IOSTORE_LOADER_EVENT_POST ? EventPhase::Post : EventPhase::Pre;
+        return static_cast<int32_t>(subscribe_event(function_path, p, nullptr, callback, user));
+    }
+
+    MOD_API int32_t iostore_loader_unsubscribe_event(int32_t id)
+    {
+        return id > 0 && unsubscribe_event(static_cast<uint32_t>(id)) ? IOSTORE_LOADER_OK : IOSTORE_LOADER_E_NOT_FOUND;
+    }
 }
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define LOADER_AES_X64 1
+#include <wmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define LOADER_AESNI_TARGET
+#else
+#include <cpuid.h>
+#define LOADER_AESNI_TARGET __attribute__((target("aes,sse2")))
+#endif
+#endif
+
+namespace loader
+{
+    namespace aes_detail
+    {
+        struct Tables {
+            uint8_t sbox[256] = {};
+            uint8_t inv[256]  = {};
+        };
+
+        constexpr uint8_t
+        xtime(uint8_t x)
+        {
+            return (uint8_t)((x << 1) ^ ((x & 0x80) ? 0x1B : 0));
+        }
+
+        constexpr uint8_t
+        rotl8(uint8_t x, int n)
+        {
+            return (uint8_t)((x << n) | (x >> (8 - n)));
+        }
+
+        // S-box from walking GF(2^8) with generator 3 and its inverse together
+        constexpr Tables
+        make_tables()
+        {
+            Tables  t;
+            uint8_t p = 1, q = 1;
+            do {
+                p = (uint8_t)(p ^ xtime(p));
+                q ^= (uint8_t)(q << 1);
+                q ^= (uint8_t)(q << 2);
+                q ^= (uint8_t)(q << 4);
+                if (q & 0x80) {
+                    q ^= 0x09;
+                }
+                t.sbox[p] = (uint8_t)(q ^ rotl8(q, 1) ^ rotl8(q, 2) ^ rotl8(q, 3) ^ rotl8(q, 4) ^ 0x63);
+            } while (p != 1);
+            t.sbox[0] = 0x63;
+
+            for (int i = 0; i < 256; ++i) {
+                t.inv[t.sbox[i]] = (uint8_t)i;
+            }
+            return t;
+        }
+
+        inline constexpr Tables kTables = make_tables();
+    }
+
+    // AES-256 decryption in ECB mode, what FAES::DecryptData does to IoStore blocks and
+    // directory indices. Uses AES-NI when the CPU has it, a portable byte-wise cipher otherwise.
+    class Aes256Decryptor
+    {
+    public:
+        static constexpr size_t kKeySize   = 32;
+        static constexpr size_t kBlockSize = 16;
+        static constexpr int    kRounds    = 14;
+
+        explicit Aes256Decryptor(const uint8_t* key)
+        {
+            expand_key(key);
+        }
+
+        // `len` must be a multiple of kBlockSize
+        void
+        decrypt(uint8_t* data, size_t len) const
+        {
+#ifdef LOADER_AES_X64
+            if (has_aesni()) {
+                decrypt_aesni(data, len);
+                return;
+            }
+#endif
+            for (size_t at = 0; at + kBlockSize <= len; at += kBlockSize) {
+                decrypt_block(data + at);
+            }
+        }
+
+        static bool
+        has_aesni()
+        {
+#ifdef LOADER_AES_X64
+            static const bool yes = []() {
+#if defined(_MSC_VER)
+                int r[4] = {};
+                __cpuid(r, 1);
+                return (r[2] & (1 << 25)) != 0;
+#else
+                unsigned a = 0, b = 0, c = 0, d = 0;
+                return __get_cpuid(1, &a, &b, &c, &d) && (c & bit_AES) != 0;
+#endif
+            }();
+            return yes;
+#else
+            return false;
+#endif
+        }
+
+    private:
+        void
+        expand_key(const uint8_t* key)
+        {
+            using aes_detail::kTables;
+
+            uint8_t* w = &m_rk[0][0];
+            std::memcpy(w, key, kKeySize);
+
+            uint8_t rcon = 1;
+            for (int i = 8; i < 4 * (kRounds + 1); ++i) {
+                uint8_t t[4];
+                std::memcpy(t, w + (i - 1) * 4, 4);
+                if (i % 8 == 0) {
+                    uint8_t t0 = t[0];
+                    t[0] = (uint8_t)(kTables.sbox[t[1]] ^ rcon);
+                    t[1] = kTables.sbox[t[2]];
+                    t[2] = kTables.sbox[t[3]];
+                    t[3] = kTables.sbox[t0];
+                    rcon = aes_detail::xtime(rcon);
+                } else if (i % 8 == 4) {
+                    for (uint8_t& b : t) {
+                        b = kTables.sbox[b];
+                    }
+                }
+                for (int k = 0; k < 4; ++k) {
+                    w[i * 4 + k] = (uint8_t)(w[(i - 8) * 4 + k] ^ t[k]);
+                }
+            }
+        }
+
+        void
+        decrypt_block(uint8_t* s) const
+        {
+            using aes_detail::kTables;
+            using aes_detail::xtime;
+
+            auto add_key = [&](int round) {
+                for (int i = 0; i < 16; ++i) {
+                    s[i] ^= m_rk[round][i];
+                }
+            };
+            // state is column-major: byte r + 4c; row r is rotated right by r
+            auto inv_shift_sub = [&]() {
+                uint8_t t[16];
+                for (int c = 0; c < 4; ++c) {
+                    for (int r = 0; r < 4; ++r) {
+                        t[r + 4 * ((c + r) % 4)] = kTables.inv[s[r + 4 * c]];
+                    }
+                }
+                std::memcpy(s, t, 16);
+            };
+
+            add_key(kRounds);
+            for (int round = kRounds - 1; round > 0; --round) {
+                inv_shift_sub();
+                add_key(round);
+                // InvMixColumns as a pre-step that turns it into MixColumns
+                for (int c = 0; c < 4; ++c) {
+                    uint8_t* col = s + 4 * c;
+                    uint8_t  u   = xtime(xtime((uint8_t)(col[0] ^ col[2])));
+                    uint8_t  v   = xtime(xtime((uint8_t)(col[1] ^ col[3])));
+                    col[0] ^= u;
+                    col[1] ^= v;
+                    col[2] ^= u;
+                    col[3] ^= v;
+
+                    uint8_t a0 = col[0], t = (uint8_t)(col[0] ^ col[1] ^ col[2] ^ col[3]);
+                    col[0] ^= (uint8_t)(t ^ xtime((uint8_t)(col[0] ^ col[1])));
+                    col[1] ^= (uint8_t)(t ^ xtime((uint8_t)(col[1] ^ col[2])));
+                    col[2] ^= (uint8_t)(t ^ xtime((uint8_t)(col[2] ^ col[3])));
+                    col[3] ^= (uint8_t)(t ^ xtime((uint8_t)(col[3] ^ a0)));
+                }
+            }
+            inv_shift_sub();
+            add_key(0);
+        }
+
+#ifdef LOADER_AES_X64
+        // Equivalent inverse cipher, four blocks at a time to keep the AESDEC pipeline full
+        LOADER_AESNI_TARGET void
+        decrypt_aesni(uint8_t* data, size_t len) const
+        {
+            __m128i dk[kRounds + 1];
+            dk[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_rk[kRounds]));
+            for (int i = 1; i < kRounds; ++i) {
+                dk[i] = _mm_aesimc_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(m_rk[kRounds - i])));
+            }
+            dk[kRounds] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_rk[0]));
+
+            size_t at = 0;
+            for (; at + 4 * kBlockSize <= len; at += 4 * kBlockSize) {
+                __m128i* p  = reinterpret_cast<__m128i*>(data + at);
+                __m128i  b0 = _mm_xor_si128(_mm_loadu_si128(p + 0), dk[0]);
+                __m128i  b1 = _mm_xor_si128(_mm_loadu_si128(p + 1), dk[0]);
+                __m128i  b2 = _mm_xor_si128(_mm_loadu_si128(p + 2), dk[0]);
+                __m128i  b3 = _mm_xor_si128(_mm_loadu_si128(p + 3), dk[0]);
+                for (int i = 1; i < kRounds; ++i) {
+                    b0 = _mm_aesdec_si128(b0, dk[i]);
+                    b1 = _mm_aesdec_si128(b1, dk[i]);
+                    b2 = _mm_aesdec_si128(b2, dk[i]);
+                    b3 = _mm_aesdec_si128(b3, dk[i]);
+                }
+                _mm_storeu_si128(p + 0, _mm_aesdeclast_si128(b0, dk[kRounds]));
+                _mm_storeu_si128(p + 1, _mm_aesdeclast_si128(b1, dk[kRounds]));
+                _mm_storeu_si128(p + 2, _mm_aesdeclast_si128(b2, dk[kRounds]));
+                _mm_storeu_si128(p + 3, _mm_aesdeclast_si128(b3, dk[kRounds]));
+            }
+            for (; at + kBlockSize <= len; at += kBlockSize) {
+                __m128i* p = reinterpret_cast<__m128i*>(data + at);
+                __m128i  b = _mm_xor_si128(_mm_loadu_si128(p), dk[0]);
+                for (int i = 1; i < kRounds; ++i) {
+                    b = _mm_aesdec_si128(b, dk[i]);
+                }
+                _mm_storeu_si128(p, _mm_aesdeclast_si128(b, dk[kRounds]));
+            }
+        }
+#endif
+
+        uint8_t m_rk[kRounds + 1][kBlockSize] = {};   // encryption round keys
+    };
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "inflate.hpp"
+#include "lz4.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace loader
+{
+    static inline uint32_t
+    adler32(const uint8_t* p, size_t n)
+    {
+        uint32_t a = 1, b = 0;
+        while (n) {
+            size_t k = (std::min)(n, (size_t)5552);
+            n -= k;
+            while (k--) {
+                a += *p++;
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+        return (b << 16) | a;
+    }
+
+    // whether decode_block() handles blocks compressed with `method`
+    static inline bool
+    block_method_supported(std::string_view method)
+    {
+        return method == "None" || method == "Zlib" || method == "zlib" || method == "LZ4";
+    }
+
+    // Decodes one IoStore compression block into exactly `dst_len` bytes. `method` is the
+    // container's method name ("None" for method index 0). UE's Zlib blocks are zlib streams
+    // (RFC 1950: header, deflate data, Adler-32), not raw deflate.
+    static inline bool
+    decode_block(std::string_view method, const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_len, const char** err)
+    {
+        const char* e = nullptr;
+
+        if (method == "None") {
+            if (src_len < dst_len) {
+                e = "stored block shorter than its uncompressed size";
+            } else {
+                std::memcpy(dst, src, dst_len);
+            }
+        } else if (method == "Zlib" || method == "zlib") {
+            if (src_len < 6 || (src[0] & 0x0F) != 8 || ((src[0] << 8) | src[1]) % 31 != 0 || (src[1] & 0x20)) {
+                e = "bad zlib header";
+            } else {
+                size_t        n = 0;
+                InflateStatus s = inflate_raw(src + 2, src_len - 6, dst, dst_len, &n);
+                if (s != InflateStatus::Ok) {
+                    e = inflate_status_str(s);
+                } else if (n != dst_len) {
+                    e = "zlib block decoded to the wrong size";
+                } else {
+                    const uint8_t* t = src + src_len - 4;
+                    uint32_t       want = ((uint32_t)t[0] << 24) | ((uint32_t)t[1] << 16) | ((uint32_t)t[2] << 8) | t[3];
+                    if (adler32(dst, dst_len) != want) {
+                        e = "zlib block checksum mismatch";
+                    }
+                }
+            }
+        } else if (method == "LZ4") {
+            int64_t n = lz4_decode_block(src, src_len, dst, dst_len);
+            if (n < 0) {
+                e = "corrupt lz4 block";
+            } else if ((size_t)n != dst_len) {
+                e = "lz4 block decoded to the wrong size";
+            }
+        } else {
+            e = "unsupported compression method";
+        }
+
+        if (err) {
+            *err = e;
+        }
+        return e == nullptr;
+    }
+}
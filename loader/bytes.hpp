@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace loader
+{
+    // unaligned little-endian loads from mapped file data
+    static inline uint16_t rd_le16(const uint8_t* p) { uint16_t v; std::memcpy(&v, p, 2); return v; }
+    static inline uint32_t rd_le32(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+    static inline uint64_t rd_le64(const uint8_t* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+
+    // 40-bit big-endian field, as used by FIoOffsetAndLength
+    static inline uint64_t
+    rd_be40(const uint8_t* p)
+    {
+        return ((uint64_t)p[0] << 32) | ((uint64_t)p[1] << 24) | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 8) | (uint64_t)p[4];
+    }
+
+    // Serialized FString: int32 length including the terminator, negative for UTF-16.
+    // Points into the source buffer; decode with append_utf8().
+    struct FStringView {
+        const uint8_t* data  = nullptr;
+        uint32_t       chars = 0;      // without the terminator
+        bool           wide  = false;
+
+        void
+        append_utf8(std::string& out) const
+        {
+            if (!wide) {
+                out.append(reinterpret_cast<const char*>(data), chars);
+                return;
+            }
+
+            for (uint32_t i = 0; i < chars; ++i) {
+                uint32_t c = rd_le16(data + i * 2);
+                if (c >= 0xD800 && c < 0xDC00 && i + 1 < chars) {
+                    uint32_t lo = rd_le16(data + (i + 1) * 2);
+                    if (lo >= 0xDC00 && lo < 0xE000) {
+                        c = 0x10000 + ((c - 0xD800) << 10) + (lo - 0xDC00);
+                        ++i;
+                    }
+                }
+
+                if (c < 0x80) {
+                    out.push_back((char)c);
+                } else if (c < 0x800) {
+                    out.push_back((char)(0xC0 | (c >> 6)));
+                    out.push_back((char)(0x80 | (c & 0x3F)));
+                } else if (c < 0x10000) {
+                    out.push_back((char)(0xE0 | (c >> 12)));
+                    out.push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+                    out.push_back((char)(0x80 | (c & 0x3F)));
+                } else {
+                    out.push_back((char)(0xF0 | (c >> 18)));
+                    out.push_back((char)(0x80 | ((c >> 12) & 0x3F)));
+                    out.push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+                    out.push_back((char)(0x80 | (c & 0x3F)));
+                }
+            }
+        }
+
+        std::string
+        utf8() const
+        {
+            std::string s;
+            append_utf8(s);
+            return s;
+        }
+    };
+
+    // reads an FString at `*p`, advancing it; false if it runs past `end` or is malformed
+    static inline bool
+    read_fstring(const uint8_t*& p, const uint8_t* end, FStringView& out)
+    {
+        if (end - p < 4) {
+            return false;
+        }
+
+        int32_t n = (int32_t)rd_le32(p);
+        p += 4;
+
+        out = FStringView{};
+        if (n == 0) {
+            return true;
+        }
+
+        bool     wide  = n < 0;
+        uint64_t count = wide ? (uint64_t)(-(int64_t)n) : (uint64_t)n;
+        uint64_t bytes = count * (wide ? 2 : 1);
+        if ((uint64_t)(end - p) < bytes) {
+            return false;
+        }
+
+        out.data  = p;
+        out.chars = (uint32_t)(count - 1);
+        out.wide  = wide;
+        p += bytes;
+        return true;
+    }
+}
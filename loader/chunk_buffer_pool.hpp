@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace loader
+{
+    // Recycled chunk buffers: acquire() hands out a buffer that keeps the capacity it grew to in
+    // earlier reads, so steady-state chunk reads do not allocate. Thread-safe; the pool must
+    // outlive its leases.
+    class ChunkBufferPool
+    {
+    public:
+        class Lease
+        {
+        public:
+            Lease() = default;
+
+            Lease(ChunkBufferPool* pool, std::vector<uint8_t>&& buffer)
+                : m_pool(pool)
+                , m_buffer(std::move(buffer))
+            {
+            }
+
+            Lease(const Lease&) = delete;
+            Lease& operator=(const Lease&) = delete;
+
+            Lease(Lease&& other) noexcept
+                : m_pool(std::exchange(other.m_pool, nullptr))
+                , m_buffer(std::move(other.m_buffer))
+            {
+            }
+
+            Lease&
+            operator=(Lease&& other) noexcept
+            {
+                if (this != &other) {
+                    release();
+                    m_pool   = std::exchange(other.m_pool, nullptr);
+                    m_buffer = std::move(other.m_buffer);
+                }
+                return *this;
+            }
+
+            ~Lease() { release(); }
+
+            explicit operator bool() const { return m_pool != nullptr; }
+
+            std::vector<uint8_t>& buffer() { return m_buffer; }
+
+            // hands the buffer back to the pool
+            void
+            release()
+            {
+                if (m_pool) {
+                    m_pool->give_back(std::move(m_buffer));
+                    m_pool = nullptr;
+                }
+                m_buffer = std::vector<uint8_t>{};
+            }
+
+        private:
+            ChunkBufferPool*     m_pool = nullptr;
+            std::vector<uint8_t> m_buffer;
+        };
+
+        // at most `max_idle` buffers are kept between leases; the rest are freed on return
+        explicit ChunkBufferPool(size_t max_idle = 64)
+            : m_max_idle(max_idle)
+        {
+        }
+
+        ChunkBufferPool(const ChunkBufferPool&) = delete;
+        ChunkBufferPool& operator=(const ChunkBufferPool&) = delete;
+
+        Lease
+        acquire()
+        {
+            std::vector<uint8_t> buffer;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_idle.empty()) {
+                    buffer = std::move(m_idle.back());
+                    m_idle.pop_back();
+                }
+            }
+            return Lease(this, std::move(buffer));
+        }
+
+        size_t
+        idle() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_idle.size();
+        }
+
+    private:
+        void
+        give_back(std::vector<uint8_t>&& buffer)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_idle.size() < m_max_idle && buffer.capacity()) {
+                m_idle.push_back(std::move(buffer));
+            }
+        }
+
+        mutable std::mutex                m_mutex;
+        std::vector<std::vector<uint8_t>> m_idle;
+        size_t                            m_max_idle;
+    };
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace loader
+{
+    namespace fs = std::filesystem;
+
+    // how .ucas contents are checked against their TOC hashes (see ucas_verify.hpp)
+    enum class VerifyMode {
+        Off,          // only the TOC/partition size checks done before every mount
+        Background,   // verify after all mods are mounted, on a worker thread, and log the results
+        Block,        // verify each container before mounting it and reject corrupt ones
+    };
+
+    // when mod IoStore containers are handed to the engine (see lazy_mount.hpp)
+    enum class MountMode {
+        Eager,   // all of them while the game mounts its own paks
+        Lazy,    // those that qualify only when one of their packages is first loaded
+    };
+
+    // Mods/IoStoreLoaderMod/config.ini: `key = value` lines, '#' or ';' comments, [sections]
+    // ignored. Unknown keys and bad values are reported and leave the default in place.
+    struct LoaderConfig {
+        VerifyMode verify          = VerifyMode::Off;
+        uint32_t   record_reads    = 0;     // seconds of mod .ucas reads to record into read_order.bin, 0 = off
+        MountMode  mount           = MountMode::Eager;
+        double     spawn_budget_ms = 4.0;   // per frame for ModActor spawns, 0 = all in one frame
+        bool       overrides       = false; // write overrides.txt after mounting
+    };
+
+    namespace config_detail
+    {
+        static inline std::string_view
+        trim(std::string_view s)
+        {
+            while (!s.empty() && std::isspace((unsigned char)s.front())) {
+                s.remove_prefix(1);
+            }
+            while (!s.empty() && std::isspace((unsigned char)s.back())) {
+                s.remove_suffix(1);
+            }
+            return s;
+        }
+
+        static inline std::string
+        lower(std::string_view s)
+        {
+            std::string out(s);
+            for (char& c : out) {
+                c = (char)std::tolower((unsigned char)c);
+            }
+            return out;
+        }
+    }
+
+    static inline void
+    parse_loader_config(std::string_view text, LoaderConfig& out, std::vector<std::string>& warnings)
+    {
+        using namespace config_detail;
+
+        int line_no = 0;
+        while (!text.empty()) {
+            size_t           nl   = text.find('\n');
+            std::string_view line = text.substr(0, nl);
+            text.remove_prefix(nl == std::string_view::npos ? text.size() : nl + 1);
+            ++line_no;
+
+            line = trim(line);
+            if (line.empty() || line[0] == '#' || line[0] == ';' || line[0] == '[') {
+                continue;
+            }
+
+            size_t eq = line.find('=');
+            if (eq == std::string_view::npos) {
+                warnings.push_back("line " + std::to_string(line_no) + ": expected key = value");
+                continue;
+            }
+
+            std::string key   = lower(trim(line.substr(0, eq)));
+            std::string value = lower(trim(line.substr(eq + 1)));
+
+            if (key == "verify") {
+                if (value == "off") {
+                    out.verify = VerifyMode::Off;
+                } else if (value == "background") {
+                    out.verify = VerifyMode::Background;
+                } else if (value == "block") {
+                    out.verify = VerifyMode::Block;
+                } else {
+                    warnings.push_back("line " + std::to_string(line_no) + ": verify must be off, background or block");
+                }
+            } else if (key == "record_reads") {
+                char*         end = nullptr;
+                unsigned long n   = std::strtoul(value.c_str(), &end, 10);
+                if (value == "off") {
+                    out.record_reads = 0;
+                } else if (!value.empty() && *end == '\0' && n <= 24 * 3600) {
+                    out.record_reads = (uint32_t)n;
+                } else {
+                    warnings.push_back("line " + std::to_string(line_no) + ": record_reads must be off or a number of seconds");
+                }
+            } else if (key == "spawn_budget_ms") {
+                char*  end = nullptr;
+                double ms  = std::strtod(value.c_str(), &end);
+                if (value == "off") {
+                    out.spawn_budget_ms = 0;
+                } else if (!value.empty() && *end == '\0' && ms >= 0 && ms <= 1000) {
+                    out.spawn_budget_ms = ms;
+                } else {
+                    warnings.push_back("line " + std::to_string(line_no) + ": spawn_budget_ms must be off or a number of milliseconds");
+                }
+            } else if (key == "overrides") {
+                if (value == "off") {
+                    out.overrides = false;
+                } else if (value == "on") {
+                    out.overrides = true;
+                } else {
+                    warnings.push_back("line " + std::to_string(line_no) + ": overrides must be off or on");
+                }
+            } else if (key == "mount") {
+                if (value == "eager") {
+                    out.mount = MountMode::Eager;
+                } else if (value == "lazy") {
+                    out.mount = MountMode::Lazy;
+                } else {
+                    warnings.push_back("line " + std::to_string(line_no) + ": mount must be eager or lazy");
+                }
+            } else {
+                warnings.push_back("line " + std::to_string(line_no) + ": unknown key '" + key + "'");
+            }
+        }
+    }
+
+    // a missing file gives the defaults
+    static inline LoaderConfig
+    load_loader_config(const fs::path& path, std::vector<std::string>& warnings)
+    {
+        LoaderConfig  cfg;
+        std::ifstream in(path, std::ios::binary);
+        if (in) {
+            std::stringstream ss;
+            ss << in.rdbuf();
+            parse_loader_config(ss.str(), cfg, warnings);
+        }
+        return cfg;
+    }
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include "bytes.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace loader
+{
+    // UE 4.27 FContainerHeader, the payload of a container's ContainerHeader chunk: the package
+    // ids the container provides and one FPackageStoreEntry per package.
+
+    static constexpr size_t kPackageStoreEntrySize = 32;
+
+    struct PackageStoreEntry {
+        uint64_t              export_bundles_size = 0;
+        int32_t               export_count        = 0;
+        int32_t               export_bundle_count = 0;
+        uint32_t              load_order          = 0;
+        uint32_t              pad                 = 0;
+        std::vector<uint64_t> imported_packages;
+    };
+
+    using PackageIdPair = std::pair<uint64_t, uint64_t>;
+
+    struct ContainerHeader {
+        uint64_t                       container_id = 0;
+        std::vector<uint8_t>           names;          // name batch, kept opaque
+        std::vector<uint8_t>           name_hashes;
+        std::vector<uint64_t>          package_ids;
+        std::vector<PackageStoreEntry> store_entries;  // parallel to package_ids
+        std::vector<std::pair<std::string, std::vector<PackageIdPair>>> culture_package_map;
+        std::vector<PackageIdPair>     package_redirects;
+    };
+
+    namespace container_header_detail
+    {
+        struct Reader {
+            const uint8_t* p;
+            const uint8_t* end;
+            bool           ok = true;
+
+            bool
+            need(uint64_t n)
+            {
+                ok = ok && (uint64_t)(end - p) >= n;
+                return ok;
+            }
+
+            uint32_t u32() { if (!need(4)) return 0; uint32_t v = rd_le32(p); p += 4; return v; }
+            uint64_t u64() { if (!need(8)) return 0; uint64_t v = rd_le64(p); p += 8; return v; }
+
+            // TArray<T>: int32 count, then count elements of `elem` bytes
+            const uint8_t*
+            array(uint32_t elem, uint32_t& count)
+            {
+                int32_t n = (int32_t)u32();
+                if (!ok || n < 0 || !need((uint64_t)n * elem)) {
+                    ok = false;
+                    return nullptr;
+                }
+
+                const uint8_t* data = p;
+                count = (uint32_t)n;
+                p += (size_t)n * elem;
+                return data;
+            }
+
+            void
+            pairs(std::vector<PackageIdPair>& out)
+            {
+                uint32_t       n = 0;
+                const uint8_t* d = array(16, n);
+                for (uint32_t i = 0; ok && i < n; ++i) {
+                    out.emplace_back(rd_le64(d + i * 16), rd_le64(d + i * 16 + 8));
+                }
+            }
+        };
+
+        struct Writer {
+            std::vector<uint8_t>& out;
+
+            void u32(uint32_t v) { uint8_t b[4]; std::memcpy(b, &v, 4); out.insert(out.end(), b, b + 4); }
+            void u64(uint64_t v) { uint8_t b[8]; std::memcpy(b, &v, 8); out.insert(out.end(), b, b + 8); }
+
+            void
+            bytes(const std::vector<uint8_t>& v)
+            {
+                u32((uint32_t)v.size());
+                out.insert(out.end(), v.begin(), v.end());
+            }
+
+            void
+            pairs(const std::vector<PackageIdPair>& v)
+            {
+                u32((uint32_t)v.size());
+                for (const auto& pr : v) {
+                    u64(pr.first);
+                    u64(pr.second);
+                }
+            }
+
+            void
+            fstring(const std::string& s)
+            {
+                if (s.empty()) {
+                    u32(0);
+                    return;
+                }
+                u32((uint32_t)s.size() + 1);
+                out.insert(out.end(), s.begin(), s.end());
+                out.push_back(0);
+            }
+        };
+    }
+
+    static inline bool
+    parse_container_header(const uint8_t* data, size_t size, ContainerHeader& out, std::string& err)
+    {
+        using container_header_detail::Reader;
+
+        out = ContainerHeader{};
+        Reader r{ data, data + size };
+
+        out.container_id       = r.u64();
+        uint32_t package_count = r.u32();
+
+        uint32_t n = 0;
+        const uint8_t* names = r.array(1, n);
+        if (r.ok) {
+            out.names.assign(names, names + n);
+        }
+        const uint8_t* hashes = r.array(1, n);
+        if (r.ok) {
+            out.name_hashes.assign(hashes, hashes + n);
+        }
+
+        const uint8_t* ids = r.array(8, n);
+        if (!r.ok || n != package_count) {
+            err = "container header package id table is truncated or does not match the package count";
+            return false;
+        }
+        out.package_ids.resize(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            out.package_ids[i] = rd_le64(ids + (size_t)i * 8);
+        }
+
+        uint32_t       store_size = 0;
+        const uint8_t* store      = r.array(1, store_size);
+        if (!r.ok || (uint64_t)package_count * kPackageStoreEntrySize > store_size) {
+            err = "container header store entries are truncated";
+            return false;
+        }
+
+        out.store_entries.resize(package_count);
+        for (uint32_t i = 0; i < package_count; ++i) {
+            const uint8_t* e  = store + (size_t)i * kPackageStoreEntrySize;
+            auto&          se = out.store_entries[i];
+            se.export_bundles_size = rd_le64(e);
+            se.export_count        = (int32_t)rd_le32(e + 8);
+            se.export_bundle_count = (int32_t)rd_le32(e + 12);
+            se.load_order          = rd_le32(e + 16);
+            se.pad                 = rd_le32(e + 20);
+
+            // TFilePackageStoreEntryCArrayView: count, then offset from this field to the data
+            uint32_t count = rd_le32(e + 24);
+            uint64_t at    = (uint64_t)i * kPackageStoreEntrySize + 24 + rd_le32(e + 28);
+            if (count && (at > store_size || (uint64_t)count * 8 > store_size - at)) {
+                err = "container header import list out of bounds";
+                return false;
+            }
+
+            se.imported_packages.resize(count);
+            for (uint32_t k = 0; k < count; ++k) {
+                se.imported_packages[k] = rd_le64(store + at + (size_t)k * 8);
+            }
+        }
+
+        int32_t cultures = (int32_t)r.u32();
+        for (int32_t c = 0; r.ok && c >= 0 && c < cultures; ++c) {
+            FStringView name;
+            if (!read_fstring(r.p, r.end, name)) {
+                r.ok = false;
+                break;
+            }
+            out.culture_package_map.emplace_back(name.utf8(), std::vector<PackageIdPair>{});
+            r.pairs(out.culture_package_map.back().second);
+        }
+
+        r.pairs(out.package_redirects);
+
+        if (!r.ok || cultures < 0) {
+            err = "container header truncated";
+            return false;
+        }
+        return true;
+    }
+
+    static inline std::vector<uint8_t>
+    serialize_container_header(const ContainerHeader& h)
+    {
+        using container_header_detail::Writer;
+
+        std::vector<uint8_t> out;
+        Writer w{ out };
+
+        w.u64(h.container_id);
+        w.u32((uint32_t)h.package_ids.size());
+        w.bytes(h.names);
+        w.bytes(h.name_hashes);
+
+        w.u32((uint32_t)h.package_ids.size());
+        for (uint64_t id : h.package_ids) {
+            w.u64(id);
+        }
+
+        // entries first, import lists packed after them
+        std::vector<uint8_t> store(h.store_entries.size() * kPackageStoreEntrySize);
+        for (size_t i = 0; i < h.store_entries.size(); ++i) {
+            const auto& se = h.store_entries[i];
+            uint8_t*    e  = store.data() + i * kPackageStoreEntrySize;
+
+            uint32_t count  = (uint32_t)se.imported_packages.size();
+            uint32_t offset = count ? (uint32_t)(store.size() - (i * kPackageStoreEntrySize + 24)) : 0;
+
+            std::memcpy(e, &se.export_bundles_size, 8);
+            std::memcpy(e + 8, &se.export_count, 4);
+            std::memcpy(e + 12, &se.export_bundle_count, 4);
+            std::memcpy(e + 16, &se.load_order, 4);
+            std::memcpy(e + 20, &se.pad, 4);
+            std::memcpy(e + 24, &count, 4);
+            std::memcpy(e + 28, &offset, 4);
+
+            for (uint64_t id : se.imported_packages) {
+                uint8_t b[8];
+                std::memcpy(b, &id, 8);
+                store.insert(store.end(), b, b + 8);
+            }
+        }
+        w.bytes(store);
+
+        w.u32((uint32_t)h.culture_package_map.size());
+        for (const auto& c : h.culture_package_map) {
+            w.fstring(c.first);
+            w.pairs(c.second);
+        }
+        w.pairs(h.package_redirects);
+        return out;
+    }
+}
@@ -0,0 +1,341 @@
+#pragma once
+
+#include "mod_discovery.hpp"
+#include "parallel.hpp"
+#include "xxhash64.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace loader
+{
+    struct FileStamp {
+        uint64_t size  = 0;
+        int64_t  mtime = 0;
+
+        bool operator==(const FileStamp& o) const { return size == o.size && mtime == o.mtime; }
+    };
+
+    static inline bool
+    stat_file(const fs::path& p, FileStamp& out)
+    {
+        std::error_code ec;
+
+        out.size = fs::file_size(p, ec);
+        if (ec) {
+            return false;
+        }
+
+        out.mtime = fs::last_write_time(p, ec).time_since_epoch().count();
+        return !ec;
+    }
+
+    static inline std::string
+    path_to_utf8(const fs::path& p)
+    {
+        auto u8 = p.generic_u8string();
+        return std::string(u8.begin(), u8.end());
+    }
+
+    static inline fs::path
+    path_from_utf8(const std::string& s)
+    {
+        return fs::path(std::u8string(s.begin(), s.end()));
+    }
+
+    static inline bool
+    hash_file(const fs::path& p, uint64_t& out)
+    {
+        std::ifstream in(p, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+
+        // one uninitialized buffer per thread, reused for every file that thread hashes
+        constexpr size_t kBufSize = 1 << 20;
+        thread_local std::unique_ptr<char[]> buf(new char[kBufSize]);
+
+        XXH64 h;
+        while (in) {
+            in.read(buf.get(), (std::streamsize)kBufSize);
+            std::streamsize got = in.gcount();
+            if (got <= 0) {
+                break;
+            }
+            h.update(buf.get(), (size_t)got);
+        }
+
+        if (in.bad()) {
+            return false;
+        }
+
+        out = h.digest();
+        return true;
+    }
+
+    // file hash cache keyed by path, validated by size + mtime
+    class HashCache
+    {
+    public:
+        bool
+        load(const fs::path& file)
+        {
+            std::ifstream in(file, std::ios::binary);
+            if (!in) {
+                return false;
+            }
+
+            std::string line;
+            if (!std::getline(in, line) || line != kHeader) {
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(m_lock);
+            while (std::getline(in, line)) {
+                // <hash> <size> <mtime> <path>
+                const char* s   = line.c_str();
+                char*       end = nullptr;
+
+                Entry e;
+                e.hash = std::strtoull(s, &end, 16);
+                if (end == s || *end != ' ') {
+                    continue;
+                }
+
+                s = end + 1;
+                e.stamp.size = std::strtoull(s, &end, 10);
+                if (end == s || *end != ' ') {
+                    continue;
+                }
+
+                s = end + 1;
+                e.stamp.mtime = std::strtoll(s, &end, 10);
+                if (end == s || *end != ' ') {
+                    continue;
+                }
+
+                fs::path p = path_from_utf8(std::string(end + 1));
+                m_entries[p.native()] = e;
+            }
+            return true;
+        }
+
+        // writes back only the entries looked up or stored since load, so removed mods age out
+        bool
+        save(const fs::path& file) const
+        {
+            fs::path tmp = file;
+            tmp += L".tmp";
+
+            {
+                std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+                if (!out) {
+                    return false;
+                }
+
+                out << kHeader << '\n';
+
+                std::lock_guard<std::mutex> lock(m_lock);
+                char prefix[64];
+                for (const auto& [key, e] : m_entries) {
+                    if (!e.used) {
+                        continue;
+                    }
+
+                    std::snprintf(prefix, sizeof(prefix), "%016llx %llu %lld ",
+                                  (unsigned long long)e.hash, (unsigned long long)e.stamp.size, (long long)e.stamp.mtime);
+                    out << prefix << path_to_utf8(fs::path(key)) << '\n';
+                }
+
+                if (!out) {
+                    return false;
+                }
+            }
+
+            std::error_code ec;
+            fs::rename(tmp, file, ec);
+            return !ec;
+        }
+
+        bool
+        lookup(const fs::path& p, const FileStamp& stamp, uint64_t& out_hash)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+
+            auto it = m_entries.find(p.native());
+            if (it == m_entries.end() || !(it->second.stamp == stamp)) {
+                return false;
+            }
+
+            it->second.used = true;
+            out_hash = it->second.hash;
+            return true;
+        }
+
+        void
+        store(const fs::path& p, const FileStamp& stamp, uint64_t hash)
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_entries[p.native()] = Entry{ stamp, hash, true };
+        }
+
+    private:
+        static constexpr const char* kHeader = "IoStoreLoaderHashCache 1";
+
+        struct Entry {
+            FileStamp stamp;
+            uint64_t  hash = 0;
+            bool      used = false;
+        };
+
+        mutable std::mutex                                   m_lock;
+        std::unordered_map<fs::path::string_type, Entry>     m_entries;
+    };
+
+    struct HashStats {
+        size_t   files        = 0;
+        size_t   cached       = 0;
+        size_t   failed       = 0;
+        uint64_t bytes_hashed = 0;
+    };
+
+    static inline bool
+    hash_file_cached(const fs::path& p, HashCache& cache, uint64_t& out, bool* out_from_cache = nullptr, uint64_t* out_size = nullptr)
+    {
+        FileStamp stamp;
+        if (!stat_file(p, stamp)) {
+            return false;
+        }
+
+        if (out_size) {
+            *out_size = stamp.size;
+        }
+
+        if (cache.lookup(p, stamp, out)) {
+            if (out_from_cache) {
+                *out_from_cache = true;
+            }
+            return true;
+        }
+
+        if (out_from_cache) {
+            *out_from_cache = false;
+        }
+
+        if (!hash_file(p, out)) {
+            return false;
+        }
+
+        cache.store(p, stamp, out);
+        return true;
+    }
+
+    struct DuplicateContainer {
+        size_t skipped; // index into the plan
+        size_t kept;
+    };
+
+    // Hashes the files of every container in `plan` in parallel and marks all but the highest-order
+    // copy of byte-identical containers as skipped. Containers with unreadable files are never deduplicated.
+    // The key covers contents only, so a skipped copy may have another name; anything derived from the
+    // name (ModActors, .actors sidecars) has to be carried over to the kept copy by the caller.
+    static inline std::vector<DuplicateContainer>
+    dedupe_mount_plan(std::vector<MountEntry>& plan, HashCache& cache, HashStats* stats = nullptr)
+    {
+        struct FileJob {
+            size_t   entry;
+            fs::path path;
+            uint64_t hash = 0;
+            bool     ok   = false;
+        };
+
+        std::vector<FileJob> jobs;
+        for (size_t i = 0; i < plan.size(); ++i) {
+            if (plan[i].skip) {
+                continue;
+            }
+
+            for (auto& f : container_files(plan[i])) {
+                jobs.push_back(FileJob{ i, std::move(f) });
+            }
+        }
+
+        std::atomic<size_t>   n_cached{ 0 };
+        std::atomic<uint64_t> n_bytes{ 0 };
+
+        parallel_for(jobs.size(), [&](size_t i) {
+            bool     from_cache = false;
+            uint64_t size       = 0;
+
+            jobs[i].ok = hash_file_cached(jobs[i].path, cache, jobs[i].hash, &from_cache, &size);
+            if (from_cache) {
+                n_cached.fetch_add(1, std::memory_order_relaxed);
+            } else if (jobs[i].ok) {
+                n_bytes.fetch_add(size, std::memory_order_relaxed);
+            }
+        });
+
+        // container key: hash over (extension, file hash) of each component in container_files() order
+        std::vector<XXH64> keys(plan.size());
+        std::vector<bool>  valid(plan.size(), false);
+        size_t n_failed = 0;
+
+        for (size_t i = 0; i < plan.size(); ++i) {
+            valid[i] = !plan[i].skip;
+        }
+
+        for (const auto& j : jobs) {
+            if (!j.ok) {
+                valid[j.entry] = false;
+                ++n_failed;
+                continue;
+            }
+
+            std::wstring ext = j.path.extension().wstring();
+            keys[j.entry].update(ext.data(), ext.size() * sizeof(wchar_t));
+            keys[j.entry].update(&j.hash, sizeof(j.hash));
+        }
+
+        // key -> index of the highest-order copy
+        std::unordered_map<uint64_t, size_t> winners;
+        for (size_t i = 0; i < plan.size(); ++i) {
+            if (!valid[i]) {
+                continue;
+            }
+
+            auto [it, inserted] = winners.emplace(keys[i].digest(), i);
+            if (!inserted && plan[i].order >= plan[it->second].order) {
+                it->second = i;
+            }
+        }
+
+        std::vector<DuplicateContainer> dups;
+        for (size_t i = 0; i < plan.size(); ++i) {
+            if (!valid[i]) {
+                continue;
+            }
+
+            size_t kept = winners[keys[i].digest()];
+            if (kept != i) {
+                plan[i].skip = true;
+                dups.push_back(DuplicateContainer{ i, kept });
+            }
+        }
+
+        if (stats) {
+            stats->files        = jobs.size();
+            stats->cached       = n_cached.load();
+            stats->failed       = n_failed;
+            stats->bytes_hashed = n_bytes.load();
+        }
+        return dups;
+    }
+}
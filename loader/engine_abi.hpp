@@ -0,0 +1,222 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#if defined(_WIN32)
+#define LOADER_FASTCALL __fastcall
+#else
+#define LOADER_FASTCALL
+#endif
+
+namespace loader
+{
+    // Where POD::FString buffers come from: the CRT heap until the mod points this at the
+    // engine's GMalloc (before it builds any string), after which the engine may free or grow a
+    // string the loader built
+    struct FStringAllocator {
+        void* (*alloc)(size_t bytes) = nullptr;   // null: std::malloc / std::free
+        void  (*free)(void* p)       = nullptr;
+    };
+
+    inline FStringAllocator&
+    fstring_allocator()
+    {
+        static FStringAllocator a;
+        return a;
+    }
+
+    // Engine structs the mount functions take, laid out as UE 4.27 Win64 has them
+    namespace POD
+    {
+        enum class EIoErrorCode {
+            Ok,
+            Unknown,
+            InvalidCode,
+            Cancelled,
+            FileOpenFailed,
+            FileNotOpen,
+            ReadError,
+            WriteError,
+            NotFound,
+            CorruptToc,
+            UnknownChunkID,
+            InvalidParameter,
+            SignatureError,
+            InvalidEncryptionKey,
+        };
+
+        struct FIoStatus {
+            EIoErrorCode ErrorCode;
+            wchar_t      ErrorMessage[128];
+        };
+
+        template <typename T>
+        struct TArray
+        {
+            T* Data;
+            int32_t Num;
+            int32_t Max;
+        };
+
+        struct FString
+        {
+            TArray<wchar_t> Data{ nullptr, 0, 0 };
+
+            FString() = default;
+            FString(const wchar_t* src, int32_t len, int32_t slack = 0)
+            {
+                const int32_t capacity = len + 1 + slack;
+
+                wchar_t* buffer = static_cast<wchar_t*>(allocate(sizeof(wchar_t) * capacity));
+                if (!buffer) {
+                    Data = {};
+                    return;
+                }
+
+                std::memcpy(buffer, src, sizeof(wchar_t) * len);
+                buffer[len] = L'\0';
+
+                Data.Data = buffer;
+                Data.Num = len + 1;
+                Data.Max = capacity;
+            }
+
+            ~FString()
+            {
+                if (Data.Data) {
+                    release(Data.Data);
+                    Data = {};
+                }
+            }
+
+            // disable copy
+            FString(const FString&) = delete;
+            FString& operator=(const FString&) = delete;
+
+            // allow move
+            FString(FString&& other) noexcept
+            {
+                Data = other.Data;
+                other.Data = {};
+            }
+
+            FString& operator=(FString&& other) noexcept
+            {
+                if (this != &other) {
+                    if (Data.Data) {
+                        release(Data.Data);
+                    }
+                    Data = other.Data;
+                    other.Data = {};
+                }
+                return *this;
+            }
+
+        private:
+            static void*
+            allocate(size_t bytes)
+            {
+                const FStringAllocator& a = fstring_allocator();
+                return a.alloc ? a.alloc(bytes) : std::malloc(bytes);
+            }
+
+            static void
+            release(void* p)
+            {
+                const FStringAllocator& a = fstring_allocator();
+                if (a.free) {
+                    a.free(p);
+                } else {
+                    std::free(p);
+                }
+            }
+        };
+
+        struct FIoEnvironment {
+            FString Path;
+            int32_t   Order = 0;
+
+            // lives in the engine struct's tail padding, which the engine never reads
+            bool      BorrowedPath = false;
+
+            FIoEnvironment(const std::wstring& path, int order)
+                : Path(path.c_str(), static_cast<int32_t>(path.size())), Order(order)
+            {
+            }
+
+            // points Path at a null-terminated string owned by the caller (e.g. a GamePathArena);
+            // the engine only reads the environment during the Mount call
+            FIoEnvironment(std::wstring_view path, int order)
+                : Order(order), BorrowedPath(true)
+            {
+                Path.Data.Data = const_cast<wchar_t*>(path.data());
+                Path.Data.Num  = static_cast<int32_t>(path.size()) + 1;
+                Path.Data.Max  = Path.Data.Num;
+            }
+
+            ~FIoEnvironment()
+            {
+                if (BorrowedPath) {
+                    Path.Data = {};
+                }
+            }
+
+            FIoEnvironment(const FIoEnvironment&) = delete;
+            FIoEnvironment& operator=(const FIoEnvironment&) = delete;
+        };
+
+        static_assert(offsetof(FIoEnvironment, Order) == 16 && sizeof(FIoEnvironment) == 24,
+                      "FIoEnvironment must match FIoStoreEnvironment");
+
+        struct FGuid {
+            uint32_t A;
+            uint32_t B;
+            uint32_t C;
+            uint32_t D;
+        };
+
+        struct FAES {
+            uint8_t Key[32];
+        };
+
+        // TDelegate with FHeapAllocator storage; all zero is an unbound delegate, which the
+        // engine's destructor leaves alone
+        struct FLoadPackageAsyncDelegate {
+            void*   Allocation   = nullptr;
+            int32_t DelegateSize = 0;
+        };
+
+        static_assert(sizeof(FLoadPackageAsyncDelegate) == 16, "FLoadPackageAsyncDelegate must match TDelegate");
+
+        // FMalloc's vtable; FExec's destructor and Exec come first
+        struct FMalloc;
+
+        struct FMallocVtbl {
+            void* Destructor;
+            void* Exec;
+            void* (LOADER_FASTCALL* Malloc)(FMalloc* self, size_t count, uint32_t alignment);
+            void* TryMalloc;
+            void* (LOADER_FASTCALL* Realloc)(FMalloc* self, void* original, size_t count, uint32_t alignment);
+            void* TryRealloc;
+            void  (LOADER_FASTCALL* Free)(FMalloc* self, void* original);
+        };
+
+        struct FMalloc {
+            const FMallocVtbl* Vtbl;
+        };
+    }
+
+    using FIoDispatcherMountFunc    = POD::FIoStatus* (LOADER_FASTCALL*)(void* self, POD::FIoStatus* status, POD::FIoEnvironment* env, POD::FGuid* guid, POD::FAES* key);
+    using FPakPlatformFileMountFunc = bool (LOADER_FASTCALL*)(void* self, const wchar_t* pak_filename, int pak_order, const wchar_t* path, bool load_index);
+
+    // ::LoadPackageAsync(InName, InGuid, InPackageToLoadFrom, InCompletionDelegate, InPackageFlags,
+    // InPIEInstanceID, InPackagePriority, InstancingContext); returns the request id
+    using LoadPackageAsyncFunc = int32_t (LOADER_FASTCALL*)(const POD::FString& name, const POD::FGuid* guid, const wchar_t* package_to_load_from,
+                                                            POD::FLoadPackageAsyncDelegate completion, uint32_t package_flags,
+                                                            int32_t pie_instance_id, int32_t priority, const void* instancing_context);
+}
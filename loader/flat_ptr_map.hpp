@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace loader
+{
+    // Open-addressing map from a pointer to V: linear probing in one flat array, kept at most half
+    // full, so a lookup is a multiply and usually one or two adjacent slots. Keys must not be null.
+    // Not thread-safe.
+    template <typename V>
+    class FlatPtrMap
+    {
+    public:
+        explicit FlatPtrMap(size_t capacity = 64)
+        {
+            size_t n = 16;
+            while (n < capacity * 2) {
+                n *= 2;
+            }
+            reset(n);
+        }
+
+        V*
+        find(const void* key)
+        {
+            for (size_t i = slot_of(key);; i = (i + 1) & m_mask) {
+                Slot& s = m_slots[i];
+                if (s.key == key) {
+                    return &s.value;
+                }
+                if (!s.key) {
+                    return nullptr;
+                }
+            }
+        }
+
+        // inserts or replaces
+        V&
+        insert(const void* key, V value)
+        {
+            if ((m_count + 1) * 2 > m_slots.size()) {
+                grow();
+            }
+
+            size_t i = slot_of(key);
+            while (m_slots[i].key && m_slots[i].key != key) {
+                i = (i + 1) & m_mask;
+            }
+            if (!m_slots[i].key) {
+                m_slots[i].key = key;
+                ++m_count;
+            }
+            m_slots[i].value = std::move(value);
+            return m_slots[i].value;
+        }
+
+        bool
+        erase(const void* key)
+        {
+            size_t i = slot_of(key);
+            while (m_slots[i].key != key) {
+                if (!m_slots[i].key) {
+                    return false;
+                }
+                i = (i + 1) & m_mask;
+            }
+
+            // backward-shift the rest of the run so no tombstones are needed
+            for (size_t j = (i + 1) & m_mask; m_slots[j].key; j = (j + 1) & m_mask) {
+                size_t home = slot_of(m_slots[j].key);
+                if (((j - home) & m_mask) >= ((j - i) & m_mask)) {
+                    m_slots[i] = std::move(m_slots[j]);
+                    i          = j;
+                }
+            }
+            m_slots[i] = Slot{};
+            --m_count;
+            return true;
+        }
+
+        template <typename F>
+        void
+        for_each(F&& f)
+        {
+            for (Slot& s : m_slots) {
+                if (s.key) {
+                    f(s.key, s.value);
+                }
+            }
+        }
+
+        void
+        clear()
+        {
+            reset(m_slots.size());
+        }
+
+        size_t size()     const { return m_count; }
+        size_t capacity() const { return m_slots.size(); }
+
+    private:
+        struct Slot {
+            const void* key = nullptr;
+            V           value{};
+        };
+
+        size_t
+        slot_of(const void* key) const
+        {
+            uint64_t h = (uint64_t)(uintptr_t)key * 0x9E3779B97F4A7C15ull;
+            return (size_t)(h >> m_shift);
+        }
+
+        void
+        reset(size_t n)
+        {
+            m_slots.assign(n, Slot{});
+            m_mask  = n - 1;
+            m_count = 0;
+            m_shift = 64;
+            for (size_t b = n; b > 1; b >>= 1) {
+                --m_shift;
+            }
+        }
+
+        void
+        grow()
+        {
+            std::vector<Slot> old = std::move(m_slots);
+            reset(old.size() * 2);
+            for (Slot& s : old) {
+                if (s.key) {
+                    insert(s.key, std::move(s.value));
+                }
+            }
+        }
+
+        std::vector<Slot> m_slots;
+        size_t            m_mask  = 0;
+        size_t            m_count = 0;
+        unsigned          m_shift = 64;
+    };
+}
@@ -0,0 +1,553 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+namespace loader
+{
+    // raw DEFLATE (RFC 1951) decoder, used for zip entries and zlib-compressed blocks
+
+    enum class InflateStatus {
+        Ok,
+        Truncated,   // input ended before the final block
+        Corrupt,     // invalid block type, code lengths or back-reference
+        OutputFull,  // flat output buffer too small
+        SinkFailed,  // streaming sink rejected a write
+    };
+
+    static inline const char*
+    inflate_status_str(InflateStatus s)
+    {
+        switch (s) {
+        case InflateStatus::Ok:         return "ok";
+        case InflateStatus::Truncated:  return "truncated deflate stream";
+        case InflateStatus::Corrupt:    return "corrupt deflate stream";
+        case InflateStatus::OutputFull: return "output larger than expected";
+        case InflateStatus::SinkFailed: return "write failed";
+        }
+        return "unknown";
+    }
+
+    namespace inflate_detail
+    {
+        struct BitReader {
+            const uint8_t* begin;
+            const uint8_t* p;
+            const uint8_t* end;
+            uint64_t       buf = 0;
+            unsigned       cnt = 0;
+            size_t         pad = 0; // zero bytes fed past the end of input
+
+            BitReader(const uint8_t* src, size_t len) : begin(src), p(src), end(src + len) {}
+
+            void
+            refill()
+            {
+                while (cnt <= 56) {
+                    uint64_t b = 0;
+                    if (p < end) {
+                        b = *p++;
+                    } else {
+                        ++pad;
+                    }
+                    buf |= b << cnt;
+                    cnt += 8;
+                }
+            }
+
+            uint32_t
+            peek(unsigned n)
+            {
+                if (cnt < n) {
+                    refill();
+                }
+                return (uint32_t)(buf & ((1ull << n) - 1));
+            }
+
+            void
+            drop(unsigned n)
+            {
+                buf >>= n;
+                cnt  -= n;
+            }
+
+            uint32_t
+            bits(unsigned n)
+            {
+                uint32_t v = peek(n);
+                drop(n);
+                return v;
+            }
+
+            // true once bits past the end of input have been consumed
+            bool
+            overrun() const
+            {
+                return pad * 8 > cnt;
+            }
+
+            size_t
+            consumed() const
+            {
+                return (size_t)(p - begin) + pad - cnt / 8;
+            }
+        };
+
+        struct Huffman {
+            static constexpr unsigned kFastBits = 10;
+
+            uint16_t count[16]{};
+            uint16_t symbol[288]{};
+            uint16_t fast[1u << kFastBits]{}; // (length << 12) | symbol, 0 = slow path
+
+            bool
+            build(const uint8_t* lengths, unsigned n)
+            {
+                std::memset(count, 0, sizeof(count));
+                std::memset(fast, 0, sizeof(fast));
+
+                for (unsigned i = 0; i < n; ++i) {
+                    ++count[lengths[i]];
+                }
+
+                int left = 1;
+                for (unsigned len = 1; len <= 15; ++len) {
+                    left <<= 1;
+                    left  -= count[len];
+                    if (left < 0) {
+                        return false; // over-subscribed
+                    }
+                }
+
+                uint16_t offs[16]{};
+                for (unsigned len = 1; len < 15; ++len) {
+                    offs[len + 1] = offs[len] + count[len];
+                }
+
+                for (unsigned i = 0; i < n; ++i) {
+                    if (lengths[i]) {
+                        symbol[offs[lengths[i]]++] = (uint16_t)i;
+                    }
+                }
+
+                // canonical codes, bit-reversed for LSB-first lookup
+                uint32_t code = 0;
+                uint32_t next[16]{};
+                count[0] = 0;
+                for (unsigned len = 1; len <= 15; ++len) {
+                    code      = (code + count[len - 1]) << 1;
+                    next[len] = code;
+                }
+
+                for (unsigned i = 0; i < n; ++i) {
+                    unsigned len = lengths[i];
+                    if (len == 0 || len > kFastBits) {
+                        continue;
+                    }
+
+                    uint32_t c   = next[len]++;
+                    uint32_t rev = 0;
+                    for (unsigned b = 0; b < len; ++b) {
+                        rev |= ((c >> b) & 1u) << (len - 1 - b);
+                    }
+
+                    for (uint32_t k = rev; k < (1u << kFastBits); k += (1u << len)) {
+                        fast[k] = (uint16_t)((len << 12) | i);
+                    }
+                }
+                return true;
+            }
+
+            int
+            decode(BitReader& br) const
+            {
+                uint16_t e = fast[br.peek(kFastBits)];
+                if (e) {
+                    br.drop(e >> 12);
+                    return e & 0xFFF;
+                }
+
+                int code  = 0;
+                int first = 0;
+                int index = 0;
+                for (unsigned len = 1; len <= 15; ++len) {
+                    code |= (int)br.bits(1);
+                    int c = count[len];
+                    if (code - c < first) {
+                        return symbol[index + (code - first)];
+                    }
+                    index += c;
+                    first += c;
+                    first <<= 1;
+                    code  <<= 1;
+                }
+                return -1;
+            }
+        };
+
+        static constexpr uint16_t kLenBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                                   35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static constexpr uint8_t  kLenExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                                    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        static constexpr uint16_t kDistBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                                                    193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                                    6145, 8193, 12289, 16385, 24577 };
+        static constexpr uint8_t  kDistExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                                     7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+        template <typename Out>
+        static InflateStatus
+        codes(BitReader& br, Out& out, const Huffman& lit, const Huffman& dist)
+        {
+            for (;;) {
+                int sym = lit.decode(br);
+                if (sym < 0) {
+                    return br.overrun() ? InflateStatus::Truncated : InflateStatus::Corrupt;
+                }
+
+                if (sym < 256) {
+                    if (br.overrun()) {
+                        return InflateStatus::Truncated;
+                    }
+                    if (!out.put((uint8_t)sym)) {
+                        return out.status();
+                    }
+                    continue;
+                }
+
+                if (sym == 256) {
+                    return br.overrun() ? InflateStatus::Truncated : InflateStatus::Ok;
+                }
+
+                sym -= 257;
+                if (sym >= 29) {
+                    return InflateStatus::Corrupt;
+                }
+                size_t len = kLenBase[sym] + br.bits(kLenExtra[sym]);
+
+                int dsym = dist.decode(br);
+                if (dsym < 0 || dsym >= 30) {
+                    return br.overrun() ? InflateStatus::Truncated : InflateStatus::Corrupt;
+                }
+                size_t d = kDistBase[dsym] + br.bits(kDistExtra[dsym]);
+
+                if (br.overrun()) {
+                    return InflateStatus::Truncated;
+                }
+                if (!out.copy(d, len)) {
+                    return out.status();
+                }
+            }
+        }
+
+        template <typename Out>
+        static InflateStatus
+        stored(BitReader& br, Out& out)
+        {
+            br.drop(br.cnt & 7);
+
+            uint32_t len  = br.bits(16);
+            uint32_t nlen = br.bits(16);
+            if (br.overrun()) {
+                return InflateStatus::Truncated;
+            }
+            if (len != (~nlen & 0xFFFF)) {
+                return InflateStatus::Corrupt;
+            }
+
+            while (len && br.cnt >= 8) {
+                if (!out.put((uint8_t)br.bits(8))) {
+                    return out.status();
+                }
+                --len;
+            }
+
+            if (br.overrun()) {
+                return InflateStatus::Truncated;
+            }
+
+            if (len) {
+                // bit buffer drained: the rest is a straight copy from the input
+                if ((size_t)(br.end - br.p) < len || br.pad) {
+                    return InflateStatus::Truncated;
+                }
+                if (!out.write(br.p, len)) {
+                    return out.status();
+                }
+                br.p += len;
+            }
+            return InflateStatus::Ok;
+        }
+
+        template <typename Out>
+        static InflateStatus
+        run(const uint8_t* src, size_t src_len, Out& out, size_t* out_consumed)
+        {
+            static const uint8_t kOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+            BitReader br(src, src_len);
+
+            Huffman lit;
+            Huffman dist;
+
+            bool last = false;
+            while (!last) {
+                last = br.bits(1) != 0;
+                uint32_t type = br.bits(2);
+
+                InflateStatus s;
+                if (type == 0) {
+                    s = stored(br, out);
+                } else if (type == 1) {
+                    uint8_t lengths[288 + 30];
+                    unsigned i = 0;
+                    for (; i < 144; ++i) lengths[i] = 8;
+                    for (; i < 256; ++i) lengths[i] = 9;
+                    for (; i < 280; ++i) lengths[i] = 7;
+                    for (; i < 288; ++i) lengths[i] = 8;
+                    for (; i < 288 + 30; ++i) lengths[i] = 5;
+
+                    lit.build(lengths, 288);
+                    dist.build(lengths + 288, 30);
+                    s = codes(br, out, lit, dist);
+                } else if (type == 2) {
+                    unsigned n_lit  = br.bits(5) + 257;
+                    unsigned n_dist = br.bits(5) + 1;
+                    unsigned n_code = br.bits(4) + 4;
+                    if (n_lit > 286 || n_dist > 30) {
+                        return InflateStatus::Corrupt;
+                    }
+
+                    uint8_t lengths[288 + 32]{};
+                    for (unsigned i = 0; i < n_code; ++i) {
+                        lengths[kOrder[i]] = (uint8_t)br.bits(3);
+                    }
+
+                    Huffman lencode;
+                    if (!lencode.build(lengths, 19)) {
+                        return InflateStatus::Corrupt;
+                    }
+
+                    std::memset(lengths, 0, sizeof(lengths));
+                    unsigned idx = 0;
+                    while (idx < n_lit + n_dist) {
+                        int sym = lencode.decode(br);
+                        if (sym < 0 || br.overrun()) {
+                            return br.overrun() ? InflateStatus::Truncated : InflateStatus::Corrupt;
+                        }
+
+                        if (sym < 16) {
+                            lengths[idx++] = (uint8_t)sym;
+                            continue;
+                        }
+
+                        uint8_t  value  = 0;
+                        unsigned repeat = 0;
+                        if (sym == 16) {
+                            if (idx == 0) {
+                                return InflateStatus::Corrupt;
+                            }
+                            value  = lengths[idx - 1];
+                            repeat = 3 + br.bits(2);
+                        } else if (sym == 17) {
+                            repeat = 3 + br.bits(3);
+                        } else {
+                            repeat = 11 + br.bits(7);
+                        }
+
+                        if (idx + repeat > n_lit + n_dist) {
+                            return InflateStatus::Corrupt;
+                        }
+                        while (repeat--) {
+                            lengths[idx++] = value;
+                        }
+                    }
+
+                    if (lengths[256] == 0) {
+                        return InflateStatus::Corrupt;
+                    }
+                    if (!lit.build(lengths, n_lit) || !dist.build(lengths + n_lit, n_dist)) {
+                        return InflateStatus::Corrupt;
+                    }
+                    s = codes(br, out, lit, dist);
+                } else {
+                    return InflateStatus::Corrupt;
+                }
+
+                if (s != InflateStatus::Ok) {
+                    return s;
+                }
+            }
+
+            if (out_consumed) {
+                *out_consumed = br.consumed();
+            }
+            return InflateStatus::Ok;
+        }
+    }
+
+    // decodes into a caller-provided buffer
+    struct FlatInflateOutput {
+        uint8_t*      dst;
+        size_t        cap;
+        size_t        pos = 0;
+        InflateStatus err = InflateStatus::Ok;
+
+        InflateStatus status() const { return err; }
+
+        bool
+        put(uint8_t b)
+        {
+            if (pos >= cap) {
+                err = InflateStatus::OutputFull;
+                return false;
+            }
+            dst[pos++] = b;
+            return true;
+        }
+
+        bool
+        write(const uint8_t* p, size_t n)
+        {
+            if (cap - pos < n) {
+                err = InflateStatus::OutputFull;
+                return false;
+            }
+            std::memcpy(dst + pos, p, n);
+            pos += n;
+            return true;
+        }
+
+        bool
+        copy(size_t dist, size_t len)
+        {
+            if (dist > pos) {
+                err = InflateStatus::Corrupt;
+                return false;
+            }
+            if (cap - pos < len) {
+                err = InflateStatus::OutputFull;
+                return false;
+            }
+
+            uint8_t*       d = dst + pos;
+            const uint8_t* s = d - dist;
+            if (dist >= len) {
+                std::memcpy(d, s, len);
+            } else {
+                for (size_t i = 0; i < len; ++i) {
+                    d[i] = s[i];
+                }
+            }
+            pos += len;
+            return true;
+        }
+    };
+
+    // decodes through a 64 KiB window, handing finished output to sink(const uint8_t*, size_t) -> bool
+    template <typename Sink>
+    struct StreamInflateOutput {
+        static constexpr size_t kWindow = 1u << 16;
+        static constexpr size_t kMask   = kWindow - 1;
+        static constexpr size_t kFlush  = 1u << 15;
+
+        Sink&                sink;
+        std::vector<uint8_t> win = std::vector<uint8_t>(kWindow);
+        uint64_t             pos     = 0;
+        uint64_t             flushed = 0;
+        InflateStatus        err     = InflateStatus::Ok;
+
+        explicit StreamInflateOutput(Sink& s) : sink(s) {}
+
+        InflateStatus status() const { return err; }
+
+        bool
+        flush()
+        {
+            while (flushed < pos) {
+                size_t at = (size_t)(flushed & kMask);
+                size_t n  = (size_t)(std::min<uint64_t>)(pos - flushed, kWindow - at);
+                if (!sink(win.data() + at, n)) {
+                    err = InflateStatus::SinkFailed;
+                    return false;
+                }
+                flushed += n;
+            }
+            return true;
+        }
+
+        bool
+        put(uint8_t b)
+        {
+            win[(size_t)(pos++ & kMask)] = b;
+            return (pos - flushed < kFlush) || flush();
+        }
+
+        bool
+        write(const uint8_t* p, size_t n)
+        {
+            while (n) {
+                size_t at    = (size_t)(pos & kMask);
+                size_t chunk = (std::min)(n, (std::min)(kWindow - at, kFlush));
+                std::memcpy(win.data() + at, p, chunk);
+                pos += chunk;
+                p   += chunk;
+                n   -= chunk;
+                if (pos - flushed >= kFlush && !flush()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool
+        copy(size_t dist, size_t len)
+        {
+            if (dist > pos || dist > 32768) {
+                err = InflateStatus::Corrupt;
+                return false;
+            }
+
+            for (size_t i = 0; i < len; ++i) {
+                uint8_t b = win[(size_t)((pos - dist) & kMask)];
+                if (!put(b)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    // inflates a raw deflate stream into dst; on success *out_len is the decoded size
+    static inline InflateStatus
+    inflate_raw(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_cap, size_t* out_len = nullptr)
+    {
+        FlatInflateOutput out{ dst, dst_cap };
+        InflateStatus     s = inflate_detail::run(src, src_len, out, nullptr);
+        if (out_len) {
+            *out_len = out.pos;
+        }
+        return s;
+    }
+
+    // inflates a raw deflate stream, passing decoded data to sink(const uint8_t*, size_t) -> bool in order
+    template <typename Sink>
+    static inline InflateStatus
+    inflate_raw_stream(const uint8_t* src, size_t src_len, Sink&& sink, uint64_t* out_len = nullptr)
+    {
+        StreamInflateOutput<std::remove_reference_t<Sink>> out(sink);
+
+        InflateStatus s = inflate_detail::run(src, src_len, out, nullptr);
+        if (s == InflateStatus::Ok && !out.flush()) {
+            s = out.status();
+        }
+        if (out_len) {
+            *out_len = out.pos;
+        }
+        return s;
+    }
+}
@@ -0,0 +1,264 @@
+#pragma once
+
+#include "block_codec.hpp"
+#include "chunk_buffer_pool.hpp"
+#include "mapped_file.hpp"
+#include "utoc.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace loader
+{
+    namespace fs = std::filesystem;
+
+    // A compression block as stored in its .ucas partition, pointing into the mapping.
+    struct StoredBlock {
+        const uint8_t*   data              = nullptr;
+        uint32_t         disk_size         = 0;   // compressed_size, padded when encrypted
+        uint32_t         compressed_size   = 0;
+        uint32_t         uncompressed_size = 0;
+        std::string_view method;
+    };
+
+    // A chunk's bytes: a view into the mapped .ucas when the chunk is stored uncompressed and
+    // contiguous, otherwise decompressed into the buffer `lease` holds.
+    struct ChunkData {
+        const uint8_t*         data = nullptr;
+        uint64_t               size = 0;
+        ChunkBufferPool::Lease lease;
+
+        bool zero_copy() const { return !lease; }
+    };
+
+    // A mapped .utoc with all its .ucas partitions, checked with validate_toc() on open. The
+    // mappings are read-only and every accessor is const, so any number of threads can read
+    // from one open container.
+    class IoStoreContainer
+    {
+    public:
+        bool
+        open(const fs::path& base_no_ext, std::string& err)
+        {
+            *this = IoStoreContainer{};
+            m_base = base_no_ext;
+
+            fs::path utoc = base_no_ext;
+            utoc += L".utoc";
+            if (!m_toc_file.open(utoc)) {
+                err = "cannot open .utoc";
+                return false;
+            }
+            if (!m_toc.parse(m_toc_file.data(), m_toc_file.size(), err)) {
+                return false;
+            }
+
+            std::vector<uint64_t> sizes;
+            for (uint32_t i = 0; i < m_toc.header().partition_count; ++i) {
+                MappedFile part;
+                if (!part.open(ucas_partition_path(base_no_ext, i))) {
+                    break;
+                }
+                sizes.push_back(part.size());
+                m_partitions.push_back(std::move(part));
+            }
+            if (!validate_toc(m_toc, sizes.data(), (uint32_t)sizes.size(), err)) {
+                return false;
+            }
+
+            m_index.reserve(m_toc.chunk_count());
+            for (uint32_t i = 0; i < m_toc.chunk_count(); ++i) {
+                const uint8_t* id = m_toc.chunk_id(i).p;
+                m_index.push_back(IndexEntry{ rd_le64(id), rd_le32(id + 8), i });
+            }
+            std::sort(m_index.begin(), m_index.end());
+            return true;
+        }
+
+        const fs::path& base()      const { return m_base; }
+        const TocView&  toc()       const { return m_toc; }
+        uint64_t        toc_bytes() const { return m_toc_file.size(); }
+
+        uint64_t
+        ucas_bytes() const
+        {
+            uint64_t n = 0;
+            for (const auto& p : m_partitions) {
+                n += p.size();
+            }
+            return n;
+        }
+
+        // TOC entry of the 12-byte FIoChunkId `id`, or kTocNone; binary search over an index
+        // sorted at open
+        uint32_t
+        find_chunk(const uint8_t* id) const
+        {
+            IndexEntry key{ rd_le64(id), rd_le32(id + 8), 0 };
+            auto it = std::lower_bound(m_index.begin(), m_index.end(), key);
+            return it != m_index.end() && it->id == key.id && it->tail == key.tail ? it->entry : kTocNone;
+        }
+
+        StoredBlock
+        stored_block(uint32_t i) const
+        {
+            TocCompressedBlock b = m_toc.block(i);
+            return StoredBlock{ block_data(b), (uint32_t)m_toc.block_disk_size(b), b.compressed_size, b.uncompressed_size,
+                                m_toc.method_name(b.method) };
+        }
+
+        // Points `data` at chunk `entry` inside the mapping when its blocks are uncompressed,
+        // unencrypted and back to back in one partition; no copy is made.
+        bool
+        chunk_view(uint32_t entry, const uint8_t*& data) const
+        {
+            if (m_toc.encrypted()) {
+                return false;
+            }
+
+            const TocHeader& h  = m_toc.header();
+            TocOffsetLength  ol = m_toc.offset_length(entry);
+            uint64_t         first = 0, count = 0;
+            m_toc.chunk_blocks(entry, first, count);
+            if (count == 0) {
+                static const uint8_t kEmpty = 0;
+                data = &kEmpty;
+                return ol.length == 0;
+            }
+
+            TocCompressedBlock a    = m_toc.block((uint32_t)first);
+            uint64_t           next = a.offset;
+            for (uint64_t i = first; i < first + count; ++i) {
+                TocCompressedBlock b = m_toc.block((uint32_t)i);
+                if (b.method != 0 || b.offset != next || b.compressed_size != b.uncompressed_size) {
+                    return false;
+                }
+                next = b.offset + b.compressed_size;
+            }
+            if (h.partition_count > 1 && a.offset / h.partition_size != (next - 1) / h.partition_size) {
+                return false;
+            }
+
+            data = block_data(a) + ol.offset % h.compression_block_size;
+            return true;
+        }
+
+        // Chunk `entry` as a view into the mapping when chunk_view() allows, otherwise
+        // decompressed into a buffer leased from `pool`.
+        bool
+        read_chunk(uint32_t entry, ChunkBufferPool& pool, ChunkData& out, std::string& err) const
+        {
+            out = ChunkData{};
+            if (chunk_view(entry, out.data)) {
+                out.size = m_toc.offset_length(entry).length;
+                return true;
+            }
+
+            out.lease = pool.acquire();
+            if (!read_chunk(entry, out.lease.buffer(), err)) {
+                out.lease.release();
+                return false;
+            }
+            out.data = out.lease.buffer().data();
+            out.size = out.lease.buffer().size();
+            return true;
+        }
+
+        // on-disk bytes of a block, toc().block_disk_size(b) long
+        const uint8_t*
+        block_data(const TocCompressedBlock& b) const
+        {
+            const TocHeader& h = m_toc.header();
+            if (h.partition_count == 1) {
+                return m_partitions[0].data() + b.offset;
+            }
+            return m_partitions[b.offset / h.partition_size].data() + b.offset % h.partition_size;
+        }
+
+        // asks the OS to read blocks [first, first + count) ahead of access; they are expected to
+        // be contiguous on disk, as the IoStore writer lays them out
+        void
+        prefetch_blocks(uint32_t first, uint32_t count) const
+        {
+            if (count == 0) {
+                return;
+            }
+
+            const TocHeader&   h     = m_toc.header();
+            TocCompressedBlock a     = m_toc.block(first);
+            TocCompressedBlock b     = m_toc.block(first + count - 1);
+            uint64_t           begin = a.offset;
+            uint64_t           end   = b.offset + m_toc.block_disk_size(b);
+            if (end <= begin) {
+                return;
+            }
+
+            uint64_t part = h.partition_count == 1 ? 0 : begin / h.partition_size;
+            uint64_t off  = h.partition_count == 1 ? begin : begin % h.partition_size;
+            m_partitions[part].prefetch(off, end - begin);
+        }
+
+        // Decompresses chunk `entry` into `out`, reusing its capacity. Encrypted containers are
+        // not supported.
+        bool
+        read_chunk(uint32_t entry, std::vector<uint8_t>& out, std::string& err) const
+        {
+            if (m_toc.encrypted()) {
+                err = "container is encrypted";
+                return false;
+            }
+
+            const uint32_t  block_size = m_toc.header().compression_block_size;
+            TocOffsetLength ol         = m_toc.offset_length(entry);
+            uint64_t        first = 0, count = 0;
+            m_toc.chunk_blocks(entry, first, count);
+
+            out.resize((size_t)(count * block_size));
+            size_t at = 0;
+            for (uint64_t i = first; i < first + count; ++i) {
+                TocCompressedBlock b = m_toc.block((uint32_t)i);
+                const char*        e = nullptr;
+                if (!decode_block(m_toc.method_name(b.method), block_data(b), b.compressed_size, out.data() + at, b.uncompressed_size, &e)) {
+                    err = "block " + std::to_string(i) + " (" + std::string(m_toc.method_name(b.method)) + "): " + e;
+                    return false;
+                }
+                at += b.uncompressed_size;
+            }
+
+            uint64_t in_block = ol.offset % block_size;
+            if (in_block + ol.length > at) {
+                err = "chunk is longer than its blocks";
+                return false;
+            }
+            if (in_block) {
+                std::memmove(out.data(), out.data() + in_block, (size_t)ol.length);
+            }
+            out.resize((size_t)ol.length);
+            return true;
+        }
+
+    private:
+        struct IndexEntry {
+            uint64_t id;
+            uint32_t tail;   // index, padding and type
+            uint32_t entry;
+
+            bool
+            operator<(const IndexEntry& o) const
+            {
+                return id != o.id ? id < o.id : tail < o.tail;
+            }
+        };
+
+        fs::path                m_base;
+        MappedFile              m_toc_file;
+        TocView                 m_toc;
+        std::vector<MappedFile> m_partitions;
+        std::vector<IndexEntry> m_index;   // chunk ids, sorted
+    };
+}
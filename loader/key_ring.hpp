@@ -0,0 +1,318 @@
+#pragma once
+
+#include "aes.hpp"
+#include "iostore_container.hpp"
+#include "sha1.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace loader
+{
+    namespace fs = std::filesystem;
+
+    // FGuid as stored in a .utoc header: A, B, C, D as little-endian uint32
+    static constexpr size_t kGuidSize = 16;
+
+    // FGuid::ToString(): the four words as 32 upper-case hex digits
+    static inline std::string
+    guid_to_string(const uint8_t* guid)
+    {
+        char buf[33];
+        std::snprintf(buf, sizeof(buf), "%08X%08X%08X%08X", rd_le32(guid), rd_le32(guid + 4), rd_le32(guid + 8), rd_le32(guid + 12));
+        return buf;
+    }
+
+    namespace key_ring_detail
+    {
+        static inline int
+        hex_digit(char c)
+        {
+            return c >= '0' && c <= '9' ? c - '0'
+                 : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                 : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                 : -1;
+        }
+
+        static inline bool
+        parse_hex(std::string_view s, uint8_t* out, size_t n)
+        {
+            if (s.size() != n * 2) {
+                return false;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                int hi = hex_digit(s[2 * i]), lo = hex_digit(s[2 * i + 1]);
+                if (hi < 0 || lo < 0) {
+                    return false;
+                }
+                out[i] = (uint8_t)(hi << 4 | lo);
+            }
+            return true;
+        }
+
+        // GUID text, with or without hyphens and braces, to the .utoc byte layout
+        static inline bool
+        parse_guid(std::string_view s, uint8_t* out)
+        {
+            std::string digits;
+            for (char c : s) {
+                if (c != '-' && c != '{' && c != '}') {
+                    digits += c;
+                }
+            }
+
+            uint8_t be[kGuidSize];
+            if (!parse_hex(digits, be, kGuidSize)) {
+                return false;
+            }
+            for (size_t w = 0; w < 4; ++w) {
+                for (size_t k = 0; k < 4; ++k) {
+                    out[w * 4 + k] = be[w * 4 + 3 - k];
+                }
+            }
+            return true;
+        }
+
+        static inline bool
+        parse_base64(std::string_view s, uint8_t* out, size_t n)
+        {
+            auto value = [](char c) -> int {
+                return c >= 'A' && c <= 'Z' ? c - 'A'
+                     : c >= 'a' && c <= 'z' ? c - 'a' + 26
+                     : c >= '0' && c <= '9' ? c - '0' + 52
+                     : c == '+' ? 62
+                     : c == '/' ? 63
+                     : -1;
+            };
+
+            while (!s.empty() && s.back() == '=') {
+                s.remove_suffix(1);
+            }
+            if (s.size() != (n * 4 + 2) / 3) {
+                return false;
+            }
+
+            uint32_t acc  = 0;
+            int      bits = 0;
+            size_t   at   = 0;
+            for (char c : s) {
+                int v = value(c);
+                if (v < 0) {
+                    return false;
+                }
+                acc   = acc << 6 | (uint32_t)v;
+                bits += 6;
+                if (bits >= 8) {
+                    bits -= 8;
+                    if (at < n) {
+                        out[at++] = (uint8_t)(acc >> bits);
+                    }
+                }
+            }
+            return at == n;
+        }
+
+        // "0x" + 64 hex digits, 64 hex digits, or base64 (as in a project's Crypto.json)
+        static inline bool
+        parse_key(std::string_view s, uint8_t* out)
+        {
+            if (s.size() > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+                s.remove_prefix(2);
+            }
+            return parse_hex(s, out, Aes256Decryptor::kKeySize) || parse_base64(s, out, Aes256Decryptor::kKeySize);
+        }
+
+        static inline std::string_view
+        trim(std::string_view s)
+        {
+            while (!s.empty() && std::isspace((unsigned char)s.front())) {
+                s.remove_prefix(1);
+            }
+            while (!s.empty() && std::isspace((unsigned char)s.back())) {
+                s.remove_suffix(1);
+            }
+            return s;
+        }
+    }
+
+    // Mods/IoStoreLoaderMod/keys.txt: `GUID = key` lines mapping a container's encryption key
+    // GUID (FGuid::ToString(), hyphens allowed; all zeros for containers made with the
+    // project's default key) to its AES-256 key, as hex ("0x" optional) or base64. '#' and ';'
+    // start comments.
+    class KeyRing
+    {
+    public:
+        struct Entry {
+            uint8_t guid[kGuidSize];
+            uint8_t key[Aes256Decryptor::kKeySize];
+        };
+
+        void
+        parse(std::string_view text, std::vector<std::string>& warnings)
+        {
+            using namespace key_ring_detail;
+
+            int line_no = 0;
+            while (!text.empty()) {
+                size_t           nl   = text.find('\n');
+                std::string_view line = text.substr(0, nl);
+                text.remove_prefix(nl == std::string_view::npos ? text.size() : nl + 1);
+                ++line_no;
+
+                line = trim(line);
+                if (line.empty() || line[0] == '#' || line[0] == ';') {
+                    continue;
+                }
+
+                Entry  e;
+                size_t eq = line.find('=');
+                if (eq == std::string_view::npos || !parse_guid(trim(line.substr(0, eq)), e.guid)) {
+                    warnings.push_back("line " + std::to_string(line_no) + ": expected GUID = key");
+                    continue;
+                }
+                if (!parse_key(trim(line.substr(eq + 1)), e.key)) {
+                    warnings.push_back("line " + std::to_string(line_no) + ": key must be 32 bytes as hex or base64");
+                    continue;
+                }
+
+                auto it = std::find_if(m_entries.begin(), m_entries.end(),
+                                       [&](const Entry& o) { return std::memcmp(o.guid, e.guid, kGuidSize) == 0; });
+                if (it != m_entries.end()) {
+                    warnings.push_back("line " + std::to_string(line_no) + ": key for " + guid_to_string(e.guid) + " given again, the later one is used");
+                    *it = e;
+                } else {
+                    m_entries.push_back(e);
+                }
+            }
+        }
+
+        // a missing file gives an empty ring
+        void
+        load(const fs::path& path, std::vector<std::string>& warnings)
+        {
+            m_entries.clear();
+            std::ifstream in(path, std::ios::binary);
+            if (in) {
+                std::stringstream ss;
+                ss << in.rdbuf();
+                parse(ss.str(), warnings);
+            }
+        }
+
+        const uint8_t*
+        find(const uint8_t* guid) const
+        {
+            for (const auto& e : m_entries) {
+                if (std::memcmp(e.guid, guid, kGuidSize) == 0) {
+                    return e.key;
+                }
+            }
+            return nullptr;
+        }
+
+        size_t size() const { return m_entries.size(); }
+
+    private:
+        std::vector<Entry> m_entries;
+    };
+
+    enum class KeyCheck {
+        Ok,
+        WrongKey,
+        Unverifiable,   // nothing in the container can be checked (no index, no hashed chunk we can decode)
+    };
+
+    // Checks `key` against an encrypted container before the engine gets it: the directory index
+    // must decrypt to one that parses, and the smallest hashed chunk must decrypt and decode to
+    // its SHA-1. A wrong key fails the first check in microseconds.
+    static inline KeyCheck
+    check_container_key(const IoStoreContainer& c, const uint8_t* key, std::string& detail)
+    {
+        const TocView&  toc = c.toc();
+        Aes256Decryptor aes(key);
+        bool            checked = false;
+
+        if (toc.indexed() && toc.directory_index_size() % Aes256Decryptor::kBlockSize == 0) {
+            std::vector<uint8_t> index(toc.directory_index(), toc.directory_index() + toc.directory_index_size());
+            aes.decrypt(index.data(), index.size());
+
+            TocDirectoryIndex dir;
+            std::string       err;
+            if (!dir.parse(index.data(), index.size(), err)) {
+                detail = "the directory index does not decrypt (" + err + ")";
+                return KeyCheck::WrongKey;
+            }
+            checked = true;
+        }
+
+        static const uint8_t kZero[SHA1::kDigestSize] = {};
+        uint32_t             pick     = kTocNone;
+        uint64_t             pick_len = UINT64_MAX;
+        for (uint32_t i = 0; i < toc.chunk_count(); ++i) {
+            uint64_t len = toc.offset_length(i).length;
+            if (len == 0 || len >= pick_len || std::memcmp(toc.chunk_hash(i), kZero, SHA1::kDigestSize) == 0) {
+                continue;
+            }
+
+            uint64_t first = 0, count = 0;
+            toc.chunk_blocks(i, first, count);
+            bool decodable = count > 0;
+            for (uint64_t b = first; b < first + count && decodable; ++b) {
+                decodable = block_method_supported(toc.method_name(toc.block((uint32_t)b).method));
+            }
+            if (decodable) {
+                pick     = i;
+                pick_len = len;
+            }
+        }
+
+        if (pick != kTocNone) {
+            const uint32_t  block_size = toc.header().compression_block_size;
+            TocOffsetLength ol         = toc.offset_length(pick);
+            uint64_t        first = 0, count = 0;
+            toc.chunk_blocks(pick, first, count);
+
+            std::vector<uint8_t> out((size_t)(count * block_size));
+            std::vector<uint8_t> block;
+            size_t               at = 0;
+            for (uint64_t b = first; b < first + count; ++b) {
+                StoredBlock s = c.stored_block((uint32_t)b);
+                block.assign(s.data, s.data + s.disk_size);
+                aes.decrypt(block.data(), block.size());
+
+                const char* e = nullptr;
+                if (!decode_block(s.method, block.data(), s.compressed_size, out.data() + at, s.uncompressed_size, &e)) {
+                    detail = "chunk " + std::to_string(pick) + " does not decrypt to valid " + std::string(s.method) + " data";
+                    return KeyCheck::WrongKey;
+                }
+                at += s.uncompressed_size;
+            }
+
+            uint64_t in_block = ol.offset % block_size;
+            uint8_t  digest[SHA1::kDigestSize];
+            if (in_block + ol.length <= at) {
+                SHA1::hash(out.data() + in_block, (size_t)ol.length, digest);
+            }
+            if (in_block + ol.length > at || std::memcmp(digest, toc.chunk_hash(pick), SHA1::kDigestSize) != 0) {
+                detail = "chunk " + std::to_string(pick) + " does not decrypt to its hash";
+                return KeyCheck::WrongKey;
+            }
+            checked = true;
+        }
+
+        if (!checked) {
+            detail = "no directory index and no hashed chunk with a supported compression method";
+            return KeyCheck::Unverifiable;
+        }
+        return KeyCheck::Ok;
+    }
+}
@@ -0,0 +1,325 @@
+#pragma once
+
+#include "container_header.hpp"
+#include "iostore_container.hpp"
+#include "utoc.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cwctype>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace loader
+{
+    namespace fs = std::filesystem;
+
+    // "../../../<Project>/Content/Mods/X/A.uasset" -> "/Game/Mods/X/A". Plugin content maps to
+    // "/<Plugin>/...", engine content to "/Engine/...". Empty for files that are not packages.
+    static inline std::string
+    package_name_from_file(std::string_view path)
+    {
+        size_t dot = path.rfind('.');
+        if (dot == std::string_view::npos) {
+            return {};
+        }
+        std::string_view ext = path.substr(dot);
+        if (ext != ".uasset" && ext != ".umap") {
+            return {};
+        }
+        path = path.substr(0, dot);
+
+        while (path.substr(0, 3) == "../") {
+            path.remove_prefix(3);
+        }
+
+        size_t content = path.find("/Content/");
+        if (content == std::string_view::npos) {
+            return {};
+        }
+
+        std::string_view root = path.substr(0, content);   // "<Project>", "Engine" or ".../Plugins/.../<Plugin>"
+        std::string_view rest = path.substr(content + 9);
+
+        std::string name;
+        if (root == "Engine") {
+            name = "/Engine/";
+        } else if (root.find("/Plugins/") != std::string_view::npos) {
+            name = "/" + std::string(root.substr(root.rfind('/') + 1)) + "/";
+        } else if (root.find('/') == std::string_view::npos) {
+            name = "/Game/";
+        } else {
+            return {};
+        }
+        name += rest;
+        return name;
+    }
+
+    // Lower-cased package name of an object path as StaticLoadClass gets it:
+    // "BlueprintGeneratedClass'/Game/Mods/X/ModActor.ModActor_C'" -> "/game/mods/x/modactor"
+    static inline std::string
+    package_key(std::string_view object_path)
+    {
+        size_t quote = object_path.find('\'');
+        if (quote != std::string_view::npos) {
+            object_path.remove_prefix(quote + 1);
+            size_t end = object_path.find('\'');
+            object_path = object_path.substr(0, end);
+        }
+        object_path = object_path.substr(0, std::min(object_path.find('.'), object_path.find(':')));
+
+        std::string key(object_path);
+        for (char& c : key) {
+            c = (char)std::tolower((unsigned char)c);
+        }
+        return key;
+    }
+
+    // true when package_key(object_path) starts with /game/mods/; checked on the raw path without
+    // allocating, since every StaticLoadClass call in the game goes through it
+    static inline bool
+    under_lazy_root(std::wstring_view object_path)
+    {
+        static constexpr std::wstring_view kRoot = L"/game/mods/";
+
+        size_t quote = object_path.find(L'\'');
+        if (quote != std::wstring_view::npos) {
+            object_path.remove_prefix(quote + 1);
+        }
+        if (object_path.size() < kRoot.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < kRoot.size(); ++i) {
+            if ((wchar_t)towlower(object_path[i]) != kRoot[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Package ids imported by the packages of a container, from its container header; sorted and
+    // unique. Empty when it has no header, in which case it only pulls in itself.
+    static inline std::vector<uint64_t>
+    container_imports(const IoStoreContainer& c)
+    {
+        std::vector<uint64_t> imports;
+        const TocView&        toc = c.toc();
+        for (uint32_t i = 0; i < toc.chunk_count(); ++i) {
+            if (toc.chunk_id(i).type() != IoChunkType::ContainerHeader) {
+                continue;
+            }
+            std::vector<uint8_t> bytes;
+            ContainerHeader      header;
+            std::string          err;
+            if (c.read_chunk(i, bytes, err) && parse_container_header(bytes.data(), bytes.size(), header, err)) {
+                for (const auto& e : header.store_entries) {
+                    imports.insert(imports.end(), e.imported_packages.begin(), e.imported_packages.end());
+                }
+                std::sort(imports.begin(), imports.end());
+                imports.erase(std::unique(imports.begin(), imports.end()), imports.end());
+            }
+            break;
+        }
+        return imports;
+    }
+
+    // mount = lazy: the IoStore containers that can wait until one of their packages is first
+    // asked for. A container qualifies when its directory index can be read and every package
+    // in it lives under /Game/Mods/ and is not a map: mods that replace game content must be
+    // mounted before the game loads that content, and maps are opened by travel, which does not
+    // come through the class lookups the mod watches. Not thread-safe.
+    class LazyMountIndex
+    {
+    public:
+        static constexpr std::string_view kLazyRoot = "/game/mods/";
+
+        // Indexes base.utoc's packages and the packages they import. Returns false, with the
+        // reason, when the container must be mounted now.
+        bool
+        add(size_t plan_index, const fs::path& base, std::string& reason)
+        {
+            IoStoreContainer c;
+            if (!c.open(base, reason)) {
+                return false;
+            }
+
+            const TocView& toc = c.toc();
+            if (toc.encrypted()) {
+                reason = "encrypted";
+                return false;
+            }
+            if (!toc.indexed()) {
+                reason = "no directory index";
+                return false;
+            }
+
+            TocDirectoryIndex dir;
+            if (!dir.parse(toc.directory_index(), toc.directory_index_size(), reason)) {
+                return false;
+            }
+
+            Container                                     entry;
+            std::vector<std::pair<std::string, uint64_t>> names;
+            entry.plan_index = plan_index;
+
+            bool ok = dir.for_each_file([&](std::string_view path, uint32_t toc_entry) {
+                if (!reason.empty()) {
+                    return;
+                }
+                std::string name = package_name_from_file(path);
+                if (name.empty()) {
+                    return;
+                }
+                std::string key = package_key(name);
+                if (key.compare(0, kLazyRoot.size(), kLazyRoot) != 0) {
+                    reason = "provides " + name + " outside /Game/Mods/";
+                } else if (path.size() >= 5 && path.substr(path.size() - 5) == ".umap") {
+                    reason = "contains the map " + name;
+                } else if (toc_entry < toc.chunk_count()) {
+                    names.emplace_back(std::move(key), toc.chunk_id(toc_entry).id());
+                }
+            });
+            if (!ok) {
+                reason = "directory index is corrupt";
+            }
+            if (!reason.empty()) {
+                return false;
+            }
+            if (names.empty()) {
+                reason = "no packages";
+                return false;
+            }
+
+            entry.imports = container_imports(c);
+
+            const uint32_t index = (uint32_t)m_containers.size();
+            for (auto& [key, id] : names) {
+                m_by_name[std::move(key)].push_back(index);
+                m_by_id[id].push_back(index);
+            }
+            m_packages += names.size();
+            m_containers.push_back(std::move(entry));
+            m_taken.push_back(0);
+            ++m_pending;
+            return true;
+        }
+
+        // Plan indices to mount now that `key` (see package_key) is asked for: every deferred
+        // container providing it and, recursively, those providing packages they import, in
+        // plan order. Each container is handed out once.
+        std::vector<size_t>
+        take(const std::string& key)
+        {
+            auto it = m_by_name.find(key);
+            if (it == m_by_name.end()) {
+                return {};
+            }
+            return take_with_imports(std::vector<uint32_t>(it->second.begin(), it->second.end()));
+        }
+
+        // Plan indices of the deferred containers providing any of `imports` (package ids a
+        // container mounted now depends on) and, recursively, what those import. The engine
+        // resolves such imports through the package store without any class lookup the mod
+        // sees, so these have to be mounted now as well.
+        std::vector<size_t>
+        take_imported(const std::vector<uint64_t>& imports)
+        {
+            std::vector<uint32_t> work;
+            for (uint64_t id : imports) {
+                auto dep = m_by_id.find(id);
+                if (dep != m_by_id.end()) {
+                    work.insert(work.end(), dep->second.begin(), dep->second.end());
+                }
+            }
+            return take_with_imports(std::move(work));
+        }
+
+        // every container not handed out yet, in plan order
+        std::vector<size_t>
+        take_all()
+        {
+            std::vector<size_t> out;
+            for (size_t c = 0; c < m_containers.size(); ++c) {
+                if (!m_taken[c]) {
+                    m_taken[c] = 1;
+                    out.push_back(m_containers[c].plan_index);
+                }
+            }
+            m_pending = 0;
+            std::sort(out.begin(), out.end());
+            return out;
+        }
+
+        // plan indices of the containers not handed out yet, in plan order
+        std::vector<size_t>
+        still_deferred() const
+        {
+            std::vector<size_t> out;
+            for (size_t c = 0; c < m_containers.size(); ++c) {
+                if (!m_taken[c]) {
+                    out.push_back(m_containers[c].plan_index);
+                }
+            }
+            std::sort(out.begin(), out.end());
+            return out;
+        }
+
+        // true while a container providing `key` is still deferred
+        bool
+        waiting(const std::string& key) const
+        {
+            auto it = m_by_name.find(key);
+            if (it == m_by_name.end()) {
+                return false;
+            }
+            return std::any_of(it->second.begin(), it->second.end(), [&](uint32_t c) { return !m_taken[c]; });
+        }
+
+        size_t deferred() const { return m_containers.size(); }
+        size_t packages() const { return m_packages; }
+        size_t pending()  const { return m_pending; }
+
+    private:
+        struct Container {
+            size_t                plan_index = 0;
+            std::vector<uint64_t> imports;   // package ids, sorted
+        };
+
+        // hands out the containers in `work` and, recursively, those providing their imports
+        std::vector<size_t>
+        take_with_imports(std::vector<uint32_t> work)
+        {
+            std::vector<size_t> out;
+            while (!work.empty()) {
+                uint32_t c = work.back();
+                work.pop_back();
+                if (m_taken[c]) {
+                    continue;
+                }
+                m_taken[c] = 1;
+                --m_pending;
+                out.push_back(m_containers[c].plan_index);
+
+                for (uint64_t id : m_containers[c].imports) {
+                    auto dep = m_by_id.find(id);
+                    if (dep != m_by_id.end()) {
+                        work.insert(work.end(), dep->second.begin(), dep->second.end());
+                    }
+                }
+            }
+            std::sort(out.begin(), out.end());
+            return out;
+        }
+
+        std::vector<Container>                                 m_containers;
+        std::unordered_map<std::string, std::vector<uint32_t>> m_by_name;   // package key -> containers
+        std::unordered_map<uint64_t, std::vector<uint32_t>>    m_by_id;     // package id -> containers
+        std::vector<uint8_t>                                   m_taken;
+        size_t                                                 m_packages = 0;
+        size_t                                                 m_pending  = 0;
+    };
+}
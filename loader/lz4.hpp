@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+namespace loader
+{
+    // LZ4 block format decoder (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md), as
+    // written by LZ4_compress_default for UE's "LZ4" compression method. Returns the number of
+    // bytes written, or -1 if the block is corrupt or does not fit in `dst_len`.
+    static inline int64_t
+    lz4_decode_block(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_len)
+    {
+        const uint8_t* p       = src;
+        const uint8_t* end     = src + src_len;
+        uint8_t*       out     = dst;
+        uint8_t*       out_end = dst + dst_len;
+
+        auto read_length = [&](size_t& len) {
+            uint8_t b;
+            do {
+                if (p >= end) {
+                    return false;
+                }
+                b    = *p++;
+                len += b;
+            } while (b == 255);
+            return true;
+        };
+
+        while (p < end) {
+            uint8_t token = *p++;
+
+            size_t lit = token >> 4;
+            if (lit == 15 && !read_length(lit)) {
+                return -1;
+            }
+            if (lit > (size_t)(end - p) || lit > (size_t)(out_end - out)) {
+                return -1;
+            }
+            std::memcpy(out, p, lit);
+            out += lit;
+            p   += lit;
+
+            // the last sequence has literals only
+            if (p == end) {
+                break;
+            }
+
+            if (end - p < 2) {
+                return -1;
+            }
+            size_t offset = (size_t)p[0] | ((size_t)p[1] << 8);
+            p += 2;
+            if (offset == 0 || offset > (size_t)(out - dst)) {
+                return -1;
+            }
+
+            size_t match = (token & 15);
+            if (match == 15 && !read_length(match)) {
+                return -1;
+            }
+            match += 4;
+            if (match > (size_t)(out_end - out)) {
+                return -1;
+            }
+
+            // overlapping copies repeat the last `offset` bytes
+            const uint8_t* from = out - offset;
+            if (offset >= match) {
+                std::memcpy(out, from, match);
+                out += match;
+            } else {
+                for (size_t i = 0; i < match; ++i) {
+                    *out++ = from[i];
+                }
+            }
+        }
+        return out - dst;
+    }
+}
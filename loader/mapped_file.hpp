@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace loader
+{
+    namespace fs = std::filesystem;
+
+    // read-only memory mapping of a whole file
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+
+        ~MappedFile()
+        {
+            close();
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept
+        {
+            *this = std::move(other);
+        }
+
+        MappedFile&
+        operator=(MappedFile&& other) noexcept
+        {
+            if (this != &other) {
+                close();
+                m_data = other.m_data;
+                m_size = other.m_size;
+#ifdef _WIN32
+                m_file    = other.m_file;
+                m_mapping = other.m_mapping;
+                other.m_file    = INVALID_HANDLE_VALUE;
+                other.m_mapping = nullptr;
+#endif
+                other.m_data = nullptr;
+                other.m_size = 0;
+            }
+            return *this;
+        }
+
+        bool
+        open(const fs::path& path)
+        {
+            close();
+
+#ifdef _WIN32
+            m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (m_file == INVALID_HANDLE_VALUE) {
+                return false;
+            }
+
+            LARGE_INTEGER size{};
+            if (!GetFileSizeEx(m_file, &size)) {
+                close();
+                return false;
+            }
+
+            m_size = static_cast<uint64_t>(size.QuadPart);
+            if (m_size == 0) {
+                return true;
+            }
+
+            m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!m_mapping) {
+                close();
+                return false;
+            }
+
+            m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+            if (!m_data) {
+                close();
+                return false;
+            }
+#else
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                return false;
+            }
+
+            struct stat st{};
+            if (fstat(fd, &st) != 0) {
+                ::close(fd);
+                return false;
+            }
+
+            m_size = static_cast<uint64_t>(st.st_size);
+            if (m_size == 0) {
+                ::close(fd);
+                return true;
+            }
+
+            void* p = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+
+            if (p == MAP_FAILED) {
+                m_size = 0;
+                return false;
+            }
+            m_data = static_cast<const uint8_t*>(p);
+#endif
+            return true;
+        }
+
+        void
+        close()
+        {
+#ifdef _WIN32
+            if (m_data) {
+                UnmapViewOfFile(m_data);
+            }
+            if (m_mapping) {
+                CloseHandle(m_mapping);
+                m_mapping = nullptr;
+            }
+            if (m_file != INVALID_HANDLE_VALUE) {
+                CloseHandle(m_file);
+                m_file = INVALID_HANDLE_VALUE;
+            }
+#else
+            if (m_data) {
+                munmap(const_cast<uint8_t*>(m_data), m_size);
+            }
+#endif
+            m_data = nullptr;
+            m_size = 0;
+        }
+
+        const uint8_t* data() const { return m_data; }
+        uint64_t       size() const { return m_size; }
+
+        // asks the OS to read [offset, offset + len) ahead of access, as one large read
+        void
+        prefetch(uint64_t offset, uint64_t len) const
+        {
+            if (!m_data || offset >= m_size) {
+                return;
+            }
+            len = (std::min)(len, m_size - offset);
+
+#ifdef _WIN32
+            WIN32_MEMORY_RANGE_ENTRY range{ const_cast<uint8_t*>(m_data) + offset, static_cast<SIZE_T>(len) };
+            PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+            uint64_t page  = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+            uint64_t start = offset / page * page;
+            madvise(const_cast<uint8_t*>(m_data) + start, static_cast<size_t>(offset + len - start), MADV_WILLNEED);
+#endif
+        }
+
+    private:
+        const uint8_t* m_data = nullptr;
+        uint64_t       m_size = 0;
+#ifdef _WIN32
+        HANDLE m_file    = INVALID_HANDLE_VALUE;
+        HANDLE m_mapping = nullptr;
+#endif
+    };
+}
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <cstdint>
+#include <cwctype>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+namespace loader
+{
+    namespace fs = std::filesystem;
+
+    enum class ContainerKind {
+        Pak,
+        IoStore,
+    };
+
+    struct ModSource {
+        fs::path     path;           // mod folder or .zip archive
+        fs::path     dir;            // folder the containers are read from (extraction dir for archives)
+        std::wstring name;           // folder name or archive stem; defines the load order
+        bool         is_zip = false;
+    };
+
+    struct MountEntry {
+        fs::path      path;      // .pak for Pak, .utoc for IoStore
+        fs::path      mod_dir;
+        std::wstring  mod_name;
+        std::wstring  name;      // container file name without extension
+        std::wstring_view game_path; // engine-facing path (see intern_game_paths), owned by a GamePathArena
+        ContainerKind kind  = ContainerKind::Pak;
+        int           order = 0;
+        bool          skip  = false;
+    };
+
+    static inline bool
+    iequals(std::wstring_view a, std::wstring_view b)
+    {
+        if (a.size() != b.size()) {
+            return false;
+        }
+
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (towlower(a[i]) != towlower(b[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static inline bool
+    file_exists(const fs::path& p)
+    {
+        std::error_code ec;
+        return fs::exists(p, ec);
+    }
+
+    static inline fs::path
+    base_to_ext(const fs::path& base_no_ext, const wchar_t* ext)
+    {
+        fs::path p = base_no_ext;
+        p.replace_extension(ext);
+        return p;
+    }
+
+    static inline bool
+    has_ucas_any(const fs::path& base_no_ext)
+    {
+        if (file_exists(base_to_ext(base_no_ext, L".ucas"))) {
+            return true;
+        }
+
+        for (int i = 1; i <= 16; ++i) {
+            fs::path p = base_no_ext;
+            p += L".ucas" + std::to_wstring(i);
+            if (file_exists(p)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // every file the engine may open for a container: the .pak (if any), the .utoc and all .ucas partitions
+    static inline std::vector<fs::path>
+    container_files(const MountEntry& e)
+    {
+        std::vector<fs::path> out;
+
+        fs::path base = e.path;
+        base.replace_extension(L"");
+
+        if (e.kind == ContainerKind::Pak) {
+            out.push_back(e.path);
+        }
+
+        for (const wchar_t* ext : { L".utoc", L".ucas" }) {
+            fs::path p = base_to_ext(base, ext);
+            if (file_exists(p)) {
+                out.push_back(std::move(p));
+            }
+        }
+
+        for (int i = 1; i <= 16; ++i) {
+            fs::path p = base;
+            p += L".ucas" + std::to_wstring(i);
+            if (file_exists(p)) {
+                out.push_back(std::move(p));
+            }
+        }
+        return out;
+    }
+
+    static inline std::vector<fs::path>
+    list_files_ext_sorted(const fs::path& dir, std::wstring_view ext)
+    {
+        std::vector<fs::path> out;
+        std::error_code ec;
+
+        if (!fs::exists(dir, ec) || !fs::is_directory(dir, ec)) {
+            return out;
+        }
+
+        for (auto& it : fs::directory_iterator(dir, ec)) {
+            if (ec) {
+                break;
+            }
+
+            if (!it.is_regular_file(ec)) {
+                continue;
+            }
+
+            auto p = it.path();
+            if (p.extension() == ext) {
+                out.push_back(p.lexically_normal());
+            }
+        }
+
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return out;
+    }
+
+    static inline bool
+    is_zip_path(const fs::path& p)
+    {
+        return iequals(p.extension().wstring(), L".zip");
+    }
+
+    // mod folders and .zip mods directly under `root`, in load order
+    static inline std::vector<ModSource>
+    discover_mod_dirs(const fs::path& root)
+    {
+        std::vector<ModSource> mods;
+        std::error_code ec;
+
+        if (!fs::exists(root, ec) || !fs::is_directory(root, ec)) {
+            return mods;
+        }
+
+        for (auto& it : fs::directory_iterator(root, ec)) {
+            if (ec) {
+                break;
+            }
+
+            fs::path p = it.path().lexically_normal();
+
+            if (it.is_regular_file(ec)) {
+                if (is_zip_path(p)) {
+                    mods.push_back(ModSource{ p, fs::path(), p.stem().wstring(), true });
+                }
+                continue;
+            }
+
+            if (!it.is_directory(ec)) {
+                continue;
+            }
+
+            std::wstring fname = p.filename().wstring();
+
+            if (iequals(fname, L"dlls")      ||
+                iequals(fname, L"scripts")   ||
+                iequals(fname, L"disabled")  ||
+                iequals(fname, L".zipcache")) {
+                continue;
+            }
+
+            mods.push_back(ModSource{ p, p, fname, false });
+        }
+
+        std::sort(mods.begin(), mods.end(), [](const ModSource& a, const ModSource& b) {
+            if (a.name != b.name) {
+                return a.name < b.name;
+            }
+            return a.is_zip < b.is_zip;
+        });
+        return mods;
+    }
+
+    // appends the containers of one mod folder to `plan`; returns false if the folder has none
+    static inline bool
+    plan_mod_folder(const ModSource& mod, int order_base, std::vector<MountEntry>& plan)
+    {
+        const fs::path& mod_dir = mod.dir;
+
+        // preferred: mount all .pak files found in the mod folder
+        ContainerKind         kind  = ContainerKind::Pak;
+        std::vector<fs::path> files = list_files_ext_sorted(mod_dir, L".pak");
+
+        // if user supplied only IoStore (.utoc/.ucas) but no .pak
+        // we cannot mount it without calling IoDispatcher.
+        if (files.empty()) {
+            kind  = ContainerKind::IoStore;
+            files = list_files_ext_sorted(mod_dir, L".utoc");
+        }
+
+        for (size_t i = 0; i < files.size(); ++i) {
+            MountEntry e;
+            e.path     = files[i];
+            e.mod_dir  = mod_dir;
+            e.mod_name = mod.name;
+            e.name     = files[i].filename().replace_extension("").wstring();
+            e.kind     = kind;
+            e.order    = order_base + (int)i;
+            plan.push_back(std::move(e));
+        }
+        return !files.empty();
+    }
+
+    // Names of the containers whose ModActors this container stands in for. A merged container
+    // (tools/utoc_merge) lists its sources one per line in <name>.actors, UTF-8; any other
+    // container stands for itself.
+    static inline std::vector<std::wstring>
+    container_actor_names(const MountEntry& e)
+    {
+        fs::path sidecar = e.path;
+        sidecar.replace_extension(L".actors");
+
+        std::vector<std::wstring> names;
+        std::ifstream in(sidecar, std::ios::binary);
+        for (std::string line; in && std::getline(in, line);) {
+            while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) {
+                line.pop_back();
+            }
+            if (!line.empty()) {
+                names.push_back(fs::path(std::u8string(line.begin(), line.end())).wstring());
+            }
+        }
+
+        if (names.empty()) {
+            names.push_back(e.name);
+        }
+        return names;
+    }
+}
@@ -0,0 +1,937 @@
+#pragma once
+
+#include "config.hpp"
+#include "content_hash.hpp"
+#include "engine_abi.hpp"
+#include "key_ring.hpp"
+#include "lazy_mount.hpp"
+#include "mod_discovery.hpp"
+#include "override_index.hpp"
+#include "pak.hpp"
+#include "path_arena.hpp"
+#include "resident.hpp"
+#include "spawn_queue.hpp"
+#include "ucas_verify.hpp"
+#include "utoc.hpp"
+#include "wformat.hpp"
+#include "zip_cache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace loader
+{
+    namespace fs = std::filesystem;
+
+    enum class MountLogLevel {
+        Notice,
+        Info,
+        Warn,
+        Error,
+    };
+
+    // The engine's mount functions and the objects they are called on. A null function means
+    // that kind of container cannot be mounted yet.
+    struct MountBackend {
+        void*                     pak_platform_file = nullptr;
+        FPakPlatformFileMountFunc pak_mount         = nullptr;
+        void*                     io_dispatcher     = nullptr;
+        FIoDispatcherMountFunc    io_mount          = nullptr;
+    };
+
+    enum class MountState {
+        Queued,    // waiting for the engine's mount functions
+        Mounted,
+        Failed,
+    };
+
+    // one container handed to (or held back from) the engine, by the pipeline or another mod
+    struct MountRecord {
+        uint32_t      id = 0;          // 1-based, in request order
+        fs::path      path;            // .pak or .utoc
+        ContainerKind kind  = ContainerKind::Pak;
+        int           order = 0;
+        MountState    state = MountState::Queued;
+        int32_t       io_error = 0;    // POD::EIoErrorCode of an IoStore mount
+        std::wstring  message;
+        bool          external = false;   // asked for through mount_external()
+    };
+
+    // wall time of each MountPipeline::run phase, in seconds
+    struct MountTimings {
+        double discover = 0;
+        double zip      = 0;
+        double plan     = 0;
+        double dedupe   = 0;
+        double intern   = 0;
+        double index    = 0;   // mount = lazy: reading the packages of the containers to defer
+        double mount    = 0;
+        double report   = 0;
+
+        double total() const { return discover + zip + plan + dedupe + intern + index + mount + report; }
+    };
+
+    // Everything between finding the mod folders and the engine's mount calls: discovery, zip
+    // extraction, planning, dedupe, pre-mount checks and the mount calls themselves, through a
+    // MountBackend. Nothing here depends on Windows or UE4SS; the mod supplies the hooked engine
+    // functions and its log, tools/mount_sim stand-ins for both.
+    class MountPipeline
+    {
+    public:
+        using LogSink = std::function<void(MountLogLevel, const std::wstring&)>;
+
+        static constexpr int kBaseOrder = 200;
+
+        MountPipeline(const fs::path& working_dir, const fs::path& loader_root, LogSink log)
+            : m_loader_root(loader_root)
+            , m_game_paths(working_dir)
+            , m_log(std::move(log))
+        {
+        }
+
+        MountPipeline(const MountPipeline&) = delete;
+        MountPipeline& operator=(const MountPipeline&) = delete;
+
+        // called with each IoStore container (base path) just before it is mounted
+        std::function<void(const fs::path&)> before_mount;
+
+        const fs::path&     loader_root() const { return m_loader_root; }
+        const MountTimings& timings()     const { return m_timings; }
+
+        // copies, since other mods' API calls can mount from any thread while run() is going
+        LoaderConfig
+        config() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_config;
+        }
+
+        std::vector<fs::path>
+        mounted() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_mounted;
+        }
+
+        std::vector<ModActorClass>
+        actor_classes() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_actor_classes;
+        }
+
+        // estimated engine memory per mod, including containers mounted later by mount = lazy
+        ResidentLedger
+        resident() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_resident;
+        }
+
+        // bumped by every container handed to the engine, so lookups that failed before it can
+        // be retried
+        uint32_t mount_generation() const { return m_mount_generation.load(std::memory_order_acquire); }
+
+        // Mounts `path` (a .pak or .utoc) at `order` on behalf of another mod: right away once the
+        // engine's mount functions are known, otherwise by mount_queued_external(). Returns the
+        // record id, or 0 with `err`.
+        uint32_t
+        mount_external(const fs::path& path, int order, std::string& err)
+        {
+            MountEntry e;
+            e.path  = path.lexically_normal();
+            e.order = order;
+            if (iequals(e.path.extension().wstring(), L".pak")) {
+                e.kind = ContainerKind::Pak;
+            } else if (iequals(e.path.extension().wstring(), L".utoc")) {
+                e.kind = ContainerKind::IoStore;
+            } else {
+                err = "not a .pak or .utoc";
+                return 0;
+            }
+            if (!file_exists(e.path)) {
+                err = "file not found";
+                return 0;
+            }
+            e.mod_dir  = e.path.parent_path();
+            e.mod_name = e.mod_dir.filename().wstring();
+            e.name     = e.path.stem().wstring();
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            fs::path target = e.path;
+            if (e.kind == ContainerKind::IoStore) {
+                target.replace_extension(L"");
+            }
+            e.game_path = m_game_paths.intern(target);
+
+            MountRecord& r  = add_record(e, true);
+            uint32_t     id = r.id;
+            if (!backend_ready(e.kind)) {
+                info(L"Queued {} at order {} for another mod until the engine can mount it\n", e.path.filename().wstring(), order);
+                m_external_queue.push_back(QueuedMount{ id, std::move(e) });
+                return id;
+            }
+
+            info(L"Mounting {} at order {} for another mod\n", e.path.filename().wstring(), order);
+            mount_into_record(e, r);
+            return id;
+        }
+
+        // mounts what mount_external() queued before the engine was ready; returns their ids
+        std::vector<uint32_t>
+        mount_queued_external()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            std::vector<uint32_t> done;
+            for (const auto& q : m_external_queue) {
+                if (!backend_ready(q.entry.kind)) {
+                    continue;
+                }
+                info(L"Mounting queued {} at order {} for another mod\n", q.entry.path.filename().wstring(), q.entry.order);
+                mount_into_record(q.entry, m_records[q.id - 1]);
+                done.push_back(q.id);
+            }
+            m_external_queue.erase(std::remove_if(m_external_queue.begin(), m_external_queue.end(),
+                                                  [&](const QueuedMount& q) { return m_records[q.id - 1].state != MountState::Queued; }),
+                                   m_external_queue.end());
+            return done;
+        }
+
+        bool
+        find_record(uint32_t id, MountRecord& out) const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (id == 0 || id > m_records.size()) {
+                return false;
+            }
+            out = m_records[id - 1];
+            return true;
+        }
+
+        std::vector<MountRecord>
+        records() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_records;
+        }
+
+        // containers deferred by mount = lazy that are still not mounted
+        size_t
+        pending_lazy_mounts() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_lazy.pending();
+        }
+
+        // true when mount = lazy still holds back the container of `object_path`'s package
+        bool
+        deferred_until_first_use(std::wstring_view object_path) const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_lazy.pending() && m_lazy.waiting(package_key(path_to_utf8(fs::path(object_path))));
+        }
+
+        void
+        load_config()
+        {
+            const fs::path path = m_loader_root / L"config.ini";
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            std::vector<std::string> warnings;
+            m_config = load_loader_config(path, warnings);
+            for (const auto& w : warnings) {
+                warn(L"{}: {}\n", path.filename().wstring(), widen_ascii(w));
+            }
+            // a first-use mount runs on the thread that loads the class, with the pipeline locked
+            if (m_config.mount == MountMode::Lazy && m_config.verify == VerifyMode::Block) {
+                warn(L"{}: verify = block hashes every container before it mounts; ignoring mount = lazy\n",
+                     path.filename().wstring());
+                m_config.mount = MountMode::Eager;
+            }
+
+            const fs::path keys_path = m_loader_root / L"keys.txt";
+            warnings.clear();
+            m_key_ring.load(keys_path, warnings);
+            for (const auto& w : warnings) {
+                warn(L"{}: {}\n", keys_path.filename().wstring(), widen_ascii(w));
+            }
+            if (m_key_ring.size()) {
+                info(L"Loaded {} container key(s) from {}\n", m_key_ring.size(), keys_path.filename().wstring());
+            }
+        }
+
+        // discovers, plans and mounts every user mod; load_config() first
+        void
+        run(const MountBackend& backend)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_backend = backend;
+            m_timings = MountTimings{};
+
+            auto t = std::chrono::steady_clock::now();
+            auto lap = [&t](double& phase) {
+                auto now = std::chrono::steady_clock::now();
+                phase    = std::chrono::duration<double>(now - t).count();
+                t        = now;
+            };
+
+            auto mods = discover_mod_dirs(m_loader_root);
+            lap(m_timings.discover);
+            if (mods.empty()) {
+                info(L"No user mods found under {}\n", m_loader_root.wstring());
+                return;
+            }
+
+            info(L"Found {} user mod(s)\n", (int)mods.size());
+
+            const fs::path cache_path = m_loader_root / L".hashcache";
+
+            HashCache cache;
+            cache.load(cache_path);
+
+            extract_zip_mods(mods, cache);
+            lap(m_timings.zip);
+
+            std::vector<MountEntry>& plan = m_plan;
+            plan.clear();
+            for (size_t mod_index = 0; mod_index < mods.size(); ++mod_index) {
+                const auto& mod   = mods[mod_index];
+                int         order = kBaseOrder + (int)(mod_index);
+
+                if (mod.dir.empty()) {
+                    continue; // zip mod that failed to extract, already logged
+                }
+
+                if (!plan_mod_folder(mod, order, plan)) {
+                    warn(L"No .pak or .utoc/.ucas found in {}\n", mod.path.wstring());
+                }
+            }
+            lap(m_timings.plan);
+
+            dedupe_containers(plan, cache);
+
+            if (!cache.save(cache_path)) {
+                warn(L"Failed to write hash cache: {}\n", cache_path.wstring());
+            }
+            lap(m_timings.dedupe);
+
+            for (size_t i : intern_game_paths(plan, m_game_paths)) {
+                warn(L"Could not compute relative path for: {}\n", plan[i].path.wstring());
+            }
+            lap(m_timings.intern);
+
+            m_deferred.assign(plan.size(), 0);
+            if (m_config.mount == MountMode::Lazy) {
+                defer_containers();
+            }
+            lap(m_timings.index);
+
+            const fs::path* current_dir = nullptr;
+            for (size_t i = 0; i < plan.size(); ++i) {
+                const auto& e = plan[i];
+                if (e.skip) {
+                    continue;
+                }
+                if (m_deferred[i]) {
+                    queue_actor_spawns(i);
+                    continue;
+                }
+
+                if (!current_dir || *current_dir != e.mod_dir) {
+                    current_dir = &e.mod_dir;
+                    info(L"Mounting mod: {} (order {})\n", e.mod_name, e.order);
+                }
+
+                mount_plan_entry(i);
+            }
+            lap(m_timings.mount);
+
+            if (m_config.overrides) {
+                report_overrides(plan);
+            }
+            log_resident_summary();
+            lap(m_timings.report);
+        }
+
+        // mount = lazy: mounts the deferred containers that provide the package of `object_path`
+        // (and those providing packages they import) the first time it is asked for. Returns
+        // the number of containers mounted. Paths outside /Game/Mods/ return before the lock;
+        // verify = block turns lazy mounting off (see load_config), so no hashing happens here.
+        size_t
+        mount_on_first_use(std::wstring_view object_path)
+        {
+            if (!m_lazy_pending.load(std::memory_order_acquire) || !under_lazy_root(object_path)) {
+                return 0;
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::string key = package_key(path_to_utf8(fs::path(object_path)));
+
+            std::vector<size_t> todo = m_lazy.take(key);
+            if (todo.empty()) {
+                return 0;
+            }
+
+            auto t0 = std::chrono::steady_clock::now();
+            for (size_t i : todo) {
+                mount_plan_entry_now(m_plan[i]);
+            }
+            m_lazy_pending.store(m_lazy.pending(), std::memory_order_release);
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+            info(L"Mounted {} deferred container(s) for {} in {} us, {} still deferred\n", todo.size(),
+                 std::wstring(object_path), (int64_t)us, m_lazy.pending());
+            return todo.size();
+        }
+
+        // mount = lazy fallback when nothing can report first use: mounts every deferred container
+        void
+        mount_all_deferred()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t i : m_lazy.take_all()) {
+                mount_plan_entry_now(m_plan[i]);
+            }
+            m_lazy_pending.store(0, std::memory_order_release);
+        }
+
+        // mount = lazy: at shutdown, names each container nothing asked for. Only class loads
+        // mount a deferred container, so one whose packages were reached some other way (the
+        // package store, a soft reference) was never loaded.
+        void
+        log_still_deferred()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t i : m_lazy.still_deferred()) {
+                warn(L"mount = lazy: {} was never mounted; no class load asked for its packages\n", m_plan[i].path.wstring());
+            }
+        }
+
+        void
+        log_verify_result(const fs::path& base, const UcasVerifyResult& r)
+        {
+            if (r.cancelled) {
+                notice(L"Verification of {} cancelled\n", base.filename().wstring());
+                return;
+            }
+
+            if (!r.ok()) {
+                error(L"{} is corrupt: {} bad chunk(s) or block(s)\n", base.wstring(), r.failures);
+                for (const auto& e : r.errors) {
+                    error(L"  {}\n", widen_ascii(e));
+                }
+                return;
+            }
+
+            info(L"Verified {}: {} chunk(s), {} block signature(s), {} MiB read ({} MiB decompressed) in {:.0f} ms ({:.0f} MiB/s)\n",
+                 base.filename().wstring(), r.chunks, r.blocks, r.bytes >> 20, r.hashed >> 20, r.seconds * 1000.0, r.mib_per_s());
+            if (r.chunks_unhashed || r.chunks_skipped) {
+                notice(L"{}: {} chunk(s) without a hash, {} not decodable here (encrypted or unsupported compression)\n",
+                       base.filename().wstring(), r.chunks_unhashed, r.chunks_skipped);
+            }
+        }
+
+    private:
+        template <typename... Args>
+        void notice(std::wstring_view fmt, const Args&... args) { m_log(MountLogLevel::Notice, wformat(fmt, args...)); }
+        template <typename... Args>
+        void info(std::wstring_view fmt, const Args&... args) { m_log(MountLogLevel::Info, wformat(fmt, args...)); }
+        template <typename... Args>
+        void warn(std::wstring_view fmt, const Args&... args) { m_log(MountLogLevel::Warn, wformat(fmt, args...)); }
+        template <typename... Args>
+        void error(std::wstring_view fmt, const Args&... args) { m_log(MountLogLevel::Error, wformat(fmt, args...)); }
+
+        // Checks base.utoc against its .ucas partitions before the engine sees it; a corrupt or
+        // truncated container otherwise only shows up in the Status line after the mount call.
+        bool
+        validate_iostore_container(const fs::path& base, TocHeader* header = nullptr)
+        {
+            auto t0 = std::chrono::steady_clock::now();
+
+            std::string err;
+            TocSummary  toc;
+            if (!check_iostore_container(base, err, &toc)) {
+                error(L"Rejecting IoStore container {}: {}\n", base.wstring(), widen_ascii(err));
+                return false;
+            }
+
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+            notice(L"Validated {}: {} chunk(s), {} block(s), {} partition(s) in {} us\n",
+                   base.filename().wstring(), toc.header.entry_count, toc.header.compressed_block_entry_count,
+                   toc.header.partition_count, (int64_t)us);
+
+            if ((toc.header.container_flags & TocEncrypted) && !m_key_ring.find(toc.header.encryption_key_guid)) {
+                warn(L"{} is encrypted with key {}, which is not in keys.txt\n", base.filename().wstring(),
+                     widen_ascii(guid_to_string(toc.header.encryption_key_guid)));
+            }
+            if (header) {
+                *header = toc.header;
+            }
+            return true;
+        }
+
+        // Finds the key for an encrypted container in keys.txt and checks it against the
+        // container, so a missing or wrong key is reported here instead of as a failed mount
+        // inside the engine. Unencrypted containers get the zero GUID and key the engine expects.
+        bool
+        resolve_container_key(const fs::path& base, const TocHeader& header, POD::FGuid& guid, POD::FAES& key)
+        {
+            guid = POD::FGuid{};
+            key  = POD::FAES{};
+            if (!(header.container_flags & TocEncrypted)) {
+                return true;
+            }
+
+            std::string      err;
+            IoStoreContainer c;
+            if (!c.open(base, err)) {
+                error(L"Rejecting IoStore container {}: {}\n", base.wstring(), widen_ascii(err));
+                return false;
+            }
+
+            const uint8_t* id    = header.encryption_key_guid;
+            const uint8_t* bytes = m_key_ring.find(id);
+            if (!bytes) {
+                error(L"Skipping {}: no key for encryption key GUID {} in keys.txt\n", base.filename().wstring(),
+                      widen_ascii(guid_to_string(id)));
+                return false;
+            }
+
+            auto t0 = std::chrono::steady_clock::now();
+
+            std::string detail;
+            KeyCheck    check = check_container_key(c, bytes, detail);
+
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+            if (check == KeyCheck::WrongKey) {
+                error(L"Rejecting {}: wrong key for {} in keys.txt: {}\n", base.filename().wstring(),
+                      widen_ascii(guid_to_string(id)), widen_ascii(detail));
+                return false;
+            }
+            if (check == KeyCheck::Unverifiable) {
+                warn(L"{}: cannot check the key for {} ({}), mounting anyway\n", base.filename().wstring(),
+                     widen_ascii(guid_to_string(id)), widen_ascii(detail));
+            } else {
+                notice(L"{}: key {} checked in {} us\n", base.filename().wstring(), widen_ascii(guid_to_string(id)), (int64_t)us);
+            }
+
+            guid.A = rd_le32(id);
+            guid.B = rd_le32(id + 4);
+            guid.C = rd_le32(id + 8);
+            guid.D = rd_le32(id + 12);
+            std::memcpy(key.Key, bytes, sizeof(key.Key));
+            return true;
+        }
+
+        // verify = block: hashes the whole container before the engine sees it
+        bool
+        verify_before_mount(const fs::path& base)
+        {
+            if (m_config.verify != VerifyMode::Block) {
+                return true;
+            }
+
+            std::string      err;
+            UcasVerifyResult r;
+            if (!verify_iostore_container(base, r, err)) {
+                error(L"Rejecting IoStore container {}: {}\n", base.wstring(), widen_ascii(err));
+                return false;
+            }
+
+            log_verify_result(base, r);
+            if (!r.ok()) {
+                error(L"Rejecting IoStore container {}: contents do not match its TOC\n", base.wstring());
+                return false;
+            }
+            return true;
+        }
+
+        void
+        account_resident(const MountEntry& e, const fs::path& base, const PakSummary* pak, bool load_index)
+        {
+            std::string  err;
+            ResidentCost cost;
+            if (!estimate_container_resident(base, pak, load_index, cost, err)) {
+                warn(L"Cannot estimate resident memory of {}: {}\n", e.name, widen_ascii(err));
+                return;
+            }
+            m_resident.add(e.mod_name, e.name, cost);
+        }
+
+        // One line for the total, one per component, then the mods that cost the most.
+        void
+        log_resident_summary()
+        {
+            const ResidentCost& t = m_resident.total();
+            if (m_resident.entries().empty()) {
+                return;
+            }
+
+            auto kib = [](uint64_t b) { return (b + 1023) / 1024; };
+            info(L"Estimated resident memory of {} mounted container(s): {} KiB, {} open file handle(s)\n",
+                 m_resident.entries().size(), kib(t.total()), t.open_handles);
+            info(L"  chunk map {} KiB, blocks {} KiB, signatures {} KiB, directory index {} KiB, package store {} KiB, partitions {} KiB, compression methods {} KiB, pak index {} KiB\n",
+                 kib(t.chunk_map), kib(t.compression_blocks), kib(t.block_signatures), kib(t.directory_index),
+                 kib(t.package_store), kib(t.partitions), kib(t.compression_methods), kib(t.pak_index));
+
+            for (const auto& [mod, cost] : m_resident.largest_mods(5)) {
+                info(L"  {}: {} KiB\n", mod, kib(cost.total()));
+            }
+        }
+
+        void
+        mount_one_pak(const MountEntry& e, MountRecord& r)
+        {
+            if (!m_backend.pak_platform_file || !m_backend.pak_mount) {
+                warn(L"Pak mount unavailable (self={:p}, fn={:p})\n", m_backend.pak_platform_file, (void*)m_backend.pak_mount);
+                r.message = L"pak mount unavailable";
+                return;
+            }
+
+            std::string err;
+            PakSummary  pak;
+            if (!read_pak_summary(e.path, pak, err)) {
+                error(L"Rejecting pak {}: {}\n", e.path.filename().wstring(), widen_ascii(err));
+                r.message = widen_ascii(err);
+                return;
+            }
+
+            // the engine mounts a sibling .utoc/.ucas together with the pak
+            fs::path base = e.path;
+            base.replace_extension(L"");
+            bool has_utoc = file_exists(base_to_ext(base, L".utoc"));
+            if (has_utoc && (!validate_iostore_container(base) || !verify_before_mount(base))) {
+                r.message = L"sibling .utoc/.ucas rejected before mounting";
+                return;
+            }
+
+            PakMountMode mode = pak_mount_mode(pak, has_utoc);
+            if (mode == PakMountMode::Skip) {
+                warn(L"Skipping {}: pak has no entries and no .utoc\n", e.path.filename().wstring());
+                r.message = L"pak has no entries and no .utoc";
+                return;
+            }
+            if (has_utoc && before_mount) {
+                before_mount(base);
+            }
+
+            notice(L"{}: pak v{}, {} entries, mount point {}\n", e.path.filename().wstring(), pak.info.version,
+                   pak.entry_count, widen_ascii(pak.mount_point));
+
+            bool ok = m_backend.pak_mount(
+                m_backend.pak_platform_file,
+                e.game_path.data(),
+                e.order,
+                nullptr,
+                mode == PakMountMode::LoadIndex
+            );
+
+            r.state   = ok ? MountState::Mounted : MountState::Failed;
+            r.message = ok ? L"OK" : L"FPakPlatformFile::Mount failed";
+            if (!ok) {
+                return;
+            }
+
+            account_resident(e, base, &pak, mode == PakMountMode::LoadIndex);
+            if (has_utoc) {
+                m_mounted.push_back(base);
+            }
+        }
+
+        void
+        mount_one_utoc_ucas(const MountEntry& e, MountRecord& r)
+        {
+            if (!m_backend.io_dispatcher || !m_backend.io_mount) {
+                warn(L"IoStore mount unavailable (self={:p}, fn={:p})\n", m_backend.io_dispatcher, (void*)m_backend.io_mount);
+                r.message = L"IoStore mount unavailable";
+                return;
+            }
+
+            fs::path base = e.path;
+            base.replace_extension(L"");
+
+            if (!file_exists(base_to_ext(base, L".utoc")) || !has_ucas_any(base)) {
+                warn(L"Missing IoStore pair for base: {}\n", base.wstring());
+                r.message = L"missing .utoc or .ucas";
+                return;
+            }
+
+            TocHeader  header;
+            POD::FGuid guid{};
+            POD::FAES  key{};
+            if (!validate_iostore_container(base, &header) || !resolve_container_key(base, header, guid, key) ||
+                !verify_before_mount(base)) {
+                r.message = L"rejected before mounting";
+                return;
+            }
+
+            if (before_mount) {
+                before_mount(base);
+            }
+
+            POD::FIoEnvironment env(e.game_path, e.order);
+            POD::FIoStatus      status{};
+
+            m_backend.io_mount(m_backend.io_dispatcher, &status, &env, &guid, &key);
+
+            r.state    = status.ErrorCode == POD::EIoErrorCode::Ok ? MountState::Mounted : MountState::Failed;
+            r.io_error = (int32_t)status.ErrorCode;
+            r.message  = status.ErrorMessage;
+            if (r.state != MountState::Mounted) {
+                return;
+            }
+
+            account_resident(e, base, nullptr, false);
+            m_mounted.push_back(base);
+        }
+
+        // mount = lazy: indexes the plan's IoStore containers and marks those that can wait. A
+        // container that one mounted now imports from is mounted now too, since those imports
+        // are resolved through the package store, not through a class load the mod sees.
+        void
+        defer_containers()
+        {
+            size_t eager = 0;
+            for (size_t i = 0; i < m_plan.size(); ++i) {
+                const MountEntry& e = m_plan[i];
+                if (e.skip || e.kind != ContainerKind::IoStore) {
+                    continue;
+                }
+
+                fs::path base = e.path;
+                base.replace_extension(L"");
+
+                std::string reason;
+                if (m_lazy.add(i, base, reason)) {
+                    m_deferred[i] = 1;
+                } else {
+                    notice(L"Mounting {} now: {}\n", e.name, widen_ascii(reason));
+                    ++eager;
+                }
+            }
+            if (!m_lazy.pending()) {
+                info(L"mount = lazy: every container is mounted now\n");
+                return;
+            }
+
+            // what the containers mounted now import, a pak's sibling .utoc/.ucas included
+            std::vector<uint64_t> imports;
+            for (size_t i = 0; i < m_plan.size(); ++i) {
+                const MountEntry& e = m_plan[i];
+                if (e.skip || m_deferred[i]) {
+                    continue;
+                }
+
+                fs::path base = e.path;
+                base.replace_extension(L"");
+                if (e.kind == ContainerKind::Pak && !file_exists(base_to_ext(base, L".utoc"))) {
+                    continue;
+                }
+
+                IoStoreContainer c;
+                std::string      err;
+                if (c.open(base, err)) {
+                    auto ids = container_imports(c);
+                    imports.insert(imports.end(), ids.begin(), ids.end());
+                }
+            }
+
+            for (size_t i : m_lazy.take_imported(imports)) {
+                notice(L"Mounting {} now: a container mounted at startup imports from it\n", m_plan[i].name);
+                m_deferred[i] = 0;
+                ++eager;
+            }
+            info(L"mount = lazy: deferring {} container(s) until first use ({} package(s) indexed), {} mounted now\n",
+                 m_lazy.pending(), m_lazy.packages(), eager);
+            m_lazy_pending.store(m_lazy.pending(), std::memory_order_release);
+        }
+
+        void
+        queue_mod_actor_spawn(const std::wstring& mod_name, int order)
+        {
+            // /Game/Mods/<ExampleMod>/ModActor.ModActor_C
+            std::wstring path = L"/Game/Mods/" + mod_name + L"/ModActor.ModActor_C";
+            m_actor_classes.push_back({ std::move(path), order });
+        }
+
+        // the container's ModActors and those of the duplicates skipped in its favour, which may be
+        // named differently
+        void
+        queue_actor_spawns(size_t i)
+        {
+            std::vector<std::wstring> names = container_actor_names(m_plan[i]);
+            names.insert(names.end(), m_duplicate_actors[i].begin(), m_duplicate_actors[i].end());
+
+            for (size_t n = 0; n < names.size(); ++n) {
+                if (std::find(names.begin(), names.begin() + n, names[n]) == names.begin() + n) {
+                    queue_mod_actor_spawn(names[n], m_plan[i].order);
+                }
+            }
+        }
+
+        MountRecord&
+        add_record(const MountEntry& e, bool external)
+        {
+            MountRecord r;
+            r.id       = (uint32_t)m_records.size() + 1;
+            r.path     = e.path;
+            r.kind     = e.kind;
+            r.order    = e.order;
+            r.external = external;
+            m_records.push_back(std::move(r));
+            return m_records.back();
+        }
+
+        bool
+        backend_ready(ContainerKind kind) const
+        {
+            return kind == ContainerKind::Pak ? m_backend.pak_platform_file && m_backend.pak_mount
+                                              : m_backend.io_dispatcher && m_backend.io_mount;
+        }
+
+        void
+        mount_into_record(const MountEntry& e, MountRecord& r)
+        {
+            r.state = MountState::Failed;
+            if (e.kind == ContainerKind::Pak) {
+                mount_one_pak(e, r);
+            } else {
+                mount_one_utoc_ucas(e, r);
+            }
+            m_mount_generation.fetch_add(1, std::memory_order_release);
+        }
+
+        void
+        mount_plan_entry_now(const MountEntry& e)
+        {
+            mount_into_record(e, add_record(e, false));
+        }
+
+        void
+        mount_plan_entry(size_t i)
+        {
+            mount_plan_entry_now(m_plan[i]);
+            queue_actor_spawns(i);
+        }
+
+        void
+        extract_zip_mods(std::vector<ModSource>& mods, HashCache& cache)
+        {
+            const fs::path cache_root = m_loader_root / L".zipcache";
+
+            auto t0 = std::chrono::steady_clock::now();
+            auto results = prepare_zip_mods(mods, cache_root, cache);
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+
+            int n_zips = 0;
+            for (size_t i = 0; i < mods.size(); ++i) {
+                if (!mods[i].is_zip) {
+                    continue;
+                }
+
+                ++n_zips;
+                const auto& r = results[i];
+                if (!r.ok) {
+                    error(L"Failed to extract zip mod {}: {}\n", mods[i].path.filename().wstring(), widen_ascii(r.error));
+                } else if (!r.cached) {
+                    info(L"Extracted zip mod {}: {} file(s), {} KiB\n", mods[i].path.filename().wstring(), (int)r.files, r.bytes / 1024);
+                }
+            }
+
+            if (n_zips) {
+                size_t pruned = prune_zip_cache(cache_root, mods);
+                info(L"Prepared {} zip mod(s) in {} ms ({} stale cache dir(s) removed)\n", n_zips, (int64_t)ms, (int)pruned);
+            }
+        }
+
+        void
+        dedupe_containers(std::vector<MountEntry>& plan, HashCache& cache)
+        {
+            auto t0 = std::chrono::steady_clock::now();
+
+            HashStats stats;
+            auto dups = dedupe_mount_plan(plan, cache, &stats);
+
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+            info(L"Hashed {} container file(s) ({} cached, {} KiB read) in {} ms\n",
+                 (int)stats.files, (int)stats.cached, stats.bytes_hashed / 1024, (int64_t)ms);
+
+            if (stats.failed) {
+                warn(L"{} container file(s) could not be hashed; their containers are not deduplicated\n", (int)stats.failed);
+            }
+
+            m_duplicate_actors.assign(plan.size(), {});
+            for (const auto& d : dups) {
+                const auto& skipped = plan[d.skipped];
+                const auto& kept    = plan[d.kept];
+                for (auto& name : container_actor_names(skipped)) {
+                    m_duplicate_actors[d.kept].push_back(std::move(name));
+                }
+                info(L"Skipping duplicate container {} (order {}): identical to {} (order {})\n",
+                     skipped.path.wstring(), skipped.order, kept.path.wstring(), kept.order);
+            }
+        }
+
+        // Resolves which container wins every chunk across the mounted mods and writes
+        // overrides.txt next to the mods. The index is kept so a later call only re-reads
+        // containers whose .utoc changed.
+        void
+        report_overrides(const std::vector<MountEntry>& plan)
+        {
+            auto t0    = std::chrono::steady_clock::now();
+            auto stats = m_overrides.update(plan);
+
+            const fs::path      report_path = m_loader_root / L"overrides.txt";
+            OverrideReportStats report;
+            bool ok = write_override_report(m_overrides, report_path, &report);
+
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+            info(L"Indexed {} chunk(s) from {} container(s) in {} ms: {} overridden package(s), {} split across mods\n",
+                 stats.chunks, stats.containers, (int64_t)ms, report.contested_packages, report.split_packages);
+
+            if (stats.failed) {
+                warn(L"{} container(s) could not be indexed for the override report\n", stats.failed);
+            }
+            if (!ok) {
+                warn(L"Failed to write override report: {}\n", report_path.wstring());
+            }
+        }
+
+        struct QueuedMount {
+            uint32_t   id = 0;
+            MountEntry entry;
+        };
+
+        fs::path                   m_loader_root;
+        GamePathArena              m_game_paths;
+        LogSink                    m_log;
+        MountBackend               m_backend;
+        LoaderConfig               m_config;
+        KeyRing                    m_key_ring;      // keys.txt: AES keys for encrypted mod containers
+        OverrideIndex              m_overrides;
+        ResidentLedger             m_resident;      // estimated engine memory held by what was mounted
+        MountTimings               m_timings;
+        std::vector<MountEntry>    m_plan;
+        std::vector<uint8_t>       m_deferred;      // mount = lazy: parallel to m_plan
+        std::vector<std::vector<std::wstring>> m_duplicate_actors;   // parallel to m_plan: ModActors of skipped duplicates
+        LazyMountIndex             m_lazy;
+        std::atomic<size_t>        m_lazy_pending{ 0 };   // m_lazy.pending(), for mount_on_first_use() before the lock
+        mutable std::mutex         m_mutex;         // run() against mount_on_first_use() and other mods' API calls
+        std::vector<fs::path>      m_mounted;       // containers the engine mounted, for verify = background
+        std::vector<ModActorClass> m_actor_classes;
+        std::atomic<uint32_t>      m_mount_generation{ 0 };
+        std::vector<MountRecord>   m_records;       // every mount, by id - 1
+        std::vector<QueuedMount>   m_external_queue;   // mount_external() calls made before the engine was ready
+    };
+}
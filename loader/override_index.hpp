@@ -0,0 +1,616 @@
+#pragma once
+
+#include "content_hash.hpp"
+#include "mod_discovery.hpp"
+#include "parallel.hpp"
+#include "utoc.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace loader
+{
+    // FIoChunkId as two integers: the 8-byte id (the FPackageId for package chunks) and
+    // index/padding/type packed into the remaining 4 bytes
+    struct ChunkKey {
+        uint64_t id   = 0;
+        uint32_t tail = 0;
+
+        IoChunkType type() const { return (IoChunkType)(tail >> 24); }
+        bool operator==(const ChunkKey& o) const { return id == o.id && tail == o.tail; }
+    };
+
+    static inline bool
+    is_package_chunk(IoChunkType t)
+    {
+        return t == IoChunkType::ExportBundleData || t == IoChunkType::BulkData ||
+               t == IoChunkType::OptionalBulkData || t == IoChunkType::MemoryMappedBulkData;
+    }
+
+    struct OverrideUpdateStats {
+        size_t containers = 0;   // live after the update
+        size_t parsed     = 0;   // new or changed, TOC read
+        size_t reused     = 0;   // unchanged, kept from the previous update
+        size_t removed    = 0;   // gone or changed, chunks unlinked
+        size_t failed     = 0;   // TOC unreadable
+        size_t chunks     = 0;   // chunk ids indexed after the update
+    };
+
+    // Which container provides each chunk id across all mounted mod containers. Every key keeps
+    // the full list of providers, so the effective winner follows the mount orders and a single
+    // changed container can be swapped out without rebuilding the rest.
+    class OverrideIndex
+    {
+    public:
+        struct Container {
+            fs::path              utoc;
+            std::wstring          mod_name;
+            std::wstring          name;
+            int                   order = 0;
+            uint32_t              seq   = 0;      // plan position; later mounts win order ties
+            FileStamp             stamp;
+            std::vector<ChunkKey> keys;           // in TOC order, keys[i] is TOC entry i
+            std::string           error;
+            bool                  live  = false;
+        };
+
+        // Brings the index in line with `plan`: containers no longer planned, or whose .utoc
+        // changed on disk (size/mtime), are unlinked; new and changed ones are parsed in
+        // parallel and linked; orders of unchanged ones are refreshed in place.
+        OverrideUpdateStats
+        update(const std::vector<MountEntry>& plan)
+        {
+            OverrideUpdateStats stats;
+
+            struct Want {
+                fs::path          utoc;
+                const MountEntry* entry;
+                uint32_t          seq;
+            };
+
+            std::vector<Want> want;
+            for (size_t i = 0; i < plan.size(); ++i) {
+                const auto& e = plan[i];
+                if (e.skip) {
+                    continue;
+                }
+
+                // a mounted pak brings its sibling .utoc with it
+                fs::path utoc = e.path;
+                utoc.replace_extension(L".utoc");
+                if (e.kind == ContainerKind::Pak && !file_exists(utoc)) {
+                    continue;
+                }
+                want.push_back(Want{ std::move(utoc), &e, (uint32_t)i });
+            }
+
+            std::unordered_map<fs::path::string_type, uint32_t> wanted;
+            for (size_t i = 0; i < want.size(); ++i) {
+                wanted.emplace(want[i].utoc.native(), (uint32_t)i);
+            }
+
+            for (uint32_t c = 0; c < m_containers.size(); ++c) {
+                auto& ct = m_containers[c];
+                if (ct.live && wanted.find(ct.utoc.native()) == wanted.end()) {
+                    unlink(c);
+                    m_by_path.erase(ct.utoc.native());
+                    m_free_containers.push_back(c);
+                    ++stats.removed;
+                }
+            }
+
+            std::vector<uint32_t> todo;
+            for (const auto& w : want) {
+                FileStamp stamp;
+                bool      have_stamp = stat_file(w.utoc, stamp);
+
+                uint32_t c;
+                auto it = m_by_path.find(w.utoc.native());
+                if (it != m_by_path.end()) {
+                    c = it->second;
+                    if (have_stamp && m_containers[c].stamp == stamp) {
+                        ++stats.reused;
+                        stats.failed += !m_containers[c].error.empty();
+                    } else {
+                        stats.removed += m_containers[c].error.empty();
+                        unlink(c);
+                        todo.push_back(c);
+                    }
+                } else {
+                    c = alloc_container();
+                    m_by_path.emplace(w.utoc.native(), c);
+                    todo.push_back(c);
+                }
+
+                auto& ct    = m_containers[c];
+                ct.utoc     = w.utoc;
+                ct.mod_name = w.entry->mod_name;
+                ct.name     = w.entry->name;
+                ct.order    = w.entry->order;
+                ct.seq      = w.seq;
+                ct.stamp    = stamp;
+                ct.live     = true;
+            }
+
+            parallel_for(todo.size(), [&](size_t k) {
+                read_keys(m_containers[todo[k]]);
+            });
+
+            for (uint32_t c : todo) {
+                auto& ct = m_containers[c];
+                if (!ct.error.empty()) {
+                    ++stats.failed;
+                    continue;
+                }
+                for (const auto& k : ct.keys) {
+                    link(k, c);
+                }
+                ++stats.parsed;
+            }
+
+            stats.containers = want.size();
+            stats.chunks     = m_live_keys;
+            return stats;
+        }
+
+        const std::vector<Container>& containers() const { return m_containers; }
+
+        // the provider that wins `head`'s chain: highest order, later plan position on ties
+        uint32_t
+        winner(uint32_t head, bool* tie = nullptr) const
+        {
+            uint32_t best = kNil;
+            for (uint32_t n = head; n != kNil; n = m_nodes[n].next) {
+                uint32_t c = m_nodes[n].container;
+                if (best == kNil) {
+                    best = c;
+                    continue;
+                }
+
+                const auto& a = m_containers[c];
+                const auto& b = m_containers[best];
+                if (a.order > b.order || (a.order == b.order && a.seq > b.seq)) {
+                    best = c;
+                }
+            }
+
+            if (tie) {
+                *tie = false;
+                for (uint32_t n = head; n != kNil; n = m_nodes[n].next) {
+                    uint32_t c = m_nodes[n].container;
+                    if (c != best && m_containers[c].order == m_containers[best].order) {
+                        *tie = true;
+                    }
+                }
+            }
+            return best;
+        }
+
+        // fn(key, head) for every chunk id with two or more providers; walk `head` with providers()
+        template <typename Fn>
+        void
+        for_each_contested(Fn&& fn) const
+        {
+            for (const auto& s : m_slots) {
+                if (s.head != kNil && s.head != kEmpty && m_nodes[s.head].next != kNil) {
+                    fn(ChunkKey{ s.id, s.tail }, s.head);
+                }
+            }
+        }
+
+        template <typename Fn>
+        void
+        providers(uint32_t head, Fn&& fn) const
+        {
+            for (uint32_t n = head; n != kNil; n = m_nodes[n].next) {
+                fn(m_nodes[n].container);
+            }
+        }
+
+        // container currently providing `key`, or -1
+        int64_t
+        resolve(const ChunkKey& key) const
+        {
+            if (m_slots.empty()) {
+                return -1;
+            }
+
+            const Slot& s = m_slots[find(key)];
+            if (s.head == kEmpty || s.head == kNil) {
+                return -1;
+            }
+            return winner(s.head);
+        }
+
+        size_t chunk_count() const { return m_live_keys; }
+        size_t table_bytes() const { return m_slots.size() * sizeof(Slot) + m_nodes.size() * sizeof(Node); }
+
+    private:
+        static constexpr uint32_t kEmpty = 0xFFFFFFFF;   // slot never used
+        static constexpr uint32_t kNil   = 0xFFFFFFFE;   // end of a provider chain / key without providers
+
+        struct Slot {
+            uint64_t id   = 0;
+            uint32_t tail = 0;
+            uint32_t head = kEmpty;
+        };
+
+        struct Node {
+            uint32_t container;
+            uint32_t next;
+        };
+
+        static uint64_t
+        hash(const ChunkKey& k)
+        {
+            uint64_t h = k.id ^ ((uint64_t)k.tail * 0x9E3779B97F4A7C15ull);
+            h ^= h >> 33;
+            h *= 0xFF51AFD7ED558CCDull;
+            h ^= h >> 33;
+            return h;
+        }
+
+        // linear probing; returns the key's slot or the empty slot where it would go
+        size_t
+        find(const ChunkKey& k) const
+        {
+            size_t mask = m_slots.size() - 1;
+            for (size_t i = hash(k) & mask;; i = (i + 1) & mask) {
+                const Slot& s = m_slots[i];
+                if (s.head == kEmpty || (s.id == k.id && s.tail == k.tail)) {
+                    return i;
+                }
+            }
+        }
+
+        // keeps the load factor at or below 1/2; keys left without providers are dropped on growth
+        void
+        reserve(size_t keys)
+        {
+            size_t cap = (std::max)((size_t)64, m_slots.size());
+            while (cap < keys * 2) {
+                cap <<= 1;
+            }
+            if (cap <= m_slots.size()) {
+                return;
+            }
+
+            std::vector<Slot> old;
+            old.swap(m_slots);
+            m_slots.assign(cap, Slot{});
+            m_used = 0;
+
+            for (const auto& s : old) {
+                if (s.head != kEmpty && s.head != kNil) {
+                    Slot& d = m_slots[find(ChunkKey{ s.id, s.tail })];
+                    d = s;
+                    ++m_used;
+                }
+            }
+        }
+
+        void
+        link(const ChunkKey& k, uint32_t container)
+        {
+            if ((m_used + 1) * 2 > m_slots.size()) {
+                reserve(m_used + 1);
+            }
+
+            Slot& s = m_slots[find(k)];
+            if (s.head == kEmpty) {
+                s.id   = k.id;
+                s.tail = k.tail;
+                s.head = kNil;
+                ++m_used;
+            }
+            if (s.head == kNil) {
+                ++m_live_keys;
+            }
+
+            uint32_t n;
+            if (m_free_nodes != kNil) {
+                n = m_free_nodes;
+                m_free_nodes = m_nodes[n].next;
+            } else {
+                n = (uint32_t)m_nodes.size();
+                m_nodes.push_back(Node{});
+            }
+
+            m_nodes[n] = Node{ container, s.head };
+            s.head     = n;
+        }
+
+        void
+        unlink(uint32_t container)
+        {
+            auto& ct = m_containers[container];
+            for (const auto& k : ct.keys) {
+                if (m_slots.empty()) {
+                    break;
+                }
+
+                Slot& s = m_slots[find(k)];
+                for (uint32_t* pn = &s.head; *pn != kNil && *pn != kEmpty; pn = &m_nodes[*pn].next) {
+                    if (m_nodes[*pn].container == container) {
+                        uint32_t dead = *pn;
+                        *pn = m_nodes[dead].next;
+                        m_nodes[dead].next = m_free_nodes;
+                        m_free_nodes = dead;
+                        break;
+                    }
+                }
+                if (s.head == kNil) {
+                    --m_live_keys;
+                }
+            }
+
+            ct.keys.clear();
+            ct.keys.shrink_to_fit();
+            ct.live = false;
+        }
+
+        uint32_t
+        alloc_container()
+        {
+            if (!m_free_containers.empty()) {
+                uint32_t c = m_free_containers.back();
+                m_free_containers.pop_back();
+                return c;
+            }
+            m_containers.emplace_back();
+            return (uint32_t)m_containers.size() - 1;
+        }
+
+        static void
+        read_keys(Container& ct)
+        {
+            ct.keys.clear();
+            ct.error.clear();
+
+            MappedFile file;
+            if (!file.open(ct.utoc)) {
+                ct.error = "cannot open .utoc";
+                return;
+            }
+
+            TocView toc;
+            if (!toc.parse(file.data(), file.size(), ct.error)) {
+                return;
+            }
+
+            ct.keys.resize(toc.chunk_count());
+            for (uint32_t i = 0; i < toc.chunk_count(); ++i) {
+                IoChunkId id = toc.chunk_id(i);
+                ct.keys[i]   = ChunkKey{ id.id(), rd_le32(id.p + 8) };
+            }
+        }
+
+        std::vector<Container>                              m_containers;
+        std::vector<uint32_t>                               m_free_containers;
+        std::unordered_map<fs::path::string_type, uint32_t> m_by_path;
+        std::vector<Slot>                                   m_slots;
+        std::vector<Node>                                   m_nodes;
+        uint32_t                                            m_free_nodes = kNil;
+        size_t                                              m_used       = 0;   // occupied slots, including keys without providers
+        size_t                                              m_live_keys  = 0;
+    };
+
+    struct OverrideReportStats {
+        size_t contested_chunks   = 0;
+        size_t contested_packages = 0;
+        size_t split_packages     = 0;   // chunks of one package won by different containers
+        size_t order_ties         = 0;   // decided by plan position only
+    };
+
+    // Writes one line per contested package (or non-package chunk): the winner, the shadowed
+    // containers and the package's file path from the winner's directory index when it has one.
+    // A package whose chunks are won by different containers is flagged [split], since the
+    // engine then mixes one mod's export data with another mod's bulk data.
+    static inline bool
+    write_override_report(const OverrideIndex& index, const fs::path& out_path, OverrideReportStats* out_stats = nullptr)
+    {
+        // one record per contested chunk; providers live in a shared pool
+        struct Hit {
+            ChunkKey key;
+            uint32_t winner;
+            uint32_t prov_begin;
+            uint32_t prov_count;
+            bool     tie;
+        };
+
+        std::vector<Hit>      hits;
+        std::vector<uint32_t> pool;
+
+        index.for_each_contested([&](const ChunkKey& key, uint32_t head) {
+            Hit h{ key, 0, (uint32_t)pool.size(), 0, false };
+            h.winner = index.winner(head, &h.tie);
+            index.providers(head, [&](uint32_t c) { pool.push_back(c); });
+            h.prov_count = (uint32_t)pool.size() - h.prov_begin;
+            hits.push_back(h);
+        });
+
+        // chunks of one package are adjacent after sorting by id; other chunk types stay alone
+        auto group_tail = [](const ChunkKey& k) { return is_package_chunk(k.type()) ? 0u : k.tail; };
+        std::sort(hits.begin(), hits.end(), [&](const Hit& a, const Hit& b) {
+            if (a.key.id != b.key.id) {
+                return a.key.id < b.key.id;
+            }
+            return group_tail(a.key) < group_tail(b.key);
+        });
+
+        struct Row {
+            ChunkKey    key;
+            uint32_t    winner;          // winner of the export bundle when contested, else of the first chunk
+            uint32_t    others_begin;    // other winners, then shadowed containers, in `lists`
+            uint32_t    others_count;
+            uint32_t    shadowed_count;
+            bool        tie;
+            std::string path;
+        };
+
+        OverrideReportStats   stats;
+        std::vector<Row>      rows;
+        std::vector<uint32_t> lists;
+
+        auto add_unique = [&](uint32_t begin, uint32_t c) {
+            if (std::find(lists.begin() + begin, lists.end(), c) == lists.end()) {
+                lists.push_back(c);
+            }
+        };
+
+        for (size_t i = 0; i < hits.size();) {
+            size_t j = i + 1;
+            while (j < hits.size() && hits[j].key.id == hits[i].key.id && group_tail(hits[j].key) == group_tail(hits[i].key)) {
+                ++j;
+            }
+
+            Row row{ hits[i].key, hits[i].winner, (uint32_t)lists.size(), 0, 0, false, {} };
+            for (size_t k = i; k < j; ++k) {
+                if (hits[k].key.type() == IoChunkType::ExportBundleData) {
+                    row.key    = hits[k].key;
+                    row.winner = hits[k].winner;
+                }
+                row.tie |= hits[k].tie;
+            }
+
+            for (size_t k = i; k < j; ++k) {
+                if (hits[k].winner != row.winner) {
+                    add_unique(row.others_begin, hits[k].winner);
+                }
+            }
+            row.others_count = (uint32_t)lists.size() - row.others_begin;
+
+            for (size_t k = i; k < j; ++k) {
+                for (uint32_t p = 0; p < hits[k].prov_count; ++p) {
+                    uint32_t c = pool[hits[k].prov_begin + p];
+                    if (c != row.winner) {
+                        add_unique(row.others_begin, c);
+                    }
+                }
+            }
+            row.shadowed_count = (uint32_t)lists.size() - row.others_begin - row.others_count;
+
+            stats.contested_chunks   += j - i;
+            stats.contested_packages += is_package_chunk(row.key.type());
+            stats.split_packages     += row.others_count != 0;
+            stats.order_ties         += row.tie;
+
+            rows.push_back(std::move(row));
+            i = j;
+        }
+
+        // package file names, from the directory index of each winning container
+        const auto& containers = index.containers();
+        std::unordered_map<uint32_t, std::vector<size_t>> by_winner;
+        for (size_t r = 0; r < rows.size(); ++r) {
+            if (rows[r].key.type() == IoChunkType::ExportBundleData) {
+                by_winner[rows[r].winner].push_back(r);
+            }
+        }
+
+        std::vector<std::pair<uint32_t, std::vector<size_t>>> jobs(by_winner.begin(), by_winner.end());
+        parallel_for(jobs.size(), [&](size_t j) {
+            const auto& ct = containers[jobs[j].first];
+
+            std::unordered_map<uint64_t, size_t> wanted;
+            for (size_t r : jobs[j].second) {
+                wanted.emplace(rows[r].key.id, r);
+            }
+
+            MappedFile        file;
+            TocView           toc;
+            TocDirectoryIndex dir;
+            std::string       err;
+            if (!file.open(ct.utoc) || !toc.parse(file.data(), file.size(), err) || !toc.indexed() || toc.encrypted() ||
+                !dir.parse(toc.directory_index(), toc.directory_index_size(), err)) {
+                return;
+            }
+
+            dir.for_each_file([&](std::string_view p, uint32_t entry) {
+                if (entry >= ct.keys.size() || ct.keys[entry].type() != IoChunkType::ExportBundleData) {
+                    return;
+                }
+                auto it = wanted.find(ct.keys[entry].id);
+                if (it != wanted.end()) {
+                    rows[it->second].path.assign(p);
+                }
+            });
+        });
+
+        std::sort(rows.begin(), rows.end(), [&](const Row& a, const Row& b) {
+            if (a.winner != b.winner) {
+                return containers[a.winner].seq < containers[b.winner].seq;
+            }
+            return a.path != b.path ? a.path < b.path : a.key.id < b.key.id;
+        });
+
+        std::vector<std::string> labels(containers.size());
+        for (size_t c = 0; c < containers.size(); ++c) {
+            const auto& ct = containers[c];
+            if (ct.live) {
+                labels[c] = path_to_utf8(fs::path(ct.mod_name)) + "/" + path_to_utf8(fs::path(ct.name)) + "@" + std::to_string(ct.order);
+            }
+        }
+
+        std::string buf;
+        buf.reserve(rows.size() * 96 + 256);
+        buf += "# IoStoreLoaderMod override report\n";
+        buf += "# contested packages " + std::to_string(stats.contested_packages) + ", chunks " + std::to_string(stats.contested_chunks) +
+               ", split packages " + std::to_string(stats.split_packages) + ", order ties " + std::to_string(stats.order_ties) + "\n";
+        buf += "# <package id | chunk id:tail> <winner mod/container@order> < <shadowed ...> <path> [split: <other winners>] [tie]\n";
+
+        char id[48];
+        for (const auto& r : rows) {
+            if (is_package_chunk(r.key.type())) {
+                std::snprintf(id, sizeof(id), "%016llx", (unsigned long long)r.key.id);
+            } else {
+                std::snprintf(id, sizeof(id), "%016llx:%08x", (unsigned long long)r.key.id, r.key.tail);
+            }
+
+            buf += id;
+            buf += ' ';
+            buf += labels[r.winner];
+            buf += " <";
+            for (uint32_t k = 0; k < r.shadowed_count; ++k) {
+                buf += ' ';
+                buf += labels[lists[r.others_begin + r.others_count + k]];
+            }
+            buf += ' ';
+            buf += r.path.empty() ? "-" : r.path;
+            if (r.others_count) {
+                buf += " [split:";
+                for (uint32_t k = 0; k < r.others_count; ++k) {
+                    buf += ' ';
+                    buf += labels[lists[r.others_begin + k]];
+                }
+                buf += ']';
+            }
+            if (r.tie) {
+                buf += " [tie]";
+            }
+            buf += '\n';
+        }
+
+        fs::path tmp = out_path;
+        tmp += L".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            out.write(buf.data(), (std::streamsize)buf.size());
+            if (!out) {
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        fs::rename(tmp, out_path, ec);
+        if (out_stats) {
+            *out_stats = stats;
+        }
+        return !ec;
+    }
+}
@@ -0,0 +1,240 @@
+#pragma once
+
+#include "bytes.hpp"
+#include "mapped_file.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+namespace loader
+{
+    namespace fs = std::filesystem;
+
+    // UE .pak footer (FPakInfo) and primary index, see FPakFile::Initialize / LoadIndex
+
+    static constexpr uint32_t kPakMagic              = 0x5A6F12E1;
+    static constexpr int32_t  kPakVersionFrozenIndex = 9;
+    static constexpr int32_t  kPakVersionPathHash    = 10;
+    static constexpr int32_t  kPakVersionLatest      = 11;  // 4.27, Fnv64BugFix
+
+    struct PakInfo {
+        uint8_t  encryption_key_guid[16] = {};
+        bool     encrypted_index = false;
+        int32_t  version         = 0;
+        uint64_t index_offset    = 0;
+        uint64_t index_size      = 0;
+        uint64_t footer_size     = 0;
+    };
+
+    // Zero-copy view of a pak's footer and primary index. Only the footer and the primary
+    // index bytes are touched; entries, the path hash index and the directory index are not.
+    class PakView
+    {
+    public:
+        bool
+        parse(const uint8_t* data, uint64_t size, std::string& err)
+        {
+            *this = PakView{};
+
+            if (!read_info(data, size)) {
+                err = "no pak footer (bad magic or truncated file)";
+                return false;
+            }
+
+            PakInfo& i = m_info;
+            if (i.version <= 0 || i.version > kPakVersionLatest) {
+                err = "unsupported pak version " + std::to_string(i.version);
+                return false;
+            }
+
+            uint64_t footer_at = size - i.footer_size;
+            if (i.index_offset > footer_at || i.index_size > footer_at - i.index_offset) {
+                err = "pak index lies outside the file";
+                return false;
+            }
+
+            // nothing past the footer can be checked without the key
+            if (i.encrypted_index) {
+                return true;
+            }
+
+            const uint8_t* p   = data + i.index_offset;
+            const uint8_t* end = p + i.index_size;
+
+            if (!read_fstring(p, end, m_mount_point) || end - p < 4) {
+                err = "pak index truncated";
+                return false;
+            }
+
+            int32_t n = (int32_t)rd_le32(p);
+            p += 4;
+            if (n < 0) {
+                err = "negative pak entry count";
+                return false;
+            }
+            m_entry_count = (uint32_t)n;
+
+            if (i.version >= kPakVersionPathHash) {
+                if (end - p < 8 + 4) {
+                    err = "pak index truncated";
+                    return false;
+                }
+
+                m_path_hash_seed = rd_le64(p);
+                p += 8;
+
+                uint32_t has_path_hash = rd_le32(p);
+                p += 4;
+                if (has_path_hash && !read_secondary(p, end, m_path_hash_index)) {
+                    err = "pak index truncated";
+                    return false;
+                }
+
+                if (end - p < 4) {
+                    err = "pak index truncated";
+                    return false;
+                }
+                uint32_t has_dir_index = rd_le32(p);
+                p += 4;
+                if (has_dir_index && !read_secondary(p, end, m_full_dir_index)) {
+                    err = "pak index truncated";
+                    return false;
+                }
+            }
+
+            m_index_readable = true;
+            return true;
+        }
+
+        struct SecondaryIndex {
+            uint64_t offset  = 0;
+            uint64_t size    = 0;
+            bool     present = false;
+        };
+
+        const PakInfo&        info()            const { return m_info; }
+        bool                  index_readable()  const { return m_index_readable; }
+        const FStringView&    mount_point()     const { return m_mount_point; }
+        uint32_t              entry_count()     const { return m_entry_count; }
+        uint64_t              path_hash_seed()  const { return m_path_hash_seed; }
+        const SecondaryIndex& path_hash_index() const { return m_path_hash_index; }
+        const SecondaryIndex& full_dir_index()  const { return m_full_dir_index; }
+
+    private:
+        // The footer size depends on the version: 221 bytes from v8 (five 32-byte compression
+        // method names), one more for v9's frozen-index flag, 61 before v8, 45 before v7's
+        // encryption key GUID. The magic follows the GUID and the encrypted-index flag.
+        bool
+        read_info(const uint8_t* data, uint64_t size)
+        {
+            static constexpr struct { uint32_t size; uint32_t magic_at; } kLayouts[] = {
+                { 221, 17 },
+                { 222, 17 },
+                { 61,  17 },
+                { 45,  1  },
+            };
+
+            for (const auto& l : kLayouts) {
+                if (!data || size < l.size) {
+                    continue;
+                }
+
+                const uint8_t* f = data + size - l.size;
+                if (rd_le32(f + l.magic_at) != kPakMagic) {
+                    continue;
+                }
+
+                int32_t version = (int32_t)rd_le32(f + l.magic_at + 4);
+                bool    fits    = (l.size == 221 && version >= 8 && version != kPakVersionFrozenIndex) ||
+                                  (l.size == 222 && version == kPakVersionFrozenIndex) ||
+                                  (l.size == 61 && version == 7) ||
+                                  (l.size == 45 && version < 7);
+                if (!fits) {
+                    continue;
+                }
+
+                if (l.magic_at == 17) {
+                    std::memcpy(m_info.encryption_key_guid, f, 16);
+                }
+                m_info.encrypted_index = f[l.magic_at - 1] != 0;
+                m_info.version         = version;
+                m_info.index_offset    = rd_le64(f + l.magic_at + 8);
+                m_info.index_size      = rd_le64(f + l.magic_at + 16);
+                m_info.footer_size     = l.size;
+                return true;
+            }
+            return false;
+        }
+
+        // bool present, int64 offset, int64 size, FSHAHash
+        static bool
+        read_secondary(const uint8_t*& p, const uint8_t* end, SecondaryIndex& out)
+        {
+            if (end - p < 8 + 8 + 20) {
+                return false;
+            }
+
+            out.offset  = rd_le64(p);
+            out.size    = rd_le64(p + 8);
+            out.present = true;
+            p += 8 + 8 + 20;
+            return true;
+        }
+
+        PakInfo        m_info;
+        bool           m_index_readable  = false;
+        FStringView    m_mount_point;
+        uint32_t       m_entry_count     = 0;
+        uint64_t       m_path_hash_seed  = 0;
+        SecondaryIndex m_path_hash_index;
+        SecondaryIndex m_full_dir_index;
+    };
+
+    struct PakSummary {
+        PakInfo     info;
+        bool        index_readable = false;   // false when the index is encrypted
+        uint32_t    entry_count    = 0;
+        std::string mount_point;
+    };
+
+    // Maps the pak and reads its footer and primary index.
+    static inline bool
+    read_pak_summary(const fs::path& pak, PakSummary& out, std::string& err)
+    {
+        MappedFile file;
+        if (!file.open(pak)) {
+            err = "cannot open .pak";
+            return false;
+        }
+
+        PakView view;
+        if (!view.parse(file.data(), file.size(), err)) {
+            return false;
+        }
+
+        out.info           = view.info();
+        out.index_readable = view.index_readable();
+        out.entry_count    = view.entry_count();
+        out.mount_point    = view.mount_point().utf8();
+        return true;
+    }
+
+    enum class PakMountMode {
+        LoadIndex,
+        SkipIndex,   // stub pak: mount only for the sibling .utoc/.ucas
+        Skip,        // nothing to mount
+    };
+
+    // IoStore-cooked mods usually ship an empty stub pak; its index has nothing to load.
+    // An encrypted index cannot be inspected, so it is left to the engine.
+    static inline PakMountMode
+    pak_mount_mode(const PakSummary& pak, bool has_utoc)
+    {
+        if (!pak.index_readable || pak.entry_count != 0) {
+            return PakMountMode::LoadIndex;
+        }
+        return has_utoc ? PakMountMode::SkipIndex : PakMountMode::Skip;
+    }
+}
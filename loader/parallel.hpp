@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace loader
+{
+    static inline unsigned
+    worker_count(size_t jobs)
+    {
+        unsigned hw = std::thread::hardware_concurrency();
+        if (hw == 0) {
+            hw = 4;
+        }
+        return (unsigned)std::min<size_t>(hw, jobs);
+    }
+
+    // runs fn(i) for i in [0, n) on up to hardware_concurrency threads; the calling thread takes part
+    template <typename Fn>
+    static inline void
+    parallel_for(size_t n, Fn&& fn)
+    {
+        if (n == 0) {
+            return;
+        }
+
+        unsigned n_workers = worker_count(n);
+        if (n_workers <= 1) {
+            for (size_t i = 0; i < n; ++i) {
+                fn(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next{ 0 };
+        auto worker = [&]() {
+            for (size_t i = next.fetch_add(1); i < n; i = next.fetch_add(1)) {
+                fn(i);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(n_workers - 1);
+        for (unsigned t = 1; t < n_workers; ++t) {
+            threads.emplace_back(worker);
+        }
+
+        worker();
+
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+}
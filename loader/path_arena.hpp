@@ -0,0 +1,148 @@
+#pragma once
+
+#include "mod_discovery.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <cwctype>
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace loader
+{
+    namespace fs = std::filesystem;
+
+    // Interns canonical forward-slash, game-relative (working dir relative) paths into
+    // contiguous blocks of null-terminated wide strings. Views stay valid for the arena's lifetime.
+    class GamePathArena
+    {
+    public:
+        explicit GamePathArena(const fs::path& working_dir)
+            : m_working_dir(working_dir.lexically_normal())
+        {
+            m_prefix = m_working_dir.generic_wstring();
+            if (!m_prefix.empty() && m_prefix.back() != L'/') {
+                m_prefix.push_back(L'/');
+            }
+        }
+
+        GamePathArena(const GamePathArena&) = delete;
+        GamePathArena& operator=(const GamePathArena&) = delete;
+
+        const fs::path& working_dir() const { return m_working_dir; }
+        size_t          count()       const { return m_count; }
+        size_t          bytes()       const { return m_reserved * sizeof(wchar_t); }
+
+        // returns the null-terminated game-relative form of `absolute_path`; falls back to the
+        // absolute path (still forward-slashed) when it does not live under the working dir
+        std::wstring_view
+        intern(const fs::path& absolute_path, bool* out_relative = nullptr)
+        {
+            std::wstring full = absolute_path.lexically_normal().generic_wstring();
+
+            bool relative = starts_with_prefix(full);
+            std::wstring_view rel(full);
+
+            std::wstring slow;
+            if (relative) {
+                rel.remove_prefix(m_prefix.size());
+            } else {
+                // different root spelling (e.g. "..", other drive letter case): let the library decide
+                std::error_code ec;
+                fs::path r = fs::relative(absolute_path, m_working_dir, ec);
+                if (!ec && !r.empty()) {
+                    slow     = r.generic_wstring();
+                    rel      = slow;
+                    relative = true;
+                }
+            }
+
+            if (out_relative) {
+                *out_relative = relative;
+            }
+            return store(rel);
+        }
+
+    private:
+        static constexpr size_t kBlockChars = 16 * 1024;
+
+        bool
+        starts_with_prefix(std::wstring_view s) const
+        {
+            if (m_prefix.size() <= 1 || s.size() <= m_prefix.size()) {
+                return false;
+            }
+
+            for (size_t i = 0; i < m_prefix.size(); ++i) {
+#ifdef _WIN32
+                if (towlower(s[i]) != towlower(m_prefix[i])) {
+#else
+                if (s[i] != m_prefix[i]) {
+#endif
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        std::wstring_view
+        store(std::wstring_view s)
+        {
+            size_t need = s.size() + 1;
+            if (m_cap - m_used < need) {
+                m_cap = (std::max)(kBlockChars, need);
+                m_blocks.emplace_back(new wchar_t[m_cap]);
+                m_reserved += m_cap;
+                m_used      = 0;
+            }
+
+            wchar_t* dst = m_blocks.back().get() + m_used;
+            std::memcpy(dst, s.data(), s.size() * sizeof(wchar_t));
+            dst[s.size()] = L'\0';
+
+            m_used += need;
+            ++m_count;
+            return std::wstring_view(dst, s.size());
+        }
+
+        fs::path                                m_working_dir;
+        std::wstring                            m_prefix;
+        std::vector<std::unique_ptr<wchar_t[]>> m_blocks;
+        size_t                                  m_cap      = 0;
+        size_t                                  m_used     = 0;
+        size_t                                  m_reserved = 0;
+        size_t                                  m_count    = 0;
+    };
+
+    // Interns the path handed to the engine for every planned container: the .pak itself, or the
+    // extension-less base for IoStore containers. Returns the entries not under the working dir.
+    static inline std::vector<size_t>
+    intern_game_paths(std::vector<MountEntry>& plan, GamePathArena& arena)
+    {
+        std::vector<size_t> outside;
+
+        for (size_t i = 0; i < plan.size(); ++i) {
+            auto& e = plan[i];
+            if (e.skip) {
+                continue;
+            }
+
+            fs::path target = e.path;
+            if (e.kind == ContainerKind::IoStore) {
+                target.replace_extension(L"");
+            }
+
+            bool relative = false;
+            e.game_path = arena.intern(target, &relative);
+            if (!relative) {
+                outside.push_back(i);
+            }
+        }
+        return outside;
+    }
+}
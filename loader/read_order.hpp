@@ -0,0 +1,368 @@
+#pragma once
+
+#include "content_hash.hpp"
+#include "mapped_file.hpp"
+#include "utoc.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cwctype>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace loader
+{
+    namespace fs = std::filesystem;
+
+    // Chunks of mod containers in the order a play session first read them, as written by
+    // ReadOrderRecorder and consumed by tools/ucas_reorder.
+    //
+    // read_order.bin, little-endian:
+    //   u32 magic, u32 version, u32 container count, then per container:
+    //   u64 container id, u16 name length, name (UTF-8 file name without extension),
+    //   u32 chunk count, chunk count x 12-byte FIoChunkId
+    static constexpr uint32_t kReadOrderMagic   = 0x4C4F5249;   // "IROL"
+    static constexpr uint32_t kReadOrderVersion = 1;
+
+    struct ReadOrderContainer {
+        uint64_t             container_id = 0;
+        std::string          name;
+        std::vector<uint8_t> chunk_ids;   // 12 bytes per chunk, first read first
+
+        size_t chunk_count() const { return chunk_ids.size() / 12; }
+    };
+
+    struct ReadOrderLog {
+        std::vector<ReadOrderContainer> containers;
+
+        ReadOrderContainer*
+        find(uint64_t container_id, const std::string& name)
+        {
+            for (auto& c : containers) {
+                if (c.container_id == container_id && c.name == name) {
+                    return &c;
+                }
+            }
+            return nullptr;
+        }
+
+        const ReadOrderContainer*
+        find(uint64_t container_id, const std::string& name) const
+        {
+            return const_cast<ReadOrderLog*>(this)->find(container_id, name);
+        }
+    };
+
+    // Adds `more` after what `into` already has: containers it lacks, and for known containers
+    // the chunks it has not seen yet, so earlier sessions keep deciding the order.
+    static inline void
+    merge_read_order(ReadOrderLog& into, const ReadOrderLog& more)
+    {
+        for (const auto& c : more.containers) {
+            ReadOrderContainer* dst = into.find(c.container_id, c.name);
+            if (!dst) {
+                into.containers.push_back(c);
+                continue;
+            }
+
+            std::unordered_set<std::string_view> known;
+            for (size_t i = 0; i < dst->chunk_count(); ++i) {
+                known.emplace(reinterpret_cast<const char*>(dst->chunk_ids.data()) + i * 12, 12);
+            }
+
+            std::vector<uint8_t> added;
+            for (size_t i = 0; i < c.chunk_count(); ++i) {
+                const uint8_t* id = c.chunk_ids.data() + i * 12;
+                if (known.emplace(reinterpret_cast<const char*>(id), 12).second) {
+                    added.insert(added.end(), id, id + 12);
+                }
+            }
+            dst->chunk_ids.insert(dst->chunk_ids.end(), added.begin(), added.end());
+        }
+    }
+
+    static inline bool
+    read_read_order_log(const fs::path& path, ReadOrderLog& out, std::string& err)
+    {
+        out = ReadOrderLog{};
+
+        MappedFile file;
+        if (!file.open(path)) {
+            err = "cannot open " + path_to_utf8(path);
+            return false;
+        }
+
+        const uint8_t* p   = file.data();
+        const uint8_t* end = p + file.size();
+        auto have = [&](uint64_t n) { return n <= (uint64_t)(end - p); };
+
+        if (!have(12) || rd_le32(p) != kReadOrderMagic) {
+            err = "not a read order log";
+            return false;
+        }
+        if (rd_le32(p + 4) != kReadOrderVersion) {
+            err = "unsupported read order log version " + std::to_string(rd_le32(p + 4));
+            return false;
+        }
+
+        uint32_t count = rd_le32(p + 8);
+        p += 12;
+        for (uint32_t i = 0; i < count; ++i) {
+            ReadOrderContainer c;
+            if (!have(10)) {
+                break;
+            }
+            c.container_id    = rd_le64(p);
+            uint16_t name_len = rd_le16(p + 8);
+            p += 10;
+            if (!have((uint64_t)name_len + 4)) {
+                break;
+            }
+            c.name.assign(reinterpret_cast<const char*>(p), name_len);
+            p += name_len;
+
+            uint32_t chunks = rd_le32(p);
+            p += 4;
+            if (!have((uint64_t)chunks * 12)) {
+                break;
+            }
+            c.chunk_ids.assign(p, p + (size_t)chunks * 12);
+            p += (size_t)chunks * 12;
+            out.containers.push_back(std::move(c));
+        }
+
+        if (out.containers.size() != count) {
+            err = "read order log is truncated";
+            return false;
+        }
+        return true;
+    }
+
+    // writes `path`.tmp, then renames it over `path`
+    static inline bool
+    write_read_order_log(const fs::path& path, const ReadOrderLog& log, std::string& err)
+    {
+        std::vector<uint8_t> buf;
+        auto put = [&](const void* p, size_t n) {
+            buf.insert(buf.end(), static_cast<const uint8_t*>(p), static_cast<const uint8_t*>(p) + n);
+        };
+
+        uint32_t head[3] = { kReadOrderMagic, kReadOrderVersion, (uint32_t)log.containers.size() };
+        put(head, sizeof(head));
+        for (const auto& c : log.containers) {
+            uint16_t name_len = (uint16_t)(std::min)(c.name.size(), (size_t)UINT16_MAX);
+            uint32_t chunks   = (uint32_t)c.chunk_count();
+            put(&c.container_id, 8);
+            put(&name_len, 2);
+            put(c.name.data(), name_len);
+            put(&chunks, 4);
+            put(c.chunk_ids.data(), (size_t)chunks * 12);
+        }
+
+        fs::path tmp = path;
+        tmp += ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(buf.data()), (std::streamsize)buf.size());
+            if (!out) {
+                err = "cannot write " + path_to_utf8(tmp);
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        fs::rename(tmp, path, ec);
+        if (ec) {
+            err = "cannot replace " + path_to_utf8(path) + ": " + ec.message();
+            return false;
+        }
+        return true;
+    }
+
+    // Maps the engine's reads of mod .ucas partitions to the chunks they belong to. Fed by the
+    // file open and read hooks: on_open() learns which handles are mod partitions, on_read()
+    // turns (handle, offset, size) into chunks via the container's block table. All methods are
+    // thread-safe; on_read() of a handle that is not a mod partition is one locked map lookup.
+    class ReadOrderRecorder
+    {
+    public:
+        // Loads base.utoc; call before the engine opens the container.
+        bool
+        add_container(const fs::path& base_no_ext, std::string& err)
+        {
+            auto c = std::make_unique<Container>();
+            fs::path utoc = base_no_ext;
+            utoc += L".utoc";
+            if (!c->file.open(utoc)) {
+                err = "cannot open .utoc";
+                return false;
+            }
+            if (!c->toc.parse(c->file.data(), c->file.size(), err)) {
+                return false;
+            }
+
+            const TocView& toc = c->toc;
+            c->name = path_to_utf8(base_no_ext.filename());
+
+            std::vector<uint32_t> block_chunk(toc.block_count(), UINT32_MAX);
+            for (uint32_t i = 0; i < toc.chunk_count(); ++i) {
+                uint64_t first = 0, count = 0;
+                toc.chunk_blocks(i, first, count);
+                for (uint64_t b = first; b < first + count && b < toc.block_count(); ++b) {
+                    if (block_chunk[b] == UINT32_MAX) {
+                        block_chunk[b] = i;
+                    }
+                }
+            }
+
+            c->blocks.reserve(toc.block_count());
+            for (uint32_t b = 0; b < toc.block_count(); ++b) {
+                TocCompressedBlock blk = toc.block(b);
+                if (block_chunk[b] != UINT32_MAX) {
+                    c->blocks.push_back(Block{ blk.offset, blk.offset + toc.block_disk_size(blk), block_chunk[b] });
+                }
+            }
+            std::sort(c->blocks.begin(), c->blocks.end(), [](const Block& a, const Block& b) { return a.begin < b.begin; });
+            c->seen.assign(toc.chunk_count(), 0);
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (uint32_t i = 0; i < toc.header().partition_count; ++i) {
+                m_partitions[path_key(ucas_partition_path(base_no_ext, i))] = Partition{ (uint32_t)m_containers.size(), i };
+            }
+            m_containers.push_back(std::move(c));
+            return true;
+        }
+
+        void
+        on_open(const void* handle, const fs::path& path)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_partitions.find(path_key(path));
+            if (it != m_partitions.end()) {
+                m_handles[handle] = it->second;
+            } else {
+                m_handles.erase(handle);
+            }
+        }
+
+        // a handle opened for something other than a .ucas; drops it if its value was reused
+        void
+        forget(const void* handle)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_handles.erase(handle);
+        }
+
+        bool
+        tracks(const void* handle) const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_handles.count(handle) != 0;
+        }
+
+        void
+        on_read(const void* handle, uint64_t offset, uint64_t size)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_handles.find(handle);
+            if (it == m_handles.end() || size == 0) {
+                return;
+            }
+
+            Container&     c     = *m_containers[it->second.container];
+            const uint64_t psize = c.toc.header().partition_size;
+            const uint64_t begin = (c.toc.header().partition_count > 1 ? it->second.index * psize : 0) + offset;
+            const uint64_t end   = begin + size;
+            ++m_reads;
+
+            auto b = std::upper_bound(c.blocks.begin(), c.blocks.end(), begin, [](uint64_t v, const Block& x) { return v < x.begin; });
+            if (b != c.blocks.begin()) {
+                --b;
+            }
+            for (; b != c.blocks.end() && b->begin < end; ++b) {
+                if (b->end > begin && !c.seen[b->chunk]) {
+                    c.seen[b->chunk] = 1;
+                    c.order.push_back(b->chunk);
+                }
+            }
+        }
+
+        uint64_t
+        reads() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_reads;
+        }
+
+        // the chunks read so far, containers with no reads left out
+        ReadOrderLog
+        snapshot() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ReadOrderLog log;
+            for (const auto& c : m_containers) {
+                if (c->order.empty()) {
+                    continue;
+                }
+                ReadOrderContainer rc;
+                rc.container_id = c->toc.header().container_id;
+                rc.name         = c->name;
+                rc.chunk_ids.reserve(c->order.size() * 12);
+                for (uint32_t i : c->order) {
+                    const uint8_t* id = c->toc.chunk_id(i).p;
+                    rc.chunk_ids.insert(rc.chunk_ids.end(), id, id + 12);
+                }
+                log.containers.push_back(std::move(rc));
+            }
+            return log;
+        }
+
+    private:
+        struct Block {
+            uint64_t begin;   // in the concatenated partitions
+            uint64_t end;
+            uint32_t chunk;
+        };
+
+        struct Container {
+            MappedFile            file;
+            TocView               toc;
+            std::string           name;
+            std::vector<Block>    blocks;   // by offset
+            std::vector<uint8_t>  seen;     // per chunk
+            std::vector<uint32_t> order;
+        };
+
+        struct Partition {
+            uint32_t container;
+            uint32_t index;
+        };
+
+        // absolute, normalized and lower-cased, so the engine's spelling of a path matches ours
+        static fs::path::string_type
+        path_key(const fs::path& p)
+        {
+            std::error_code       ec;
+            fs::path              abs = fs::absolute(p, ec);
+            fs::path::string_type s   = (ec ? p : abs).lexically_normal().native();
+            for (auto& ch : s) {
+                ch = (fs::path::value_type)std::towlower((wint_t)ch);
+            }
+            return s;
+        }
+
+        mutable std::mutex                                   m_mutex;
+        std::vector<std::unique_ptr<Container>>              m_containers;
+        std::unordered_map<fs::path::string_type, Partition> m_partitions;
+        std::unordered_map<const void*, Partition>           m_handles;
+        uint64_t                                             m_reads = 0;
+    };
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include "mod_discovery.hpp"
+#include "pak.hpp"
+#include "utoc.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace loader
+{
+    namespace fs = std::filesystem;
+
+    // Estimated heap the 4.27 engine keeps for one mounted container, modelled on
+    // FFileIoStoreReader (chunk map, block table, signatures, method names, partitions),
+    // FIoDirectoryIndexReader (parsed directory index) and FPackageStore (container header and
+    // its package map). 4.27 has no perfect-hash TOC; its chunk lookup is a TMap.
+    struct ResidentCost {
+        uint64_t chunk_map          = 0;   // TMap<FIoChunkId, FIoOffsetAndLength>
+        uint64_t compression_blocks = 0;   // FIoStoreTocCompressedBlockEntry[]
+        uint64_t block_signatures   = 0;   // FSHAHash[] (signed containers)
+        uint64_t compression_methods = 0;  // FName[]
+        uint64_t directory_index    = 0;   // FIoDirectoryIndexResource with its FStrings
+        uint64_t package_store      = 0;   // FContainerHeader and package id map entries
+        uint64_t partitions         = 0;   // partition records and their paths
+        uint64_t pak_index          = 0;   // FPakFile index, when a pak's index is loaded
+        uint32_t open_handles       = 0;   // one per .ucas partition, plus the pak
+
+        uint64_t
+        total() const
+        {
+            return chunk_map + compression_blocks + block_signatures + compression_methods + directory_index +
+                   package_store + partitions + pak_index;
+        }
+
+        ResidentCost&
+        operator+=(const ResidentCost& o)
+        {
+            chunk_map           += o.chunk_map;
+            compression_blocks  += o.compression_blocks;
+            block_signatures    += o.block_signatures;
+            compression_methods += o.compression_methods;
+            directory_index     += o.directory_index;
+            package_store       += o.package_store;
+            partitions          += o.partitions;
+            pak_index           += o.pak_index;
+            open_handles        += o.open_handles;
+            return *this;
+        }
+    };
+
+    namespace resident_detail
+    {
+        static constexpr uint64_t kHeapOverhead     = 16;   // per allocation, typical for FMallocBinned/low-fragmentation heaps
+        static constexpr uint64_t kFStringSize      = 16;   // TArray<TCHAR> header
+        static constexpr uint64_t kPartitionRecord  = 32;   // handle, size, index, path header
+        static constexpr uint64_t kChunkMapElement  = 32;   // TSetElement<TPair<12 + 10 bytes>>, next id, hash index
+        static constexpr uint64_t kPackageMapElement = 24;  // TSetElement<TPair<FPackageId, entry pointer>>
+
+        // TSet bucket count: RoundUpToPowerOfTwo(n / 2 + 8), 4 bytes each
+        static inline uint64_t
+        hash_buckets(uint64_t n)
+        {
+            if (n < 4) {
+                return 0;
+            }
+            uint64_t want = n / 2 + 8, b = 1;
+            while (b < want) {
+                b <<= 1;
+            }
+            return b * 4;
+        }
+
+        static inline uint64_t
+        fstring(uint64_t chars)
+        {
+            return kFStringSize + (chars ? (chars + 1) * 2 + kHeapOverhead : 0);
+        }
+    }
+
+    static inline ResidentCost
+    estimate_iostore_resident(const TocView& toc, const fs::path& base_no_ext)
+    {
+        using namespace resident_detail;
+
+        const TocHeader& h = toc.header();
+        ResidentCost     c;
+
+        c.chunk_map          = (uint64_t)toc.chunk_count() * kChunkMapElement + hash_buckets(toc.chunk_count()) + kHeapOverhead * 2;
+        c.compression_blocks = (uint64_t)toc.block_count() * kTocBlockEntrySize + kHeapOverhead;
+        c.block_signatures   = toc.is_signed() ? (uint64_t)toc.block_count() * kTocShaHashSize + kHeapOverhead : 0;
+        c.compression_methods = (uint64_t)(h.compression_method_name_count + 1) * 8;
+
+        if (toc.indexed()) {
+            TocDirectoryIndex dir;
+            std::string       err;
+            if (!toc.encrypted() && dir.parse(toc.directory_index(), toc.directory_index_size(), err)) {
+                c.directory_index = fstring(dir.mount_point().chars) +
+                                    (uint64_t)dir.dir_count() * 16 + (uint64_t)dir.file_count() * 12 + 2 * kHeapOverhead +
+                                    (uint64_t)dir.string_count() * (kFStringSize + kHeapOverhead) + (dir.string_count() ? kHeapOverhead : 0) +
+                                    (dir.string_chars() + dir.string_count()) * 2;
+            } else {
+                c.directory_index = toc.directory_index_size();
+            }
+        }
+
+        // the container header chunk is read whole; one map entry per package it lists, and a
+        // package has exactly one export bundle chunk
+        uint64_t packages = 0;
+        for (uint32_t i = 0; i < toc.chunk_count(); ++i) {
+            IoChunkType t = toc.chunk_id(i).type();
+            if (t == IoChunkType::ContainerHeader) {
+                c.package_store += toc.offset_length(i).length + kHeapOverhead;
+            } else if (t == IoChunkType::ExportBundleData) {
+                ++packages;
+            }
+        }
+        c.package_store += packages * kPackageMapElement + hash_buckets(packages);
+
+        size_t path_chars = base_no_ext.native().size() + 6;
+        c.partitions      = (uint64_t)h.partition_count * (kPartitionRecord + fstring(path_chars));
+        c.open_handles    = h.partition_count;
+        return c;
+    }
+
+    // Maps base.utoc and estimates its resident cost; `pak` adds a mounted pak's loaded index.
+    static inline bool
+    estimate_container_resident(const fs::path& base_no_ext, const PakSummary* pak, bool pak_index_loaded,
+                                ResidentCost& out, std::string& err)
+    {
+        out = ResidentCost{};
+
+        fs::path utoc = base_to_ext(base_no_ext, L".utoc");
+        if (file_exists(utoc)) {
+            MappedFile file;
+            TocView    toc;
+            if (!file.open(utoc)) {
+                err = "cannot open .utoc";
+                return false;
+            }
+            if (!toc.parse(file.data(), file.size(), err)) {
+                return false;
+            }
+            out = estimate_iostore_resident(toc, base_no_ext);
+        }
+
+        if (pak) {
+            out.open_handles += 1;
+            out.partitions   += resident_detail::kPartitionRecord + resident_detail::fstring(base_no_ext.native().size() + 4);
+            if (pak_index_loaded) {
+                out.pak_index = pak->info.index_size + resident_detail::kHeapOverhead;
+            }
+        }
+        return true;
+    }
+
+    // Per-container estimates of everything mounted, with per-mod totals.
+    class ResidentLedger
+    {
+    public:
+        struct Entry {
+            std::wstring mod_name;
+            std::wstring name;
+            ResidentCost cost;
+        };
+
+        void
+        add(const std::wstring& mod_name, const std::wstring& name, const ResidentCost& cost)
+        {
+            m_entries.push_back(Entry{ mod_name, name, cost });
+            m_mods[mod_name] += cost;
+            m_total          += cost;
+        }
+
+        void
+        clear()
+        {
+            m_entries.clear();
+            m_mods.clear();
+            m_total = ResidentCost{};
+        }
+
+        const std::vector<Entry>&                   entries() const { return m_entries; }
+        const std::map<std::wstring, ResidentCost>& mods()    const { return m_mods; }
+        const ResidentCost&                         total()   const { return m_total; }
+
+        // mods by total cost, largest first
+        std::vector<std::pair<std::wstring, ResidentCost>>
+        largest_mods(size_t n) const
+        {
+            std::vector<std::pair<std::wstring, ResidentCost>> v(m_mods.begin(), m_mods.end());
+            std::sort(v.begin(), v.end(), [](const auto& a, const auto& b) { return a.second.total() > b.second.total(); });
+            if (v.size() > n) {
+                v.resize(n);
+            }
+            return v;
+        }
+
+    private:
+        std::vector<Entry>                   m_entries;
+        std::map<std::wstring, ResidentCost> m_mods;
+        ResidentCost                         m_total;
+    };
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+namespace loader
+{
+    // streaming SHA-1 (FIPS 180-4); what 4.27 stores in FIoChunkHash and the block signature table
+    class SHA1
+    {
+    public:
+        static constexpr size_t kDigestSize = 20;
+
+        SHA1()
+        {
+            reset();
+        }
+
+        void
+        reset()
+        {
+            m_h[0]      = 0x67452301;
+            m_h[1]      = 0xEFCDAB89;
+            m_h[2]      = 0x98BADCFE;
+            m_h[3]      = 0x10325476;
+            m_h[4]      = 0xC3D2E1F0;
+            m_total_len = 0;
+            m_buf_len   = 0;
+        }
+
+        void
+        update(const void* data, size_t len)
+        {
+            auto* p   = static_cast<const uint8_t*>(data);
+            auto* end = p + len;
+
+            m_total_len += len;
+
+            if (m_buf_len) {
+                size_t fill = (std::min)(len, 64 - m_buf_len);
+                std::memcpy(m_buf + m_buf_len, p, fill);
+                m_buf_len += fill;
+                p += fill;
+                if (m_buf_len < 64) {
+                    return;
+                }
+                consume_block(m_buf);
+                m_buf_len = 0;
+            }
+
+            while (end - p >= 64) {
+                consume_block(p);
+                p += 64;
+            }
+
+            m_buf_len = static_cast<size_t>(end - p);
+            std::memcpy(m_buf, p, m_buf_len);
+        }
+
+        void
+        digest(uint8_t out[kDigestSize])
+        {
+            uint64_t bits = m_total_len * 8;
+
+            static const uint8_t kPad[64] = { 0x80 };
+            update(kPad, 1 + (119 - m_buf_len) % 64);
+
+            uint8_t len_be[8];
+            for (int i = 0; i < 8; ++i) {
+                len_be[i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+            }
+            update(len_be, 8);
+
+            for (int i = 0; i < 5; ++i) {
+                out[4 * i]     = static_cast<uint8_t>(m_h[i] >> 24);
+                out[4 * i + 1] = static_cast<uint8_t>(m_h[i] >> 16);
+                out[4 * i + 2] = static_cast<uint8_t>(m_h[i] >> 8);
+                out[4 * i + 3] = static_cast<uint8_t>(m_h[i]);
+            }
+        }
+
+        static void
+        hash(const void* data, size_t len, uint8_t out[kDigestSize])
+        {
+            SHA1 s;
+            s.update(data, len);
+            s.digest(out);
+        }
+
+    private:
+        static inline uint32_t
+        rotl(uint32_t x, int r)
+        {
+            return (x << r) | (x >> (32 - r));
+        }
+
+        void
+        consume_block(const uint8_t* p)
+        {
+            uint32_t w[80];
+            for (int i = 0; i < 16; ++i) {
+                w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16 | (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+            }
+            for (int i = 16; i < 80; ++i) {
+                w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+            }
+
+            uint32_t a = m_h[0], b = m_h[1], c = m_h[2], d = m_h[3], e = m_h[4];
+            auto step = [&](uint32_t f, uint32_t k, uint32_t wi) {
+                uint32_t t = rotl(a, 5) + f + e + k + wi;
+                e = d;
+                d = c;
+                c = rotl(b, 30);
+                b = a;
+                a = t;
+            };
+
+            for (int i = 0; i < 20; ++i) {
+                step((b & c) | (~b & d), 0x5A827999, w[i]);
+            }
+            for (int i = 20; i < 40; ++i) {
+                step(b ^ c ^ d, 0x6ED9EBA1, w[i]);
+            }
+            for (int i = 40; i < 60; ++i) {
+                step((b & c) | (b & d) | (c & d), 0x8F1BBCDC, w[i]);
+            }
+            for (int i = 60; i < 80; ++i) {
+                step(b ^ c ^ d, 0xCA62C1D6, w[i]);
+            }
+
+            m_h[0] += a;
+            m_h[1] += b;
+            m_h[2] += c;
+            m_h[3] += d;
+            m_h[4] += e;
+        }
+
+        uint32_t m_h[5]{};
+        uint64_t m_total_len = 0;
+        uint8_t  m_buf[64]{};
+        size_t   m_buf_len   = 0;
+    };
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace loader
+{
+    // a ModActor class queued for spawning, with the mount order of the container that queued it
+    struct ModActorClass {
+        std::wstring class_path;   // /Game/Mods/<Name>/ModActor.ModActor_C
+        int          order = 0;
+    };
+
+    // Mod actors waiting to be spawned, drained a frame at a time under a time budget. Lower
+    // mount order spawns first, queue order within one. Not thread-safe.
+    class SpawnQueue
+    {
+    public:
+        using SpawnFunc = std::function<bool(const std::wstring& class_path)>;
+
+        struct Stats {
+            size_t   spawned      = 0;
+            size_t   failed       = 0;
+            uint32_t frames       = 0;
+            double   total_ms     = 0;   // time spent spawning, summed over frames
+            double   max_frame_ms = 0;
+        };
+
+        void
+        reset(std::vector<ModActorClass> classes)
+        {
+            std::stable_sort(classes.begin(), classes.end(), [](const ModActorClass& a, const ModActorClass& b) {
+                return a.order < b.order;
+            });
+            m_queue = std::move(classes);
+            m_next  = 0;
+            m_stats = Stats{};
+        }
+
+        // Spawns until `budget_ms` is spent, always at least one; 0 spawns the whole queue.
+        // Returns true once the queue is empty.
+        bool
+        drain_frame(double budget_ms, const SpawnFunc& spawn)
+        {
+            if (empty()) {
+                return true;
+            }
+
+            auto   t0 = std::chrono::steady_clock::now();
+            double ms = 0;
+            do {
+                if (spawn(m_queue[m_next].class_path)) {
+                    ++m_stats.spawned;
+                } else {
+                    ++m_stats.failed;
+                }
+                ++m_next;
+                ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            } while (!empty() && (budget_ms <= 0 || ms < budget_ms));
+
+            ++m_stats.frames;
+            m_stats.total_ms    += ms;
+            m_stats.max_frame_ms = std::max(m_stats.max_frame_ms, ms);
+            return empty();
+        }
+
+        // drops what is left, e.g. when the world it was queued for goes away
+        void
+        clear()
+        {
+            m_next = m_queue.size();
+        }
+
+        bool         empty()     const { return m_next >= m_queue.size(); }
+        size_t       remaining() const { return m_queue.size() - m_next; }
+        const Stats& stats()     const { return m_stats; }
+
+    private:
+        std::vector<ModActorClass> m_queue;
+        size_t                     m_next = 0;
+        Stats                      m_stats;
+    };
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include "iostore_container.hpp"
+#include "parallel.hpp"
+#include "sha1.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace loader
+{
+    namespace fs = std::filesystem;
+
+    static constexpr size_t   kMaxVerifyErrors = 8;
+    static constexpr uint64_t kVerifySpanBytes = 8ull << 20;   // .ucas bytes one worker reads in a row
+
+    struct UcasVerifyResult {
+        uint64_t chunks          = 0;   // checked against the SHA-1 in their FIoChunkHash
+        uint64_t chunks_unhashed = 0;   // the TOC has no hash for them
+        uint64_t chunks_skipped  = 0;   // encrypted, or a compression method decode_block() lacks
+        uint64_t blocks          = 0;   // checked against the block signature table (signed only)
+        uint64_t bytes           = 0;   // .ucas bytes read
+        uint64_t hashed          = 0;   // decompressed bytes hashed
+        uint64_t failures        = 0;
+        double   seconds         = 0;
+        bool     cancelled       = false;
+        std::vector<std::string> errors;   // the first kMaxVerifyErrors failures
+
+        bool ok() const { return failures == 0 && !cancelled; }
+
+        double
+        mib_per_s() const
+        {
+            return seconds > 0 ? bytes / (1024.0 * 1024.0) / seconds : 0;
+        }
+    };
+
+    namespace ucas_verify_detail
+    {
+        static inline std::string
+        chunk_label(const TocView& toc, uint32_t i)
+        {
+            IoChunkId id = toc.chunk_id(i);
+            char      buf[64];
+            std::snprintf(buf, sizeof(buf), "chunk %u (id %016llx, type %u)", i, (unsigned long long)id.id(), (unsigned)id.type());
+            return buf;
+        }
+
+        static inline void
+        fail(UcasVerifyResult& r, std::string msg)
+        {
+            if (r.errors.size() < kMaxVerifyErrors) {
+                r.errors.push_back(std::move(msg));
+            }
+            ++r.failures;
+        }
+    }
+
+    // Checks base.ucas contents against base.utoc: every chunk's data against the SHA-1 in its
+    // FIoChunkHash, and for signed containers every block against the signature table. Chunks
+    // are taken in .ucas order in spans of kVerifySpanBytes spread over all cores, each span
+    // prefetched as one read. Returns false only if the container cannot be opened; corruption
+    // is reported in `out`. `cancel` is polled between spans.
+    static inline bool
+    verify_iostore_container(const fs::path& base_no_ext, UcasVerifyResult& out, std::string& err,
+                             const std::atomic<bool>* cancel = nullptr)
+    {
+        using namespace ucas_verify_detail;
+
+        auto t0 = std::chrono::steady_clock::now();
+        out = UcasVerifyResult{};
+
+        IoStoreContainer c;
+        if (!c.open(base_no_ext, err)) {
+            return false;
+        }
+        const TocView& toc = c.toc();
+
+        // chunks with data, in .ucas order
+        struct Item {
+            uint64_t disk_offset;
+            uint32_t entry;
+            uint32_t first_block;
+            uint32_t block_count;
+        };
+        std::vector<Item> items;
+        items.reserve(toc.chunk_count());
+
+        for (uint32_t i = 0; i < toc.chunk_count(); ++i) {
+            uint64_t first = 0, count = 0;
+            toc.chunk_blocks(i, first, count);
+            uint64_t disk = count ? toc.block((uint32_t)first).offset : 0;
+            items.push_back(Item{ disk, i, (uint32_t)first, (uint32_t)count });
+        }
+        std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return a.disk_offset < b.disk_offset; });
+
+        // spans of about kVerifySpanBytes of .ucas data, smaller for small containers so every
+        // core gets a few; decompressed bytes count too as they dominate hashing time
+        uint64_t total_work = 0;
+        for (const Item& it : items) {
+            total_work += toc.offset_length(it.entry).length;
+        }
+        uint64_t span_target = total_work / ((uint64_t)worker_count(SIZE_MAX) * 4);
+        span_target = (std::max)((uint64_t)1 << 20, (std::min)(span_target, kVerifySpanBytes));
+
+        struct Span {
+            size_t   begin;
+            size_t   end;
+            uint32_t first_block;
+            uint32_t last_block;
+        };
+        std::vector<Span> spans;
+        uint64_t          span_disk = 0, span_work = 0;
+        for (size_t k = 0; k < items.size(); ++k) {
+            const Item& it = items[k];
+            if (spans.empty() || span_disk >= kVerifySpanBytes || span_work >= span_target) {
+                spans.push_back(Span{ k, k, UINT32_MAX, 0 });
+                span_disk = span_work = 0;
+            }
+
+            Span& s = spans.back();
+            s.end = k + 1;
+            for (uint32_t b = it.first_block; b < it.first_block + it.block_count; ++b) {
+                span_disk += toc.block_disk_size(toc.block(b));
+            }
+            span_work += toc.offset_length(it.entry).length;
+            if (it.block_count) {
+                s.first_block = (std::min)(s.first_block, it.first_block);
+                s.last_block  = (std::max)(s.last_block, it.first_block + it.block_count - 1);
+            }
+        }
+
+        std::vector<UcasVerifyResult> results(spans.size());
+        parallel_for(spans.size(), [&](size_t si) {
+            UcasVerifyResult& r = results[si];
+            const Span&       s = spans[si];
+            if (cancel && cancel->load(std::memory_order_relaxed)) {
+                r.cancelled = true;
+                return;
+            }
+
+            if (s.first_block <= s.last_block) {
+                c.prefetch_blocks(s.first_block, s.last_block - s.first_block + 1);
+            }
+
+            std::vector<uint8_t> data;
+            for (size_t k = s.begin; k < s.end; ++k) {
+                const Item& it = items[k];
+
+                bool decodable = !toc.encrypted();
+                for (uint32_t b = it.first_block; b < it.first_block + it.block_count; ++b) {
+                    TocCompressedBlock blk  = toc.block(b);
+                    uint32_t           size = (uint32_t)toc.block_disk_size(blk);
+                    r.bytes += size;
+                    decodable = decodable && block_method_supported(toc.method_name(blk.method));
+
+                    if (toc.is_signed()) {
+                        uint8_t digest[SHA1::kDigestSize];
+                        SHA1::hash(c.block_data(blk), size, digest);
+                        ++r.blocks;
+                        if (std::memcmp(digest, toc.block_hash(b), SHA1::kDigestSize) != 0) {
+                            fail(r, "block " + std::to_string(b) + " does not match its signature hash");
+                        }
+                    }
+                }
+
+                static const uint8_t kZero[SHA1::kDigestSize] = {};
+                const uint8_t*       want = toc.chunk_hash(it.entry);
+                if (std::memcmp(want, kZero, SHA1::kDigestSize) == 0) {
+                    ++r.chunks_unhashed;
+                    continue;
+                }
+                if (!decodable) {
+                    ++r.chunks_skipped;
+                    continue;
+                }
+
+                std::string e;
+                if (!c.read_chunk(it.entry, data, e)) {
+                    fail(r, chunk_label(toc, it.entry) + ": " + e);
+                    continue;
+                }
+
+                uint8_t digest[SHA1::kDigestSize];
+                SHA1::hash(data.data(), data.size(), digest);
+                ++r.chunks;
+                r.hashed += data.size();
+                if (std::memcmp(digest, want, SHA1::kDigestSize) != 0) {
+                    fail(r, chunk_label(toc, it.entry) + ": data does not match its hash");
+                }
+            }
+        });
+
+        for (auto& r : results) {
+            out.chunks          += r.chunks;
+            out.chunks_unhashed += r.chunks_unhashed;
+            out.chunks_skipped  += r.chunks_skipped;
+            out.blocks          += r.blocks;
+            out.bytes           += r.bytes;
+            out.hashed          += r.hashed;
+            out.failures        += r.failures;
+            out.cancelled        = out.cancelled || r.cancelled;
+            for (auto& e : r.errors) {
+                if (out.errors.size() < kMaxVerifyErrors) {
+                    out.errors.push_back(std::move(e));
+                }
+            }
+        }
+
+        out.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        return true;
+    }
+}
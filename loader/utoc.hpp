@@ -0,0 +1,591 @@
+#pragma once
+
+#include "bytes.hpp"
+#include "mapped_file.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace loader
+{
+    namespace fs = std::filesystem;
+
+    // UE 4.27 IoStore table of contents (.utoc), see FIoStoreTocResource::Read
+
+    static constexpr char     kTocMagic[16]       = { '-', '=', '=', '-', '-', '=', '=', '-', '-', '=', '=', '-', '-', '=', '=', '-' };
+    static constexpr uint32_t kTocHeaderSize      = 144;
+    static constexpr uint32_t kTocBlockEntrySize  = 12;
+    static constexpr uint32_t kTocEntryMetaSize   = 33;  // FIoChunkHash (32) + flags
+    static constexpr uint32_t kTocShaHashSize     = 20;
+    static constexpr uint32_t kTocNone            = 0xFFFFFFFF;
+
+    enum class TocVersion : uint8_t {
+        Invalid        = 0,
+        Initial        = 1,
+        DirectoryIndex = 2,
+        PartitionSize  = 3,
+        Latest         = PartitionSize,
+    };
+
+    enum TocContainerFlags : uint8_t {
+        TocCompressed = 1 << 0,
+        TocEncrypted  = 1 << 1,
+        TocSigned     = 1 << 2,
+        TocIndexed    = 1 << 3,
+    };
+
+    enum class IoChunkType : uint8_t {
+        Invalid                = 0,
+        InstallManifest        = 1,
+        ExportBundleData       = 2,
+        BulkData               = 3,
+        OptionalBulkData       = 4,
+        MemoryMappedBulkData   = 5,
+        LoaderGlobalMeta       = 6,
+        LoaderInitialLoadMeta  = 7,
+        LoaderGlobalNames      = 8,
+        LoaderGlobalNameHashes = 9,
+        ContainerHeader        = 10,
+    };
+
+    struct TocHeader {
+        uint8_t  version                        = 0;
+        uint32_t header_size                    = 0;
+        uint32_t entry_count                    = 0;
+        uint32_t compressed_block_entry_count   = 0;
+        uint32_t compressed_block_entry_size    = 0;
+        uint32_t compression_method_name_count  = 0;
+        uint32_t compression_method_name_length = 0;
+        uint32_t compression_block_size         = 0;
+        uint32_t directory_index_size           = 0;
+        uint32_t partition_count                = 0;
+        uint64_t container_id                   = 0;
+        uint8_t  encryption_key_guid[16]        = {};
+        uint8_t  container_flags                = 0;
+        uint64_t partition_size                 = 0;
+    };
+
+    // FIoChunkId: 8-byte id, 2-byte index, padding, type
+    struct IoChunkId {
+        const uint8_t* p = nullptr;
+
+        uint64_t    id()    const { return rd_le64(p); }
+        uint16_t    index() const { return rd_le16(p + 8); }
+        IoChunkType type()  const { return (IoChunkType)p[11]; }
+    };
+
+    struct TocOffsetLength {
+        uint64_t offset = 0;  // in the container's uncompressed address space
+        uint64_t length = 0;
+    };
+
+    // FIoStoreTocCompressedBlockEntry: 40-bit offset, 24-bit sizes, method index (0 = none)
+    struct TocCompressedBlock {
+        uint64_t offset            = 0;  // in the concatenated partitions
+        uint32_t compressed_size   = 0;
+        uint32_t uncompressed_size = 0;
+        uint8_t  method            = 0;
+    };
+
+    // Zero-copy view of a .utoc image; every accessor reads straight from the buffer given to
+    // parse(), which must outlive the view. parse() only checks the layout fits the buffer;
+    // cross-checks against the .ucas partitions are in validate_toc().
+    class TocView
+    {
+    public:
+        bool
+        parse(const uint8_t* data, uint64_t size, std::string& err)
+        {
+            *this = TocView{};
+
+            if (!data || size < kTocHeaderSize) {
+                err = "file smaller than the TOC header";
+                return false;
+            }
+            if (std::memcmp(data, kTocMagic, sizeof(kTocMagic)) != 0) {
+                err = "bad TOC magic";
+                return false;
+            }
+
+            TocHeader& h = m_header;
+            h.version                        = data[16];
+            h.header_size                    = rd_le32(data + 20);
+            h.entry_count                    = rd_le32(data + 24);
+            h.compressed_block_entry_count   = rd_le32(data + 28);
+            h.compressed_block_entry_size    = rd_le32(data + 32);
+            h.compression_method_name_count  = rd_le32(data + 36);
+            h.compression_method_name_length = rd_le32(data + 40);
+            h.compression_block_size         = rd_le32(data + 44);
+            h.directory_index_size           = rd_le32(data + 48);
+            h.partition_count                = rd_le32(data + 52);
+            h.container_id                   = rd_le64(data + 56);
+            std::memcpy(h.encryption_key_guid, data + 64, 16);
+            h.container_flags                = data[80];
+            h.partition_size                 = rd_le64(data + 88);
+
+            if (h.version == (uint8_t)TocVersion::Invalid || h.version > (uint8_t)TocVersion::Latest) {
+                err = "unsupported TOC version " + std::to_string(h.version);
+                return false;
+            }
+            if (h.version < (uint8_t)TocVersion::DirectoryIndex) {
+                h.directory_index_size = 0;
+            }
+            if (h.version < (uint8_t)TocVersion::PartitionSize) {
+                h.partition_count = 1;
+                h.partition_size  = UINT64_MAX;
+            }
+
+            if (h.header_size != kTocHeaderSize) {
+                err = "bad TOC header size " + std::to_string(h.header_size);
+                return false;
+            }
+            if (h.compressed_block_entry_size != kTocBlockEntrySize) {
+                err = "bad compressed block entry size " + std::to_string(h.compressed_block_entry_size);
+                return false;
+            }
+            if (h.compression_block_size == 0 || h.partition_count == 0 || h.partition_size == 0) {
+                err = "zero compression block size or partition size/count";
+                return false;
+            }
+
+            // section sizes are 32-bit counts times small constants; 64-bit sums cannot overflow
+            uint64_t pos = kTocHeaderSize;
+            auto take = [&](uint64_t bytes, const uint8_t*& out) {
+                if (bytes > size - pos) {
+                    return false;
+                }
+                out = data + pos;
+                pos += bytes;
+                return true;
+            };
+
+            if (!take((uint64_t)h.entry_count * 12, m_chunk_ids) ||
+                !take((uint64_t)h.entry_count * 10, m_offset_lengths) ||
+                !take((uint64_t)h.compressed_block_entry_count * kTocBlockEntrySize, m_blocks) ||
+                !take((uint64_t)h.compression_method_name_count * h.compression_method_name_length, m_method_names)) {
+                err = "TOC truncated in the chunk and block tables";
+                return false;
+            }
+
+            if (h.container_flags & TocSigned) {
+                const uint8_t* hs = nullptr;
+                if (!take(4, hs)) {
+                    err = "TOC truncated in the signature header";
+                    return false;
+                }
+
+                uint32_t hash_size = rd_le32(hs);
+                m_signature_size   = hash_size;
+                if (!take((uint64_t)hash_size, m_toc_signature) ||
+                    !take((uint64_t)hash_size, m_block_signature) ||
+                    !take((uint64_t)h.compressed_block_entry_count * kTocShaHashSize, m_block_hashes)) {
+                    err = "TOC truncated in the signatures";
+                    return false;
+                }
+            }
+
+            if (!take(h.directory_index_size, m_directory_index)) {
+                err = "TOC truncated in the directory index";
+                return false;
+            }
+
+            if (!take((uint64_t)h.entry_count * kTocEntryMetaSize, m_metas)) {
+                err = "TOC truncated in the chunk metas";
+                return false;
+            }
+
+            m_data = data;
+            m_size = size;
+            return true;
+        }
+
+        const TocHeader& header()      const { return m_header; }
+        const uint8_t*   data()        const { return m_data; }
+        uint64_t         size()        const { return m_size; }
+        uint32_t         chunk_count() const { return m_header.entry_count; }
+        uint32_t         block_count() const { return m_header.compressed_block_entry_count; }
+
+        bool encrypted() const { return (m_header.container_flags & TocEncrypted) != 0; }
+        bool is_signed() const { return (m_header.container_flags & TocSigned) != 0; }
+        bool indexed()   const { return (m_header.container_flags & TocIndexed) != 0 && m_header.directory_index_size != 0; }
+
+        IoChunkId
+        chunk_id(uint32_t i) const
+        {
+            return IoChunkId{ m_chunk_ids + (size_t)i * 12 };
+        }
+
+        TocOffsetLength
+        offset_length(uint32_t i) const
+        {
+            const uint8_t* p = m_offset_lengths + (size_t)i * 10;
+            return TocOffsetLength{ rd_be40(p), rd_be40(p + 5) };
+        }
+
+        TocCompressedBlock
+        block(uint32_t i) const
+        {
+            const uint8_t*     p = m_blocks + (size_t)i * kTocBlockEntrySize;
+            TocCompressedBlock b;
+            b.offset            = rd_le64(p) & 0xFFFFFFFFFFull;
+            b.compressed_size   = rd_le32(p + 4) >> 8;
+            b.uncompressed_size = rd_le32(p + 8) & 0xFFFFFF;
+            b.method            = p[11];
+            return b;
+        }
+
+        // bytes the block occupies in its partition (encrypted blocks are padded to the AES block)
+        uint64_t
+        block_disk_size(const TocCompressedBlock& b) const
+        {
+            return encrypted() ? ((uint64_t)b.compressed_size + 15) & ~15ull : b.compressed_size;
+        }
+
+        // method 0 is "None"; names are stored for methods 1..count
+        std::string_view
+        method_name(uint32_t method) const
+        {
+            if (method == 0 || method > m_header.compression_method_name_count) {
+                return method == 0 ? std::string_view("None") : std::string_view();
+            }
+
+            const char* p = reinterpret_cast<const char*>(m_method_names) + (size_t)(method - 1) * m_header.compression_method_name_length;
+            return std::string_view(p, strnlen(p, m_header.compression_method_name_length));
+        }
+
+        const uint8_t*
+        chunk_hash(uint32_t i) const
+        {
+            return m_metas + (size_t)i * kTocEntryMetaSize;
+        }
+
+        uint8_t
+        chunk_meta_flags(uint32_t i) const
+        {
+            return m_metas[(size_t)i * kTocEntryMetaSize + 32];
+        }
+
+        // SHA1 of each compressed block, only present when signed
+        const uint8_t*
+        block_hash(uint32_t i) const
+        {
+            return m_block_hashes ? m_block_hashes + (size_t)i * kTocShaHashSize : nullptr;
+        }
+
+        const uint8_t* directory_index()      const { return m_directory_index; }
+        uint32_t       directory_index_size() const { return m_header.directory_index_size; }
+        uint32_t       signature_size()       const { return m_signature_size; }
+
+        // first compression block of chunk `i` and the number of blocks it spans
+        void
+        chunk_blocks(uint32_t i, uint64_t& first, uint64_t& count) const
+        {
+            TocOffsetLength ol = offset_length(i);
+            uint64_t        bs = m_header.compression_block_size;
+
+            first = ol.offset / bs;
+            count = ol.length ? (ol.offset + ol.length - 1) / bs - first + 1 : 0;
+        }
+
+    private:
+        TocHeader      m_header;
+        const uint8_t* m_data            = nullptr;
+        uint64_t       m_size            = 0;
+        const uint8_t* m_chunk_ids       = nullptr;
+        const uint8_t* m_offset_lengths  = nullptr;
+        const uint8_t* m_blocks          = nullptr;
+        const uint8_t* m_method_names    = nullptr;
+        const uint8_t* m_toc_signature   = nullptr;
+        const uint8_t* m_block_signature = nullptr;
+        const uint8_t* m_block_hashes    = nullptr;
+        const uint8_t* m_directory_index = nullptr;
+        const uint8_t* m_metas           = nullptr;
+        uint32_t       m_signature_size  = 0;
+    };
+
+    // Partition `i` of the container at `base` (path without extension): base.ucas, base_s1.ucas, ...
+    static inline fs::path
+    ucas_partition_path(const fs::path& base_no_ext, uint32_t i)
+    {
+        fs::path p = base_no_ext;
+        if (i > 0) {
+            p += L"_s" + std::to_wstring(i);
+        }
+        p += L".ucas";
+        return p;
+    }
+
+    // Cross-checks the TOC against itself and the sizes of its .ucas partitions, catching what
+    // would otherwise only surface as a failed mount or a read error mid-game: chunks outside
+    // the block table, blocks outside their partition, unknown compression methods.
+    static inline bool
+    validate_toc(const TocView& toc, const uint64_t* partition_sizes, uint32_t partition_count, std::string& err)
+    {
+        const TocHeader& h = toc.header();
+
+        if (partition_count < h.partition_count) {
+            err = "missing .ucas partition " + std::to_string(partition_count);
+            return false;
+        }
+
+        uint64_t uncompressed_span = (uint64_t)toc.block_count() * h.compression_block_size;
+        for (uint32_t i = 0; i < toc.chunk_count(); ++i) {
+            TocOffsetLength ol = toc.offset_length(i);
+            if (ol.length && (ol.offset > uncompressed_span || ol.length > uncompressed_span - ol.offset)) {
+                err = "chunk " + std::to_string(i) + " lies outside the compression block table";
+                return false;
+            }
+        }
+
+        const bool single = h.partition_count == 1;
+        for (uint32_t i = 0; i < toc.block_count(); ++i) {
+            TocCompressedBlock b = toc.block(i);
+
+            if (b.method > h.compression_method_name_count) {
+                err = "block " + std::to_string(i) + " uses unknown compression method " + std::to_string(b.method);
+                return false;
+            }
+            if (b.uncompressed_size > h.compression_block_size || (b.method == 0 && b.compressed_size != b.uncompressed_size)) {
+                err = "block " + std::to_string(i) + " has inconsistent sizes";
+                return false;
+            }
+
+            uint64_t part = single ? 0 : b.offset / h.partition_size;
+            uint64_t off  = single ? b.offset : b.offset % h.partition_size;
+            if (part >= h.partition_count) {
+                err = "block " + std::to_string(i) + " points past the last partition";
+                return false;
+            }
+
+            uint64_t end = off + toc.block_disk_size(b);
+            if (end > partition_sizes[part]) {
+                err = "block " + std::to_string(i) + " ends at " + std::to_string(end) + " but partition " +
+                      std::to_string(part) + " is only " + std::to_string(partition_sizes[part]) + " bytes";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    struct TocSummary {
+        TocHeader header;
+        uint64_t  toc_bytes  = 0;
+        uint64_t  ucas_bytes = 0;
+    };
+
+    // Maps base.utoc and checks it against its partitions without reading any .ucas data.
+    static inline bool
+    check_iostore_container(const fs::path& base_no_ext, std::string& err, TocSummary* out = nullptr)
+    {
+        fs::path utoc = base_no_ext;
+        utoc += L".utoc";
+
+        MappedFile file;
+        if (!file.open(utoc)) {
+            err = "cannot open .utoc";
+            return false;
+        }
+
+        TocView toc;
+        if (!toc.parse(file.data(), file.size(), err)) {
+            return false;
+        }
+
+        std::vector<uint64_t> sizes;
+        sizes.reserve(toc.header().partition_count);
+
+        for (uint32_t i = 0; i < toc.header().partition_count; ++i) {
+            std::error_code ec;
+            uint64_t n = fs::file_size(ucas_partition_path(base_no_ext, i), ec);
+            if (ec) {
+                break;
+            }
+            sizes.push_back(n);
+        }
+
+        if (!validate_toc(toc, sizes.data(), (uint32_t)sizes.size(), err)) {
+            return false;
+        }
+
+        if (out) {
+            out->header     = toc.header();
+            out->toc_bytes  = file.size();
+            out->ucas_bytes = 0;
+            for (uint64_t n : sizes) {
+                out->ucas_bytes += n;
+            }
+        }
+        return true;
+    }
+
+    // FIoDirectoryIndexResource: mount point, directory/file trees linked by index, string table.
+    // Names and entries stay in the source buffer; only the string table offsets are collected.
+    class TocDirectoryIndex
+    {
+    public:
+        bool
+        parse(const uint8_t* data, uint64_t size, std::string& err)
+        {
+            *this = TocDirectoryIndex{};
+
+            const uint8_t* p   = data;
+            const uint8_t* end = data + size;
+
+            uint32_t n_dirs = 0, n_files = 0, n_strings = 0;
+            if (!read_fstring(p, end, m_mount_point) ||
+                !read_array(p, end, 16, m_dirs, n_dirs) ||
+                !read_array(p, end, 12, m_files, n_files) ||
+                end - p < 4) {
+                err = "directory index truncated";
+                return false;
+            }
+
+            n_strings = rd_le32(p);
+            p += 4;
+            if (n_strings > (uint64_t)(end - p) / 4) {
+                err = "directory index string table truncated";
+                return false;
+            }
+
+            m_strings.resize(n_strings);
+            for (uint32_t i = 0; i < n_strings; ++i) {
+                if (!read_fstring(p, end, m_strings[i])) {
+                    err = "directory index string table truncated";
+                    return false;
+                }
+            }
+
+            m_dir_count  = n_dirs;
+            m_file_count = n_files;
+            return true;
+        }
+
+        const FStringView& mount_point() const { return m_mount_point; }
+        uint32_t           dir_count()   const { return m_dir_count; }
+        uint32_t           file_count()  const { return m_file_count; }
+        uint32_t           string_count() const { return (uint32_t)m_strings.size(); }
+
+        // characters in the string table, terminators excluded
+        uint64_t
+        string_chars() const
+        {
+            uint64_t n = 0;
+            for (const auto& s : m_strings) {
+                n += s.chars;
+            }
+            return n;
+        }
+
+        // Calls fn(path, toc_entry_index) for every file, path being mount point + directories +
+        // file name. Returns false on dangling indices or cycles.
+        template <typename Fn>
+        bool
+        for_each_file(Fn&& fn) const
+        {
+            if (m_dir_count == 0) {
+                return true;
+            }
+
+            struct Frame {
+                uint32_t dir;
+                size_t   path_len;
+            };
+
+            std::string path;
+            m_mount_point.append_utf8(path);
+
+            std::vector<Frame> stack{ Frame{ 0, path.size() } };
+            uint64_t budget = (uint64_t)m_dir_count + m_file_count + 1;
+
+            while (!stack.empty()) {
+                Frame f = stack.back();
+                stack.pop_back();
+                path.resize(f.path_len);
+
+                uint32_t name = dir_field(f.dir, 0);
+                if (name != kTocNone) {
+                    if (!append_name(path, name)) {
+                        return false;
+                    }
+                    path.push_back('/');
+                }
+                size_t dir_len = path.size();
+
+                for (uint32_t file = dir_field(f.dir, 3); file != kTocNone; file = file_field(file, 1)) {
+                    if (file >= m_file_count || budget-- == 0) {
+                        return false;
+                    }
+
+                    path.resize(dir_len);
+                    if (!append_name(path, file_field(file, 0))) {
+                        return false;
+                    }
+                    fn(std::string_view(path), file_field(file, 2));
+                }
+
+                for (uint32_t child = dir_field(f.dir, 1); child != kTocNone; child = dir_field(child, 2)) {
+                    if (child >= m_dir_count || budget-- == 0) {
+                        return false;
+                    }
+                    stack.push_back(Frame{ child, dir_len });
+                }
+            }
+            return true;
+        }
+
+    private:
+        static bool
+        read_array(const uint8_t*& p, const uint8_t* end, uint32_t elem, const uint8_t*& out, uint32_t& count)
+        {
+            if (end - p < 4) {
+                return false;
+            }
+
+            count = rd_le32(p);
+            p += 4;
+            if ((uint64_t)count * elem > (uint64_t)(end - p)) {
+                return false;
+            }
+
+            out = p;
+            p += (size_t)count * elem;
+            return true;
+        }
+
+        // FIoDirectoryIndexEntry { Name, FirstChildEntry, NextSiblingEntry, FirstFileEntry }
+        uint32_t
+        dir_field(uint32_t dir, int field) const
+        {
+            return dir < m_dir_count ? rd_le32(m_dirs + (size_t)dir * 16 + field * 4) : kTocNone;
+        }
+
+        // FIoFileIndexEntry { Name, NextFileEntry, UserData (TOC entry index) }
+        uint32_t
+        file_field(uint32_t file, int field) const
+        {
+            return file < m_file_count ? rd_le32(m_files + (size_t)file * 12 + field * 4) : kTocNone;
+        }
+
+        bool
+        append_name(std::string& path, uint32_t name) const
+        {
+            if (name >= m_strings.size()) {
+                return false;
+            }
+            m_strings[name].append_utf8(path);
+            return true;
+        }
+
+        FStringView              m_mount_point;
+        const uint8_t*           m_dirs       = nullptr;
+        const uint8_t*           m_files      = nullptr;
+        uint32_t                 m_dir_count  = 0;
+        uint32_t                 m_file_count = 0;
+        std::vector<FStringView> m_strings;
+    };
+}
@@ -0,0 +1,268 @@
+#pragma once
+
+#include "utoc.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace loader
+{
+    // Serializes a 4.27 (version PartitionSize) .utoc: single partition, unsigned. Chunks and
+    // blocks are appended in order; the caller lays out the .ucas and passes block offsets.
+    class TocWriter
+    {
+    public:
+        explicit TocWriter(uint32_t compression_block_size)
+            : m_block_size(compression_block_size)
+        {
+        }
+
+        uint32_t block_size()  const { return m_block_size; }
+        uint32_t chunk_count() const { return (uint32_t)(m_chunk_ids.size() / 12); }
+        uint32_t block_count() const { return (uint32_t)(m_blocks.size() / kTocBlockEntrySize); }
+        uint32_t method_count() const { return (uint32_t)m_methods.size(); }
+        uint32_t directory_index_size() const { return (uint32_t)m_directory_index.size(); }
+
+        // returns the method index for `name`; "None" is always 0
+        uint8_t
+        method(std::string_view name)
+        {
+            if (name.empty() || name == "None") {
+                return 0;
+            }
+            for (size_t i = 0; i < m_methods.size(); ++i) {
+                if (m_methods[i] == name) {
+                    return (uint8_t)(i + 1);
+                }
+            }
+            m_methods.emplace_back(name);
+            return (uint8_t)m_methods.size();
+        }
+
+        // `id` is the raw 12-byte FIoChunkId, `meta` the 33-byte FIoStoreTocEntryMeta.
+        // The chunk starts at the next block boundary of the uncompressed address space.
+        void
+        add_chunk(const uint8_t* id, uint64_t length, const uint8_t* meta)
+        {
+            m_chunk_ids.insert(m_chunk_ids.end(), id, id + 12);
+
+            uint64_t offset = (uint64_t)block_count() * m_block_size;
+            uint8_t  ol[10];
+            for (int i = 0; i < 5; ++i) {
+                ol[i]     = (uint8_t)(offset >> (8 * (4 - i)));
+                ol[5 + i] = (uint8_t)(length >> (8 * (4 - i)));
+            }
+            m_offset_lengths.insert(m_offset_lengths.end(), ol, ol + 10);
+
+            if (meta) {
+                m_metas.insert(m_metas.end(), meta, meta + kTocEntryMetaSize);
+            } else {
+                m_metas.resize(m_metas.size() + kTocEntryMetaSize, 0);
+            }
+        }
+
+        void
+        add_block(uint64_t offset, uint32_t compressed_size, uint32_t uncompressed_size, uint8_t method)
+        {
+            uint8_t  b[kTocBlockEntrySize];
+            uint64_t off = offset & 0xFFFFFFFFFFull;
+            std::memcpy(b, &off, 5);
+            b[5]  = (uint8_t)compressed_size;
+            b[6]  = (uint8_t)(compressed_size >> 8);
+            b[7]  = (uint8_t)(compressed_size >> 16);
+            b[8]  = (uint8_t)uncompressed_size;
+            b[9]  = (uint8_t)(uncompressed_size >> 8);
+            b[10] = (uint8_t)(uncompressed_size >> 16);
+            b[11] = method;
+            m_blocks.insert(m_blocks.end(), b, b + kTocBlockEntrySize);
+
+            if (method != 0) {
+                m_compressed = true;
+            }
+        }
+
+        void set_directory_index(std::vector<uint8_t> index) { m_directory_index = std::move(index); }
+
+        std::vector<uint8_t>
+        serialize(uint64_t container_id) const
+        {
+            static constexpr uint32_t kMethodNameLength = 32;
+
+            uint8_t flags = 0;
+            if (m_compressed) {
+                flags |= TocCompressed;
+            }
+            if (!m_directory_index.empty()) {
+                flags |= TocIndexed;
+            }
+
+            uint8_t h[kTocHeaderSize] = {};
+
+            auto put32 = [&](size_t at, uint32_t v) { std::memcpy(h + at, &v, 4); };
+            auto put64 = [&](size_t at, uint64_t v) { std::memcpy(h + at, &v, 8); };
+
+            std::memcpy(h, kTocMagic, sizeof(kTocMagic));
+            h[16] = (uint8_t)TocVersion::PartitionSize;
+            put32(20, kTocHeaderSize);
+            put32(24, chunk_count());
+            put32(28, block_count());
+            put32(32, kTocBlockEntrySize);
+            put32(36, (uint32_t)m_methods.size());
+            put32(40, kMethodNameLength);
+            put32(44, m_block_size);
+            put32(48, (uint32_t)m_directory_index.size());
+            put32(52, 1);
+            put64(56, container_id);
+            h[80] = flags;
+            put64(88, UINT64_MAX);
+
+            std::vector<uint8_t> out;
+            out.reserve(kTocHeaderSize + m_chunk_ids.size() + m_offset_lengths.size() + m_blocks.size() +
+                        m_methods.size() * kMethodNameLength + m_directory_index.size() + m_metas.size());
+            out.insert(out.end(), h, h + kTocHeaderSize);
+            out.insert(out.end(), m_chunk_ids.begin(), m_chunk_ids.end());
+            out.insert(out.end(), m_offset_lengths.begin(), m_offset_lengths.end());
+            out.insert(out.end(), m_blocks.begin(), m_blocks.end());
+            for (const auto& m : m_methods) {
+                size_t at = out.size();
+                out.resize(at + kMethodNameLength, 0);
+                std::memcpy(out.data() + at, m.data(), (std::min)(m.size(), (size_t)kMethodNameLength - 1));
+            }
+            out.insert(out.end(), m_directory_index.begin(), m_directory_index.end());
+            out.insert(out.end(), m_metas.begin(), m_metas.end());
+            return out;
+        }
+
+    private:
+        uint32_t                 m_block_size;
+        bool                     m_compressed = false;
+        std::vector<std::string> m_methods;
+        std::vector<uint8_t>     m_chunk_ids;
+        std::vector<uint8_t>     m_offset_lengths;
+        std::vector<uint8_t>     m_blocks;
+        std::vector<uint8_t>     m_metas;
+        std::vector<uint8_t>     m_directory_index;
+    };
+
+    // Builds an FIoDirectoryIndexResource from '/'-separated paths relative to the mount point.
+    class DirectoryIndexBuilder
+    {
+    public:
+        DirectoryIndexBuilder()
+        {
+            m_dirs.push_back(Dir{ kTocNone, kTocNone, kTocNone, kTocNone });
+        }
+
+        void
+        add_file(std::string_view path, uint32_t toc_entry)
+        {
+            uint32_t dir = 0;
+            size_t   pos = 0;
+            for (size_t slash; (slash = path.find('/', pos)) != std::string_view::npos; pos = slash + 1) {
+                if (slash > pos) {
+                    dir = child(dir, path.substr(pos, slash - pos));
+                }
+            }
+
+            uint32_t file = (uint32_t)m_files.size();
+            m_files.push_back(File{ name(path.substr(pos)), m_dirs[dir].first_file, toc_entry });
+            m_dirs[dir].first_file = file;
+        }
+
+        bool empty() const { return m_files.empty(); }
+
+        std::vector<uint8_t>
+        serialize(std::string_view mount_point) const
+        {
+            std::vector<uint8_t> out;
+            auto put32 = [&](uint32_t v) {
+                uint8_t b[4];
+                std::memcpy(b, &v, 4);
+                out.insert(out.end(), b, b + 4);
+            };
+            auto put_string = [&](std::string_view s) {
+                put32((uint32_t)s.size() + 1);
+                out.insert(out.end(), s.begin(), s.end());
+                out.push_back(0);
+            };
+
+            put_string(mount_point);
+
+            put32((uint32_t)m_dirs.size());
+            for (const auto& d : m_dirs) {
+                put32(d.name);
+                put32(d.first_child);
+                put32(d.next_sibling);
+                put32(d.first_file);
+            }
+
+            put32((uint32_t)m_files.size());
+            for (const auto& f : m_files) {
+                put32(f.name);
+                put32(f.next_file);
+                put32(f.user_data);
+            }
+
+            put32((uint32_t)m_strings.size());
+            for (const auto& s : m_strings) {
+                put_string(s);
+            }
+            return out;
+        }
+
+    private:
+        struct Dir {
+            uint32_t name;
+            uint32_t first_child;
+            uint32_t next_sibling;
+            uint32_t first_file;
+        };
+
+        struct File {
+            uint32_t name;
+            uint32_t next_file;
+            uint32_t user_data;
+        };
+
+        uint32_t
+        name(std::string_view s)
+        {
+            auto it = m_string_ids.find(std::string(s));
+            if (it != m_string_ids.end()) {
+                return it->second;
+            }
+            uint32_t id = (uint32_t)m_strings.size();
+            m_strings.emplace_back(s);
+            m_string_ids.emplace(m_strings.back(), id);
+            return id;
+        }
+
+        uint32_t
+        child(uint32_t parent, std::string_view s)
+        {
+            uint32_t n = name(s);
+            auto     key = ((uint64_t)parent << 32) | n;
+            auto     it  = m_children.find(key);
+            if (it != m_children.end()) {
+                return it->second;
+            }
+
+            uint32_t d = (uint32_t)m_dirs.size();
+            m_dirs.push_back(Dir{ n, kTocNone, m_dirs[parent].first_child, kTocNone });
+            m_dirs[parent].first_child = d;
+            m_children.emplace(key, d);
+            return d;
+        }
+
+        std::vector<Dir>                          m_dirs;
+        std::vector<File>                         m_files;
+        std::vector<std::string>                  m_strings;
+        std::unordered_map<std::string, uint32_t> m_string_ids;
+        std::unordered_map<uint64_t, uint32_t>    m_children;
+    };
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <cwchar>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace loader
+{
+    static inline std::wstring
+    widen_ascii(const std::string& s)
+    {
+        return std::wstring(s.begin(), s.end());
+    }
+
+    namespace wformat_detail
+    {
+        template <typename T>
+        inline constexpr bool kAlwaysFalse = false;
+
+        template <typename T>
+        static inline void
+        append(std::wstring& out, std::wstring_view spec, const T& v)
+        {
+            wchar_t buf[64];
+            if constexpr (std::is_same_v<T, bool>) {
+                out += v ? L"true" : L"false";
+            } else if constexpr (std::is_integral_v<T>) {
+                out += std::to_wstring(v);
+            } else if constexpr (std::is_floating_point_v<T>) {
+                int precision = 6;
+                if (spec.size() >= 3 && spec[0] == L'.' && spec.back() == L'f') {
+                    precision = (int)std::wcstol(spec.data() + 1, nullptr, 10);
+                }
+                std::swprintf(buf, 64, L"%.*f", precision, (double)v);
+                out += buf;
+            } else if constexpr (std::is_same_v<std::decay_t<T>, const wchar_t*> || std::is_same_v<std::decay_t<T>, wchar_t*>) {
+                out += v ? v : L"(null)";
+            } else if constexpr (std::is_pointer_v<T>) {
+                std::swprintf(buf, 64, L"0x%llx", (unsigned long long)(uintptr_t)v);
+                out += buf;
+            } else if constexpr (std::is_convertible_v<const T&, std::wstring_view>) {
+                out += std::wstring_view(v);
+            } else {
+                static_assert(kAlwaysFalse<T>, "wformat: unsupported argument type");
+            }
+        }
+
+        // copies literal text up to the next replacement field, which is returned in `spec`
+        static inline bool
+        next_field(std::wstring& out, std::wstring_view& fmt, std::wstring_view& spec)
+        {
+            while (!fmt.empty()) {
+                wchar_t c = fmt[0];
+                if ((c == L'{' || c == L'}') && fmt.size() > 1 && fmt[1] == c) {
+                    out += c;
+                    fmt.remove_prefix(2);
+                    continue;
+                }
+                if (c == L'{') {
+                    size_t close = fmt.find(L'}');
+                    if (close == std::wstring_view::npos) {
+                        break;
+                    }
+                    spec = fmt.substr(1, close - 1);
+                    if (!spec.empty() && spec[0] == L':') {
+                        spec.remove_prefix(1);
+                    }
+                    fmt.remove_prefix(close + 1);
+                    return true;
+                }
+                out += c;
+                fmt.remove_prefix(1);
+            }
+            out += fmt;
+            fmt = {};
+            return false;
+        }
+
+        static inline void
+        format_to(std::wstring& out, std::wstring_view fmt)
+        {
+            std::wstring_view spec;
+            while (next_field(out, fmt, spec)) {
+            }
+        }
+
+        template <typename T, typename... Rest>
+        static inline void
+        format_to(std::wstring& out, std::wstring_view fmt, const T& first, const Rest&... rest)
+        {
+            std::wstring_view spec;
+            if (!next_field(out, fmt, spec)) {
+                return;
+            }
+            append(out, spec, first);
+            format_to(out, fmt, rest...);
+        }
+    }
+
+    // The subset of std::format the loader's log lines use: "{}", "{:p}" and "{:.Nf}" fields,
+    // "{{" / "}}" escapes, and integer, floating-point, pointer and wide-string arguments.
+    template <typename... Args>
+    static inline std::wstring
+    wformat(std::wstring_view fmt, const Args&... args)
+    {
+        std::wstring out;
+        out.reserve(fmt.size() + 32);
+        wformat_detail::format_to(out, fmt, args...);
+        return out;
+    }
+}
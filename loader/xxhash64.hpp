@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+namespace loader
+{
+    // streaming XXH64 (https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md)
+    class XXH64
+    {
+    public:
+        explicit XXH64(uint64_t seed = 0)
+        {
+            reset(seed);
+        }
+
+        void
+        reset(uint64_t seed = 0)
+        {
+            m_v[0]      = seed + kPrime1 + kPrime2;
+            m_v[1]      = seed + kPrime2;
+            m_v[2]      = seed;
+            m_v[3]      = seed - kPrime1;
+            m_seed      = seed;
+            m_total_len = 0;
+            m_buf_len   = 0;
+        }
+
+        void
+        update(const void* data, size_t len)
+        {
+            auto* p   = static_cast<const uint8_t*>(data);
+            auto* end = p + len;
+
+            m_total_len += len;
+
+            if (m_buf_len + len < 32) {
+                std::memcpy(m_buf + m_buf_len, p, len);
+                m_buf_len += len;
+                return;
+            }
+
+            if (m_buf_len) {
+                size_t fill = 32 - m_buf_len;
+                std::memcpy(m_buf + m_buf_len, p, fill);
+                consume_stripe(m_buf);
+                p += fill;
+                m_buf_len = 0;
+            }
+
+            while (end - p >= 32) {
+                consume_stripe(p);
+                p += 32;
+            }
+
+            m_buf_len = static_cast<size_t>(end - p);
+            std::memcpy(m_buf, p, m_buf_len);
+        }
+
+        uint64_t
+        digest() const
+        {
+            uint64_t h;
+            if (m_total_len >= 32) {
+                h = rotl(m_v[0], 1) + rotl(m_v[1], 7) + rotl(m_v[2], 12) + rotl(m_v[3], 18);
+                for (uint64_t v : m_v) {
+                    h = merge_round(h, v);
+                }
+            } else {
+                h = m_seed + kPrime5;
+            }
+
+            h += m_total_len;
+
+            const uint8_t* p   = m_buf;
+            const uint8_t* end = m_buf + m_buf_len;
+
+            while (end - p >= 8) {
+                h ^= round(0, read64(p));
+                h  = rotl(h, 27) * kPrime1 + kPrime4;
+                p += 8;
+            }
+            if (end - p >= 4) {
+                h ^= static_cast<uint64_t>(read32(p)) * kPrime1;
+                h  = rotl(h, 23) * kPrime2 + kPrime3;
+                p += 4;
+            }
+            while (p < end) {
+                h ^= (*p++) * kPrime5;
+                h  = rotl(h, 11) * kPrime1;
+            }
+
+            h ^= h >> 33;
+            h *= kPrime2;
+            h ^= h >> 29;
+            h *= kPrime3;
+            h ^= h >> 32;
+            return h;
+        }
+
+        static uint64_t
+        hash(const void* data, size_t len, uint64_t seed = 0)
+        {
+            XXH64 s(seed);
+            s.update(data, len);
+            return s.digest();
+        }
+
+    private:
+        static constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+        static constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+        static constexpr uint64_t kPrime3 = 0x165667B19E3779F9ull;
+        static constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+        static constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+        static inline uint64_t
+        rotl(uint64_t x, int r)
+        {
+            return (x << r) | (x >> (64 - r));
+        }
+
+        static inline uint64_t
+        read64(const uint8_t* p)
+        {
+            uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        static inline uint32_t
+        read32(const uint8_t* p)
+        {
+            uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        static inline uint64_t
+        round(uint64_t acc, uint64_t input)
+        {
+            acc += input * kPrime2;
+            acc  = rotl(acc, 31);
+            return acc * kPrime1;
+        }
+
+        static inline uint64_t
+        merge_round(uint64_t acc, uint64_t val)
+        {
+            acc ^= round(0, val);
+            return acc * kPrime1 + kPrime4;
+        }
+
+        void
+        consume_stripe(const uint8_t* p)
+        {
+            m_v[0] = round(m_v[0], read64(p));
+            m_v[1] = round(m_v[1], read64(p + 8));
+            m_v[2] = round(m_v[2], read64(p + 16));
+            m_v[3] = round(m_v[3], read64(p + 24));
+        }
+
+        uint64_t m_v[4]{};
+        uint64_t m_seed      = 0;
+        uint64_t m_total_len = 0;
+        uint8_t  m_buf[32]{};
+        size_t   m_buf_len   = 0;
+    };
+}
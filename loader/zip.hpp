@@ -0,0 +1,243 @@
+#pragma once
+
+#include "inflate.hpp"
+#include "mapped_file.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace loader
+{
+    static inline uint32_t
+    crc32_update(uint32_t crc, const uint8_t* p, size_t n)
+    {
+        static const auto kTable = [] {
+            struct T { uint32_t v[256]; } t{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) {
+                    c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+                }
+                t.v[i] = c;
+            }
+            return t;
+        }();
+
+        crc = ~crc;
+        for (size_t i = 0; i < n; ++i) {
+            crc = kTable.v[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    struct ZipEntry {
+        std::string name;            // as stored, '/' separated
+        uint16_t    method = 0;      // 0 = stored, 8 = deflate
+        uint16_t    flags  = 0;
+        uint32_t    crc32  = 0;
+        uint64_t    compressed_size   = 0;
+        uint64_t    uncompressed_size = 0;
+        uint64_t    local_header_offset = 0;
+    };
+
+    // read-only view of a zip archive's central directory over a memory mapping
+    class ZipArchive
+    {
+    public:
+        bool
+        open(const fs::path& path, std::string& err)
+        {
+            if (!m_file.open(path)) {
+                err = "cannot open archive";
+                return false;
+            }
+            return parse(err);
+        }
+
+        const std::vector<ZipEntry>& entries() const { return m_entries; }
+
+        // streams the entry's decoded bytes to `out`, verifying size and CRC
+        bool
+        extract(const ZipEntry& e, std::ostream& out, std::string& err) const
+        {
+            if (e.flags & 1) {
+                err = "encrypted entries are not supported";
+                return false;
+            }
+
+            const uint8_t* base = m_file.data();
+            uint64_t       size = m_file.size();
+
+            uint64_t lh = e.local_header_offset;
+            if (lh > size || size - lh < 30 || rd32(base + lh) != 0x04034b50) {
+                err = "bad local header";
+                return false;
+            }
+
+            uint64_t header = 30 + (uint64_t)rd16(base + lh + 26) + rd16(base + lh + 28);
+            if (size - lh < header || size - lh - header < e.compressed_size) {
+                err = "entry data out of bounds";
+                return false;
+            }
+            uint64_t data = lh + header;
+
+            const uint8_t* src = base + data;
+            uint32_t       crc = 0;
+            uint64_t       n   = 0;
+
+            auto sink = [&](const uint8_t* p, size_t len) {
+                crc = crc32_update(crc, p, len);
+                out.write(reinterpret_cast<const char*>(p), (std::streamsize)len);
+                return (bool)out;
+            };
+
+            if (e.method == 0) {
+                if (e.compressed_size != e.uncompressed_size) {
+                    err = "stored entry size mismatch";
+                    return false;
+                }
+
+                for (uint64_t off = 0; off < e.compressed_size;) {
+                    size_t chunk = (size_t)(std::min<uint64_t>)(e.compressed_size - off, 1u << 20);
+                    if (!sink(src + off, chunk)) {
+                        err = "write failed";
+                        return false;
+                    }
+                    off += chunk;
+                }
+                n = e.compressed_size;
+            } else if (e.method == 8) {
+                InflateStatus s = inflate_raw_stream(src, (size_t)e.compressed_size, sink, &n);
+                if (s != InflateStatus::Ok) {
+                    err = inflate_status_str(s);
+                    return false;
+                }
+            } else {
+                err = "unsupported compression method " + std::to_string(e.method);
+                return false;
+            }
+
+            if (n != e.uncompressed_size) {
+                err = "size mismatch";
+                return false;
+            }
+            if (crc != e.crc32) {
+                err = "CRC mismatch";
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        static inline uint16_t rd16(const uint8_t* p) { uint16_t v; std::memcpy(&v, p, 2); return v; }
+        static inline uint32_t rd32(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+        static inline uint64_t rd64(const uint8_t* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+
+        bool
+        parse(std::string& err)
+        {
+            const uint8_t* base = m_file.data();
+            uint64_t       size = m_file.size();
+
+            if (size < 22) {
+                err = "not a zip archive";
+                return false;
+            }
+
+            // end of central directory: last 22 bytes plus up to 64 KiB of comment
+            uint64_t eocd  = UINT64_MAX;
+            uint64_t lower = size > 22 + 0xFFFF ? size - 22 - 0xFFFF : 0;
+            for (uint64_t i = size - 22 + 1; i-- > lower;) {
+                if (rd32(base + i) == 0x06054b50) {
+                    eocd = i;
+                    break;
+                }
+            }
+            if (eocd == UINT64_MAX) {
+                err = "end of central directory not found";
+                return false;
+            }
+
+            uint64_t count     = rd16(base + eocd + 10);
+            uint64_t cd_size   = rd32(base + eocd + 12);
+            uint64_t cd_offset = rd32(base + eocd + 16);
+
+            // zip64 locator sits right before the classic record
+            if (eocd >= 20 && rd32(base + eocd - 20) == 0x07064b50) {
+                uint64_t z64 = rd64(base + eocd - 20 + 8);
+                if (z64 > size || size - z64 < 56 || rd32(base + z64) != 0x06064b50) {
+                    err = "bad zip64 end of central directory";
+                    return false;
+                }
+                count     = rd64(base + z64 + 32);
+                cd_size   = rd64(base + z64 + 40);
+                cd_offset = rd64(base + z64 + 48);
+            }
+
+            if (cd_offset > size || size - cd_offset < cd_size) {
+                err = "central directory out of bounds";
+                return false;
+            }
+
+            m_entries.clear();
+            m_entries.reserve((size_t)(std::min<uint64_t>)(count, 1u << 16));
+
+            const uint8_t* p   = base + cd_offset;
+            const uint8_t* end = p + cd_size;
+            for (uint64_t i = 0; i < count; ++i) {
+                if (end - p < 46 || rd32(p) != 0x02014b50) {
+                    err = "bad central directory entry";
+                    return false;
+                }
+
+                ZipEntry e;
+                e.flags               = rd16(p + 8);
+                e.method              = rd16(p + 10);
+                e.crc32               = rd32(p + 16);
+                e.compressed_size     = rd32(p + 20);
+                e.uncompressed_size   = rd32(p + 24);
+                e.local_header_offset = rd32(p + 42);
+
+                uint16_t name_len    = rd16(p + 28);
+                uint16_t extra_len   = rd16(p + 30);
+                uint16_t comment_len = rd16(p + 32);
+                if ((size_t)(end - p) < 46u + name_len + extra_len + comment_len) {
+                    err = "bad central directory entry";
+                    return false;
+                }
+
+                e.name.assign(reinterpret_cast<const char*>(p + 46), name_len);
+
+                // zip64 extended information: only the fields saturated in the fixed header are present
+                const uint8_t* x     = p + 46 + name_len;
+                const uint8_t* x_end = x + extra_len;
+                while (x_end - x >= 4) {
+                    uint16_t id  = rd16(x);
+                    uint16_t len = rd16(x + 2);
+                    if (x_end - x - 4 < len) {
+                        break;
+                    }
+
+                    if (id == 0x0001) {
+                        const uint8_t* f     = x + 4;
+                        const uint8_t* f_end = f + len;
+                        if (e.uncompressed_size == 0xFFFFFFFF && f_end - f >= 8) { e.uncompressed_size   = rd64(f); f += 8; }
+                        if (e.compressed_size   == 0xFFFFFFFF && f_end - f >= 8) { e.compressed_size     = rd64(f); f += 8; }
+                        if (e.local_header_offset == 0xFFFFFFFF && f_end - f >= 8) { e.local_header_offset = rd64(f); f += 8; }
+                    }
+                    x += 4 + len;
+                }
+
+                m_entries.push_back(std::move(e));
+                p += 46 + name_len + extra_len + comment_len;
+            }
+            return true;
+        }
+
+        MappedFile            m_file;
+        std::vector<ZipEntry> m_entries;
+    };
+}
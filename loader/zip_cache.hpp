@@ -0,0 +1,250 @@
+#pragma once
+
+#include "content_hash.hpp"
+#include "mod_discovery.hpp"
+#include "parallel.hpp"
+#include "zip.hpp"
+
+#include <cctype>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace loader
+{
+    struct ZipModResult {
+        bool        ok     = false;
+        bool        cached = false;   // extraction dir already existed
+        size_t      files  = 0;
+        uint64_t    bytes  = 0;
+        std::string error;
+    };
+
+    static inline bool
+    is_container_file_name(std::string_view name)
+    {
+        size_t dot = name.rfind('.');
+        if (dot == std::string_view::npos) {
+            return false;
+        }
+
+        std::string ext;
+        for (char c : name.substr(dot + 1)) {
+            ext.push_back((char)std::tolower((unsigned char)c));
+        }
+
+        // .actors: ModActor list of a merged container, see container_actor_names()
+        if (ext == "pak" || ext == "utoc" || ext == "ucas" || ext == "actors") {
+            return true;
+        }
+
+        // .ucas1 .. .ucas16 partitions, see has_ucas_any()
+        if (ext.size() > 4 && ext.compare(0, 4, "ucas") == 0) {
+            for (size_t i = 4; i < ext.size(); ++i) {
+                if (!std::isdigit((unsigned char)ext[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        return false;
+    }
+
+    static inline std::string
+    hash_hex(uint64_t h)
+    {
+        char buf[17];
+        std::snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)h);
+        return buf;
+    }
+
+    // Extracts every container file of `archive` flat into `dest`. Files are written to a sibling
+    // temp dir first and renamed into place, so `dest` only ever exists complete.
+    static inline bool
+    extract_zip_containers(const fs::path& archive, const fs::path& dest, ZipModResult& res)
+    {
+        ZipArchive zip;
+        if (!zip.open(archive, res.error)) {
+            return false;
+        }
+
+        fs::path tmp = dest;
+        tmp += L".tmp";
+
+        std::error_code ec;
+        fs::remove_all(tmp, ec);
+        if (!fs::create_directories(tmp, ec) || ec) {
+            res.error = "cannot create " + path_to_utf8(tmp);
+            return false;
+        }
+
+        std::unordered_set<std::string> seen;
+        bool ok = true;
+
+        for (const auto& e : zip.entries()) {
+            if (e.name.empty() || e.name.back() == '/') {
+                continue;
+            }
+
+            size_t      slash = e.name.find_last_of("/\\");
+            std::string base  = (slash == std::string::npos) ? e.name : e.name.substr(slash + 1);
+            if (!is_container_file_name(base)) {
+                continue;
+            }
+
+            std::string key;
+            for (char c : base) {
+                key.push_back((char)std::tolower((unsigned char)c));
+            }
+            if (!seen.insert(key).second) {
+                res.error = "duplicate container file " + base;
+                ok = false;
+                break;
+            }
+
+            std::ofstream out(tmp / path_from_utf8(base), std::ios::binary | std::ios::trunc);
+            if (!out) {
+                res.error = "cannot write " + base;
+                ok = false;
+                break;
+            }
+
+            if (!zip.extract(e, out, res.error)) {
+                res.error = base + ": " + res.error;
+                ok = false;
+                break;
+            }
+
+            ++res.files;
+            res.bytes += e.uncompressed_size;
+        }
+
+        if (ok && res.files == 0) {
+            res.error = "archive contains no .pak/.utoc/.ucas files";
+            ok = false;
+        }
+
+        if (ok) {
+            fs::rename(tmp, dest, ec);
+            if (ec) {
+                res.error = "cannot rename " + path_to_utf8(tmp);
+                ok = false;
+            }
+        }
+
+        if (!ok) {
+            fs::remove_all(tmp, ec);
+        }
+        return ok;
+    }
+
+    // Points the `dir` of every .zip mod at its extraction dir, cache_root/<xxh64 of archive>/.
+    // Archive hashes go through `cache`, so unchanged archives are neither re-hashed nor
+    // re-extracted. Missing extractions run in parallel, once per distinct archive content.
+    // Returns one result per entry of `mods` (only meaningful for archives).
+    static inline std::vector<ZipModResult>
+    prepare_zip_mods(std::vector<ModSource>& mods, const fs::path& cache_root, HashCache& cache)
+    {
+        std::vector<ZipModResult> results(mods.size());
+        std::vector<size_t>       zips;
+
+        for (size_t i = 0; i < mods.size(); ++i) {
+            if (mods[i].is_zip) {
+                zips.push_back(i);
+            }
+        }
+        if (zips.empty()) {
+            return results;
+        }
+
+        std::vector<uint64_t> hashes(mods.size(), 0);
+        parallel_for(zips.size(), [&](size_t k) {
+            size_t i = zips[k];
+            if (!hash_file_cached(mods[i].path, cache, hashes[i])) {
+                results[i].error = "cannot read archive";
+            }
+        });
+
+        // content hash -> first mod with that content; that one does the extraction
+        std::unordered_map<uint64_t, size_t> owners;
+        std::vector<size_t>                  todo;
+
+        for (size_t i : zips) {
+            if (!results[i].error.empty()) {
+                continue;
+            }
+
+            mods[i].dir = cache_root / fs::path(hash_hex(hashes[i]));
+
+            std::error_code ec;
+            if (fs::is_directory(mods[i].dir, ec)) {
+                results[i].ok     = true;
+                results[i].cached = true;
+                continue;
+            }
+
+            if (owners.emplace(hashes[i], i).second) {
+                todo.push_back(i);
+            }
+        }
+
+        parallel_for(todo.size(), [&](size_t k) {
+            size_t i = todo[k];
+            results[i].ok = extract_zip_containers(mods[i].path, mods[i].dir, results[i]);
+        });
+
+        for (size_t i : zips) {
+            if (results[i].ok || !results[i].error.empty()) {
+                continue;
+            }
+
+            // same content as an archive extracted above
+            const auto& owner = results[owners[hashes[i]]];
+            results[i].ok     = owner.ok;
+            results[i].cached = owner.ok;
+            results[i].error  = owner.error;
+        }
+
+        for (size_t i : zips) {
+            if (!results[i].ok) {
+                mods[i].dir.clear();
+            }
+        }
+        return results;
+    }
+
+    // removes extraction dirs that no current archive maps to
+    static inline size_t
+    prune_zip_cache(const fs::path& cache_root, const std::vector<ModSource>& mods)
+    {
+        std::unordered_set<fs::path::string_type> live;
+        for (const auto& m : mods) {
+            if (m.is_zip && !m.dir.empty()) {
+                live.insert(m.dir.filename().native());
+            }
+        }
+
+        std::error_code ec;
+        if (!fs::is_directory(cache_root, ec)) {
+            return 0;
+        }
+
+        std::vector<fs::path> stale;
+        for (auto& it : fs::directory_iterator(cache_root, ec)) {
+            if (ec) {
+                break;
+            }
+            if (it.is_directory(ec) && live.find(it.path().filename().native()) == live.end()) {
+                stale.push_back(it.path());
+            }
+        }
+
+        for (const auto& p : stale) {
+            fs::remove_all(p, ec);
+        }
+        return stale.size();
+    }
+}
@@ -0,0 +1,207 @@
+// Benchmarks the loader's chunk reader (IoStoreContainer) on real containers: FIoChunkId
+// lookups per second, and chunk reads in GB/s through ChunkBufferPool, on one thread and on
+// --threads threads reading the same open containers. Reads are timed on warm mappings after
+// one untimed pass; every read chunk is touched once so zero-copy views are not free.
+//
+//   chunk_bench <mod_root | file.utoc>... [--threads N] [--seconds S]
+
+#include "container_args.hpp"
+#include "loader/iostore_container.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct ChunkRef {
+    const loader::IoStoreContainer* container;
+    uint32_t                        entry;
+};
+
+static std::atomic<uint64_t> g_sink{ 0 };
+
+// reads every 8th byte, so a zero-copy chunk costs what touching its pages costs
+static uint64_t
+touch(const uint8_t* p, uint64_t n)
+{
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < n; i += 8) {
+        sum += p[i];
+    }
+    return sum;
+}
+
+struct Totals {
+    uint64_t ops     = 0;
+    uint64_t bytes   = 0;
+    uint64_t zero    = 0;   // reads served from the mapping
+    uint64_t failed  = 0;
+    double   seconds = 0;
+};
+
+// runs fn(thread, Totals&) on `threads` threads, each until `seconds` have passed
+template <typename Fn>
+static Totals
+run_for(unsigned threads, double seconds, Fn&& fn)
+{
+    std::vector<Totals>      per(threads);
+    std::vector<std::thread> pool;
+    std::atomic<bool>        stop{ false };
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                fn(t, per[t]);
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& th : pool) {
+        th.join();
+    }
+
+    Totals sum;
+    sum.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    for (const auto& p : per) {
+        sum.ops    += p.ops;
+        sum.bytes  += p.bytes;
+        sum.zero   += p.zero;
+        sum.failed += p.failed;
+    }
+    return sum;
+}
+
+static void
+bench_lookups(const std::vector<ChunkRef>& chunks, unsigned threads, double seconds)
+{
+    // one batch of shuffled ids per thread, looked up over and over
+    std::vector<std::vector<ChunkRef>> batches(threads, chunks);
+    for (unsigned t = 0; t < threads; ++t) {
+        std::shuffle(batches[t].begin(), batches[t].end(), std::mt19937(t + 1));
+    }
+
+    Totals r = run_for(threads, seconds, [&](unsigned t, Totals& out) {
+        for (const ChunkRef& c : batches[t]) {
+            uint32_t e = c.container->find_chunk(c.container->toc().chunk_id(c.entry).p);
+            out.failed += e != c.entry;
+        }
+        out.ops += batches[t].size();
+    });
+
+    std::printf("  lookups  %2u thread(s): %10.2f M/s%s\n", threads, r.ops / r.seconds / 1e6,
+                r.failed ? "  (LOOKUP MISMATCH)" : "");
+}
+
+static void
+bench_reads(const std::vector<ChunkRef>& chunks, unsigned threads, double seconds)
+{
+    loader::ChunkBufferPool pool;
+    std::atomic<size_t>     next{ 0 };
+
+    Totals r = run_for(threads, seconds, [&](unsigned, Totals& out) {
+        const ChunkRef&   c = chunks[next.fetch_add(1, std::memory_order_relaxed) % chunks.size()];
+        loader::ChunkData data;
+        std::string       err;
+        if (!c.container->read_chunk(c.entry, pool, data, err)) {
+            ++out.failed;
+            return;
+        }
+        ++out.ops;
+        out.bytes += data.size;
+        out.zero  += data.zero_copy();
+        g_sink    += touch(data.data, data.size);
+    });
+
+    std::printf("  reads    %2u thread(s): %10.0f chunks/s %8.2f GB/s  (%.0f%% zero-copy, %llu failed, %zu pooled buffer(s))\n",
+                threads, r.ops / r.seconds, r.bytes / r.seconds / 1e9, r.ops ? 100.0 * r.zero / r.ops : 0.0,
+                (unsigned long long)r.failed, pool.idle());
+}
+
+int
+main(int argc, char** argv)
+{
+    std::vector<fs::path> bases;
+    unsigned              threads = std::max(1u, std::thread::hardware_concurrency());
+    double                seconds = 1.0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--threads" && i + 1 < argc) {
+            threads = (unsigned)std::max(1, std::atoi(argv[++i]));
+        } else if (a == "--seconds" && i + 1 < argc) {
+            seconds = std::max(0.1, std::atof(argv[++i]));
+        } else if (!a.empty() && a[0] != '-') {
+            collect_containers(a, bases);
+        } else {
+            bases.clear();
+            break;
+        }
+    }
+
+    if (bases.empty()) {
+        std::fprintf(stderr, "usage: chunk_bench <mod_root | file.utoc>... [--threads N] [--seconds S]\n");
+        return 2;
+    }
+
+    std::vector<std::unique_ptr<loader::IoStoreContainer>> containers;
+    std::vector<ChunkRef>                                  chunks;
+    uint64_t                                               ucas = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (const auto& base : bases) {
+        auto        c = std::make_unique<loader::IoStoreContainer>();
+        std::string err;
+        if (!c->open(base, err)) {
+            std::printf("%s: %s\n", loader::path_to_utf8(base.filename()).c_str(), err.c_str());
+            continue;
+        }
+        if (c->toc().encrypted()) {
+            std::printf("%s: encrypted, skipped\n", loader::path_to_utf8(base.filename()).c_str());
+            continue;
+        }
+        for (uint32_t i = 0; i < c->toc().chunk_count(); ++i) {
+            chunks.push_back(ChunkRef{ c.get(), i });
+        }
+        ucas += c->ucas_bytes();
+        containers.push_back(std::move(c));
+    }
+    double open_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    if (chunks.empty()) {
+        std::fprintf(stderr, "no readable chunks\n");
+        return 1;
+    }
+
+    std::printf("%zu container(s), %zu chunk(s), %.1f MiB of .ucas, opened and indexed in %.1f ms\n",
+                containers.size(), chunks.size(), ucas / 1048576.0, open_ms);
+
+    // fault the mappings in before timing
+    {
+        loader::ChunkBufferPool pool;
+        loader::ChunkData       data;
+        std::string             err;
+        for (const auto& c : chunks) {
+            c.container->read_chunk(c.entry, pool, data, err);
+        }
+    }
+
+    bench_lookups(chunks, 1, seconds);
+    if (threads > 1) {
+        bench_lookups(chunks, threads, seconds);
+    }
+    bench_reads(chunks, 1, seconds);
+    if (threads > 1) {
+        bench_reads(chunks, threads, seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+// Command-line and output helpers shared by the container tools.
+
+#include "loader/content_hash.hpp"
+#include "loader/mod_discovery.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Appends the container bases (path without extension) named by one argument: a .utoc file, or
+// a mod root whose containers with a .utoc are taken as the loader would plan them (zipped
+// mods excluded).
+static inline void
+collect_containers(const fs::path& arg, std::vector<fs::path>& bases)
+{
+    if (arg.extension() == ".utoc") {
+        fs::path base = arg;
+        bases.push_back(base.replace_extension(""));
+        return;
+    }
+
+    for (const auto& mod : loader::discover_mod_dirs(arg)) {
+        if (mod.dir.empty()) {
+            continue;
+        }
+        std::vector<loader::MountEntry> plan;
+        loader::plan_mod_folder(mod, 0, plan);
+        for (const auto& e : plan) {
+            fs::path base = e.path;
+            base.replace_extension("");
+            if (loader::file_exists(loader::base_to_ext(base, L".utoc"))) {
+                bases.push_back(base);
+            }
+        }
+    }
+}
+
+// writes `path`.tmp from source ranges; nullptr ranges are zero padding
+static inline bool
+write_tmp(const fs::path& path, const std::vector<const uint8_t*>& parts, const std::vector<uint32_t>& sizes, std::string& err)
+{
+    fs::path tmp = path;
+    tmp += ".tmp";
+
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    for (size_t i = 0; out && i < parts.size(); ++i) {
+        if (parts[i]) {
+            out.write(reinterpret_cast<const char*>(parts[i]), sizes[i]);
+        } else {
+            static const char zeros[16384] = {};
+            out.write(zeros, sizes[i]);
+        }
+    }
+    if (!out) {
+        err = "cannot write " + loader::path_to_utf8(tmp);
+        return false;
+    }
+    return true;
+}
+
+static inline bool
+replace_with_tmp(const fs::path& path, std::string& err)
+{
+    fs::path tmp = path;
+    tmp += ".tmp";
+
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        err = "cannot replace " + loader::path_to_utf8(path) + ": " + ec.message();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+// Stand-ins for the two engine functions the loader mounts through, FPakPlatformFile::Mount and
+// FIoDispatcher::Mount, with the signatures dllmain hooks (loader/engine_abi.hpp). They open
+// and parse the real containers the way 4.27 does at mount time, keep them open, fill in
+// FIoStatus, and log every call in order, so loader::MountPipeline can run on Linux.
+//
+// Per IoStore mount: map the .utoc and its .ucas partitions and check them against each other,
+// check the key of an encrypted container, insert every chunk id into the global chunk map (the
+// higher order wins) and read the directory index. Per pak mount: map the pak, parse its footer and primary index
+// and, like the engine, mount a sibling .utoc/.ucas through the dispatcher.
+
+#include "loader/engine_abi.hpp"
+#include "loader/iostore_container.hpp"
+#include "loader/key_ring.hpp"
+#include "loader/mount_pipeline.hpp"
+#include "loader/pak.hpp"
+
+#include <chrono>
+#include <cwchar>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct SimMount {
+    bool         pak = false;
+    std::wstring path;     // as the engine was given it
+    int          order = 0;
+    bool         ok    = false;
+    std::wstring status;
+    uint32_t     chunks = 0;   // chunk ids added to the chunk map (IoStore)
+    double       us     = 0;
+};
+
+class SimEngine
+{
+public:
+    explicit SimEngine(const fs::path& working_dir)
+        : m_working_dir(working_dir)
+    {
+    }
+
+    SimEngine(const SimEngine&) = delete;
+    SimEngine& operator=(const SimEngine&) = delete;
+
+    loader::MountBackend
+    backend()
+    {
+        loader::MountBackend b;
+        b.pak_platform_file = this;
+        b.pak_mount         = pak_mount;
+        b.io_dispatcher     = this;
+        b.io_mount          = io_mount;
+        return b;
+    }
+
+    const std::vector<SimMount>& mounts()     const { return m_mounts; }
+    size_t                       chunk_map()  const { return m_chunk_map.size(); }
+    uint32_t                     overridden() const { return m_overridden; }
+
+    static loader::POD::FIoStatus* LOADER_FASTCALL
+    io_mount(void* self, loader::POD::FIoStatus* status, loader::POD::FIoEnvironment* env, loader::POD::FGuid* guid, loader::POD::FAES* key)
+    {
+        auto*    engine = static_cast<SimEngine*>(self);
+        SimMount m;
+        m.path  = env->Path.Data.Data ? env->Path.Data.Data : L"";
+        m.order = env->Order;
+
+        auto t0 = std::chrono::steady_clock::now();
+        engine->mount_iostore(m, *status, *guid, *key);
+        m.us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+
+        m.ok     = status->ErrorCode == loader::POD::EIoErrorCode::Ok;
+        m.status = status->ErrorMessage;
+        engine->m_mounts.push_back(std::move(m));
+        return status;
+    }
+
+    static bool LOADER_FASTCALL
+    pak_mount(void* self, const wchar_t* pak_filename, int pak_order, const wchar_t*, bool load_index)
+    {
+        auto*    engine = static_cast<SimEngine*>(self);
+        SimMount m;
+        m.pak   = true;
+        m.path  = pak_filename ? pak_filename : L"";
+        m.order = pak_order;
+
+        auto t0 = std::chrono::steady_clock::now();
+        engine->mount_pak(m, load_index);
+        m.us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+
+        bool ok = m.ok;
+        engine->m_mounts.push_back(std::move(m));
+        return ok;
+    }
+
+private:
+    struct OpenPak {
+        loader::MappedFile file;
+        loader::PakView    view;
+    };
+
+    struct ChunkOwner {
+        int      order;
+        uint32_t container;
+    };
+
+    fs::path
+    resolve(const std::wstring& game_path) const
+    {
+        fs::path p(game_path);
+        return p.is_absolute() ? p : m_working_dir / p;
+    }
+
+    static void
+    set_status(loader::POD::FIoStatus& status, loader::POD::EIoErrorCode code, const std::wstring& message)
+    {
+        status.ErrorCode = code;
+        std::wcsncpy(status.ErrorMessage, message.c_str(), 127);
+        status.ErrorMessage[127] = L'\0';
+    }
+
+    void
+    mount_iostore(SimMount& m, loader::POD::FIoStatus& status, const loader::POD::FGuid& guid, const loader::POD::FAES& key)
+    {
+        using loader::POD::EIoErrorCode;
+
+        const fs::path base = resolve(m.path);
+        if (!loader::file_exists(loader::base_to_ext(base, L".utoc"))) {
+            set_status(status, EIoErrorCode::FileOpenFailed, L"Failed to open IoStore TOC file");
+            return;
+        }
+
+        std::string err;
+        auto        c = std::make_unique<loader::IoStoreContainer>();
+        if (!c->open(base, err)) {
+            set_status(status, EIoErrorCode::CorruptToc, loader::widen_ascii(err));
+            return;
+        }
+
+        // open() maps the partitions and runs validate_toc()
+        const loader::TocView& toc = c->toc();
+        std::vector<uint8_t>   index(toc.directory_index(), toc.directory_index() + toc.directory_index_size());
+        if (toc.encrypted()) {
+            const uint8_t* id = toc.header().encryption_key_guid;
+            if (guid.A != loader::rd_le32(id) || guid.B != loader::rd_le32(id + 4) ||
+                guid.C != loader::rd_le32(id + 8) || guid.D != loader::rd_le32(id + 12)) {
+                set_status(status, EIoErrorCode::InvalidEncryptionKey, L"Missing decryption key for IoStore container file");
+                return;
+            }
+
+            std::string detail;
+            if (loader::check_container_key(*c, key.Key, detail) == loader::KeyCheck::WrongKey) {
+                set_status(status, EIoErrorCode::InvalidEncryptionKey, L"Invalid decryption key: " + loader::widen_ascii(detail));
+                return;
+            }
+            if (index.size() % loader::Aes256Decryptor::kBlockSize == 0) {
+                loader::Aes256Decryptor(key.Key).decrypt(index.data(), index.size());
+            }
+        }
+
+        if (toc.indexed()) {
+            loader::TocDirectoryIndex dir;
+            if (!dir.parse(index.data(), index.size(), err)) {
+                set_status(status, EIoErrorCode::CorruptToc, L"Directory index: " + loader::widen_ascii(err));
+                return;
+            }
+        }
+
+        const uint32_t container = (uint32_t)m_containers.size();
+        for (uint32_t i = 0; i < toc.chunk_count(); ++i) {
+            std::string_view id(reinterpret_cast<const char*>(toc.chunk_id(i).p), 12);
+            auto [it, fresh] = m_chunk_map.try_emplace(id, ChunkOwner{ m.order, container });
+            if (!fresh) {
+                ++m_overridden;
+                if (m.order >= it->second.order) {
+                    it->second = ChunkOwner{ m.order, container };
+                }
+            }
+        }
+
+        m.chunks = toc.chunk_count();
+        m_containers.push_back(std::move(c));
+        set_status(status, EIoErrorCode::Ok, L"OK");
+    }
+
+    void
+    mount_pak(SimMount& m, bool load_index)
+    {
+        const fs::path path = resolve(m.path);
+
+        auto pak = std::make_unique<OpenPak>();
+        if (!pak->file.open(path)) {
+            m.status = L"cannot open .pak";
+            return;
+        }
+
+        std::string err;
+        if (!pak->view.parse(pak->file.data(), pak->file.size(), err)) {
+            m.status = loader::widen_ascii(err);
+            return;
+        }
+
+        m.ok     = true;
+        m.status = load_index ? L"OK, index loaded" : L"OK";
+        m_paks.push_back(std::move(pak));
+
+        // the pak's IoStore sibling is mounted with the pak's order and the engine's keys,
+        // which the simulator does not have
+        fs::path utoc = path;
+        utoc.replace_extension(L".utoc");
+        if (loader::file_exists(utoc)) {
+            std::wstring                base_path = m.path.substr(0, m.path.size() - path.extension().wstring().size());
+            loader::POD::FIoEnvironment env(std::wstring_view(base_path), m.order);
+            loader::POD::FIoStatus      status{};
+            loader::POD::FGuid          guid{};
+            loader::POD::FAES           key{};
+            io_mount(this, &status, &env, &guid, &key);
+        }
+    }
+
+    fs::path                                               m_working_dir;
+    std::vector<std::unique_ptr<loader::IoStoreContainer>> m_containers;
+    std::vector<std::unique_ptr<OpenPak>>                  m_paks;
+    std::unordered_map<std::string_view, ChunkOwner>       m_chunk_map;   // the dispatcher's chunk id -> container map
+    uint32_t                                               m_overridden = 0;
+    std::vector<SimMount>                                  m_mounts;
+};
@@ -0,0 +1,311 @@
+// Runs the loader's discovery and mount-planning pipeline against a mod tree (see modgen)
+// and reports latency, heap allocations and syscalls per phase.
+//
+//   modbench <mod_root> [--iterations N]
+//
+// Phases mirror mount_all_user_mods_once(): discover -> zip -> plan -> dedupe (cold and
+// warm hash cache) -> cache save -> path interning -> mount pre-checks. Syscalls are counted
+// with the raw_syscalls:sys_enter tracepoint when perf_event_open allows it (needs
+// perf_event_paranoid <= 1 or CAP_PERFMON); otherwise only read/write syscalls from
+// /proc/self/io are reported.
+
+#include "loader/content_hash.hpp"
+#include "loader/mod_discovery.hpp"
+#include "loader/path_arena.hpp"
+#include "loader/zip_cache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static std::atomic<uint64_t> g_alloc_count{ 0 };
+static std::atomic<uint64_t> g_alloc_bytes{ 0 };
+
+void*
+operator new(size_t n)
+{
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(n, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void*
+operator new[](size_t n)
+{
+    return operator new(n);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+class SyscallCounter
+{
+public:
+    SyscallCounter()
+    {
+        for (const char* path : { "/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+                                  "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id" }) {
+            std::ifstream in(path);
+            uint64_t id = 0;
+            if (!(in >> id)) {
+                continue;
+            }
+
+            perf_event_attr attr{};
+            attr.type    = PERF_TYPE_TRACEPOINT;
+            attr.size    = sizeof(attr);
+            attr.config  = id;
+            attr.inherit = 1; // include the dedupe/extraction worker threads
+
+            m_fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+            if (m_fd >= 0) {
+                return;
+            }
+        }
+    }
+
+    ~SyscallCounter()
+    {
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+    }
+
+    bool exact() const { return m_fd >= 0; }
+
+    uint64_t
+    read_count() const
+    {
+        if (m_fd >= 0) {
+            uint64_t v = 0;
+            if (::read(m_fd, &v, sizeof(v)) == (ssize_t)sizeof(v)) {
+                return v;
+            }
+            return 0;
+        }
+
+        // fallback: read + write syscalls only
+        std::ifstream in("/proc/self/io");
+        std::string   key;
+        uint64_t      value = 0;
+        uint64_t      total = 0;
+        while (in >> key >> value) {
+            if (key == "syscr:" || key == "syscw:") {
+                total += value;
+            }
+        }
+        return total;
+    }
+
+private:
+    int m_fd = -1;
+};
+
+struct PhaseSample {
+    double   ms       = 0;
+    uint64_t allocs   = 0;
+    uint64_t bytes    = 0;
+    uint64_t syscalls = 0;
+};
+
+struct Phase {
+    const char*              name;
+    std::vector<PhaseSample> samples;
+};
+
+class Meter
+{
+public:
+    explicit Meter(const SyscallCounter& sc) : m_sc(sc) {}
+
+    template <typename Fn>
+    void
+    run(std::vector<Phase>& phases, size_t idx, const char* name, Fn&& fn)
+    {
+        if (phases.size() <= idx) {
+            phases.push_back(Phase{ name, {} });
+        }
+
+        uint64_t a0 = g_alloc_count.load();
+        uint64_t b0 = g_alloc_bytes.load();
+        uint64_t s0 = m_sc.read_count();
+        auto     t0 = std::chrono::steady_clock::now();
+
+        fn();
+
+        auto     t1 = std::chrono::steady_clock::now();
+        uint64_t s1 = m_sc.read_count();
+
+        PhaseSample s;
+        s.ms       = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        s.allocs   = g_alloc_count.load() - a0;
+        s.bytes    = g_alloc_bytes.load() - b0;
+        s.syscalls = s1 - s0;
+        phases[idx].samples.push_back(s);
+    }
+
+private:
+    const SyscallCounter& m_sc;
+};
+
+static double
+median_ms(std::vector<PhaseSample> v)
+{
+    std::sort(v.begin(), v.end(), [](const PhaseSample& a, const PhaseSample& b) { return a.ms < b.ms; });
+    return v[v.size() / 2].ms;
+}
+
+int
+main(int argc, char** argv)
+{
+    fs::path root;
+    int      iterations = 5;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (!a.empty() && a[0] != '-') {
+            root = a;
+        } else {
+            std::fprintf(stderr, "usage: modbench <mod_root> [--iterations N]\n");
+            return 2;
+        }
+    }
+
+    if (root.empty()) {
+        std::fprintf(stderr, "usage: modbench <mod_root> [--iterations N]\n");
+        return 2;
+    }
+
+    root = fs::absolute(root).lexically_normal();
+
+    const fs::path cache_path = root / ".hashcache.bench";
+    const fs::path zip_root   = root / ".zipcache";
+
+    SyscallCounter     sc;
+    Meter              meter(sc);
+    std::vector<Phase> phases;
+
+    size_t n_mods = 0, n_planned = 0, n_dups = 0, n_outside = 0, n_mounts = 0, n_broken = 0;
+
+    for (int it = 0; it < iterations; ++it) {
+        std::error_code ec;
+        fs::remove(cache_path, ec);
+
+        std::vector<loader::ModSource>  mods;
+        std::vector<loader::MountEntry> plan;
+        loader::HashCache               cache;
+        loader::GamePathArena           arena(root.parent_path().parent_path());
+
+        size_t p = 0;
+
+        meter.run(phases, p++, "discover", [&] {
+            mods = loader::discover_mod_dirs(root);
+        });
+
+        meter.run(phases, p++, "zip", [&] {
+            loader::prepare_zip_mods(mods, zip_root, cache);
+        });
+
+        meter.run(phases, p++, "plan", [&] {
+            for (size_t i = 0; i < mods.size(); ++i) {
+                if (!mods[i].dir.empty()) {
+                    loader::plan_mod_folder(mods[i], 200 + (int)i, plan);
+                }
+            }
+        });
+
+        std::vector<loader::MountEntry> warm_plan = plan;
+
+        meter.run(phases, p++, "dedupe (cold cache)", [&] {
+            n_dups = loader::dedupe_mount_plan(plan, cache).size();
+        });
+
+        meter.run(phases, p++, "cache save", [&] {
+            cache.save(cache_path);
+        });
+
+        meter.run(phases, p++, "dedupe (warm cache)", [&] {
+            loader::HashCache warm;
+            warm.load(cache_path);
+            loader::dedupe_mount_plan(warm_plan, warm);
+        });
+
+        meter.run(phases, p++, "intern paths", [&] {
+            n_outside = loader::intern_game_paths(plan, arena).size();
+        });
+
+        // the file checks mount_one_utoc_ucas() does before calling into the engine
+        meter.run(phases, p++, "mount checks", [&] {
+            n_mounts = n_broken = 0;
+            for (const auto& e : plan) {
+                if (e.skip) {
+                    continue;
+                }
+                if (e.kind == loader::ContainerKind::IoStore) {
+                    fs::path base = e.path;
+                    base.replace_extension(L"");
+                    if (!loader::file_exists(loader::base_to_ext(base, L".utoc")) || !loader::has_ucas_any(base)) {
+                        ++n_broken;
+                        continue;
+                    }
+                }
+                ++n_mounts;
+            }
+        });
+
+        n_mods    = mods.size();
+        n_planned = plan.size();
+    }
+
+    std::error_code ec;
+    fs::remove(cache_path, ec);
+
+    std::printf("root: %s\n", root.c_str());
+    std::printf("mods: %zu, containers planned: %zu, duplicates: %zu, mounts: %zu, broken: %zu, outside cwd: %zu\n",
+                n_mods, n_planned, n_dups, n_mounts, n_broken, n_outside);
+    std::printf("iterations: %d, syscalls: %s\n\n", iterations,
+                sc.exact() ? "all (raw_syscalls:sys_enter)" : "read/write only (/proc/self/io)");
+
+    std::printf("%-22s %10s %10s %10s %12s %10s\n", "phase", "median ms", "min ms", "allocs", "alloc KiB", "syscalls");
+    double total = 0;
+    for (const auto& ph : phases) {
+        double min_ms = ph.samples[0].ms;
+        for (const auto& s : ph.samples) {
+            min_ms = std::min(min_ms, s.ms);
+        }
+
+        const PhaseSample& last = ph.samples.back();
+        double med = median_ms(ph.samples);
+        total += med;
+
+        std::printf("%-22s %10.3f %10.3f %10llu %12.1f %10llu\n", ph.name, med, min_ms,
+                    (unsigned long long)last.allocs, last.bytes / 1024.0, (unsigned long long)last.syscalls);
+    }
+    std::printf("%-22s %10.3f\n", "total", total);
+    return 0;
+}
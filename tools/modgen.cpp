@@ -0,0 +1,211 @@
+// Generates a synthetic IoStoreLoaderMod mod tree for discovery/mount-planning benchmarks.
+//
+//   modgen <out_root> [--mods N] [--seed S] [--size BYTES] [--dup-every N]
+//
+// Mod folders are a mix of .pak-only, .pak+.utoc+.ucas, .utoc/.ucasN-only and broken
+// triplets, plus dlls/, scripts/ and disabled/ noise the loader must ignore. Every
+// --dup-every'th mod ships a byte-identical copy of a shared library container.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct Options {
+    fs::path root;
+    int      mods      = 1000;
+    uint64_t seed      = 1;
+    size_t   size      = 4096;
+    int      dup_every = 25;
+};
+
+static uint64_t
+splitmix(uint64_t& s)
+{
+    uint64_t z = (s += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static bool
+write_file(const fs::path& p, size_t size, uint64_t content_seed)
+{
+    std::ofstream out(p, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::fprintf(stderr, "cannot write %s\n", p.c_str());
+        return false;
+    }
+
+    std::vector<uint64_t> buf((size + 7) / 8);
+    for (auto& w : buf) {
+        w = splitmix(content_seed);
+    }
+    out.write(reinterpret_cast<const char*>(buf.data()), (std::streamsize)size);
+    return (bool)out;
+}
+
+enum class Layout {
+    PakOnly,       // Name.pak
+    PakTriplet,    // Name.pak + Name.utoc + Name.ucas
+    IoStoreOnly,   // Name.utoc + Name.ucas
+    IoStoreSplit,  // Name.utoc + Name.ucas1 + Name.ucas2
+    BrokenNoUcas,  // Name.utoc only
+    BrokenEmpty,   // folder without containers
+    MultiPak,      // Name_a.pak + Name_b.pak
+};
+
+static Layout
+pick_layout(uint64_t& rng)
+{
+    // weights roughly follow what real mod packs look like: mostly IoStore triplets
+    uint64_t r = splitmix(rng) % 100;
+    if (r < 15) return Layout::PakOnly;
+    if (r < 60) return Layout::PakTriplet;
+    if (r < 75) return Layout::IoStoreOnly;
+    if (r < 82) return Layout::IoStoreSplit;
+    if (r < 88) return Layout::BrokenNoUcas;
+    if (r < 92) return Layout::BrokenEmpty;
+    return Layout::MultiPak;
+}
+
+static bool
+generate(const Options& o)
+{
+    std::error_code ec;
+    fs::create_directories(o.root, ec);
+    if (ec) {
+        std::fprintf(stderr, "cannot create %s: %s\n", o.root.c_str(), ec.message().c_str());
+        return false;
+    }
+
+    uint64_t rng   = o.seed;
+    size_t   files = 0;
+    bool     ok    = true;
+
+    auto emit = [&](const fs::path& p, uint64_t content_seed) {
+        ok = write_file(p, o.size, content_seed) && ok;
+        ++files;
+    };
+
+    // noise the loader has to skip
+    fs::create_directories(o.root / "dlls", ec);
+    emit(o.root / "dlls" / "main.dll", 1);
+    fs::create_directories(o.root / "scripts", ec);
+    emit(o.root / "scripts" / "main.lua", 2);
+    for (int i = 0; i < o.mods / 20 + 1; ++i) {
+        fs::path d = o.root / "disabled" / ("Disabled_" + std::to_string(i));
+        fs::create_directories(d, ec);
+        emit(d / ("Disabled_" + std::to_string(i) + ".pak"), splitmix(rng));
+    }
+
+    char name[32];
+    for (int i = 0; i < o.mods && ok; ++i) {
+        std::snprintf(name, sizeof(name), "Mod_%06d", i);
+
+        fs::path dir = o.root / name;
+        fs::create_directories(dir, ec);
+        if (ec) {
+            std::fprintf(stderr, "cannot create %s\n", dir.c_str());
+            return false;
+        }
+
+        // loose non-container files are common in mod folders
+        if (splitmix(rng) % 4 == 0) {
+            emit(dir / "readme.txt", splitmix(rng));
+        }
+
+        fs::path base    = dir / name;
+        uint64_t content = splitmix(rng);
+
+        if (o.dup_every > 0 && i % o.dup_every == 0) {
+            // same bytes in every copy: the dedup pass should keep only the last one
+            fs::path lib = dir / "SharedLib";
+            emit(lib.string() + ".pak", 0xC0FFEE);
+            emit(lib.string() + ".utoc", 0xC0FFEE + 1);
+            emit(lib.string() + ".ucas", 0xC0FFEE + 2);
+            continue;
+        }
+
+        switch (pick_layout(rng)) {
+        case Layout::PakOnly:
+            emit(base.string() + ".pak", content);
+            break;
+        case Layout::PakTriplet:
+            emit(base.string() + ".pak", content);
+            emit(base.string() + ".utoc", content + 1);
+            emit(base.string() + ".ucas", content + 2);
+            break;
+        case Layout::IoStoreOnly:
+            emit(base.string() + ".utoc", content + 1);
+            emit(base.string() + ".ucas", content + 2);
+            break;
+        case Layout::IoStoreSplit:
+            emit(base.string() + ".utoc", content + 1);
+            emit(base.string() + ".ucas1", content + 2);
+            emit(base.string() + ".ucas2", content + 3);
+            break;
+        case Layout::BrokenNoUcas:
+            emit(base.string() + ".utoc", content + 1);
+            break;
+        case Layout::BrokenEmpty:
+            break;
+        case Layout::MultiPak:
+            emit(base.string() + "_a.pak", content);
+            emit(base.string() + "_b.pak", content + 7);
+            break;
+        }
+    }
+
+    std::printf("generated %d mod folder(s), %zu file(s) under %s\n", o.mods, files, o.root.c_str());
+    return ok;
+}
+
+static void
+usage()
+{
+    std::fprintf(stderr, "usage: modgen <out_root> [--mods N] [--seed S] [--size BYTES] [--dup-every N]\n");
+}
+
+int
+main(int argc, char** argv)
+{
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                usage();
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (a == "--mods") {
+            o.mods = std::atoi(next());
+        } else if (a == "--seed") {
+            o.seed = std::strtoull(next(), nullptr, 10);
+        } else if (a == "--size") {
+            o.size = std::strtoull(next(), nullptr, 10);
+        } else if (a == "--dup-every") {
+            o.dup_every = std::atoi(next());
+        } else if (!a.empty() && a[0] == '-') {
+            usage();
+            return 2;
+        } else {
+            o.root = a;
+        }
+    }
+
+    if (o.root.empty() || o.mods <= 0) {
+        usage();
+        return 2;
+    }
+    return generate(o) ? 0 : 1;
+}
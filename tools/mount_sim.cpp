@@ -0,0 +1,178 @@
+// Runs the loader's mount pipeline (loader/mount_pipeline.hpp, the code behind
+// mount_all_user_mods_once) end to end against stand-in engine backends (engine_sim.hpp) that
+// open and parse the real containers, and times it.
+//
+//   mount_sim <mod_root> [--iterations N] [--verbose]
+//
+// <mod_root> plays Mods/IoStoreLoaderMod: config.ini and keys.txt are read from it, and the
+// hash cache, zip cache and (with overrides = on) overrides.txt are written there, as in the
+// game. Game paths are relative to the current directory. The first run prints the loader's log
+// (notices with --verbose) and the mount order; timings are for that first run and the median of
+// the rest.
+// With mount = lazy, each queued actor class is then looked up once, as the spawn does at
+// BeginPlay, and "first use" times the deferred mounts that triggers.
+
+#include "engine_sim.hpp"
+#include "loader/mount_pipeline.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+struct RunResult {
+    loader::MountTimings phases;
+    double               engine    = 0;   // seconds spent inside the stand-in mount calls
+    double               first_use = 0;   // mount = lazy: deferred mounts on the first class lookups
+    double               total     = 0;
+};
+
+static std::string
+narrow(const std::wstring& s)
+{
+    return loader::path_to_utf8(fs::path(s));
+}
+
+static void
+print_log(loader::MountLogLevel level, const std::wstring& line, bool verbose)
+{
+    static const char* const kLevel[] = { "notice", "info", "warn", "error" };
+    if (level == loader::MountLogLevel::Notice && !verbose) {
+        return;
+    }
+    std::printf("[%s] %s", kLevel[(int)level], narrow(line).c_str());
+}
+
+static RunResult
+run_once(const fs::path& mod_root, bool print, bool verbose)
+{
+    auto t0 = std::chrono::steady_clock::now();
+
+    SimEngine             engine(fs::current_path());
+    loader::MountPipeline pipeline(fs::current_path(), mod_root, [&](loader::MountLogLevel level, const std::wstring& line) {
+        if (print) {
+            print_log(level, line, verbose);
+        }
+    });
+    pipeline.load_config();
+    pipeline.run(engine.backend());
+
+    RunResult r;
+    r.total  = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    r.phases = pipeline.timings();
+
+    size_t deferred = pipeline.pending_lazy_mounts();
+    if (deferred) {
+        auto t1 = std::chrono::steady_clock::now();
+        for (const auto& cls : pipeline.actor_classes()) {
+            pipeline.mount_on_first_use(cls.class_path);
+        }
+        r.first_use = std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
+        if (print) {
+            std::printf("first use: %zu of %zu deferred container(s) mounted by %zu class lookup(s)\n",
+                        deferred - pipeline.pending_lazy_mounts(), deferred, pipeline.actor_classes().size());
+            pipeline.log_still_deferred();
+        }
+    }
+    for (const auto& m : engine.mounts()) {
+        r.engine += m.us / 1e6;
+    }
+
+    if (print) {
+        std::printf("\nmount order:\n");
+        std::printf("  %4s %6s %-7s %8s %10s  %s\n", "#", "order", "kind", "chunks", "us", "path / status");
+        size_t n = 0, failed = 0;
+        for (const auto& m : engine.mounts()) {
+            std::printf("  %4zu %6d %-7s %8u %10.1f  %s%s%s\n", ++n, m.order, m.pak ? "pak" : "iostore", m.chunks, m.us,
+                        narrow(m.path).c_str(), m.ok ? "" : "  FAILED: ", m.ok ? "" : narrow(m.status).c_str());
+            failed += !m.ok;
+        }
+        std::printf("%zu mount call(s), %zu failed; chunk map %zu id(s), %u overridden; %zu actor class(es) queued\n",
+                    n, failed, engine.chunk_map(), engine.overridden(), pipeline.actor_classes().size());
+
+        loader::ResidentLedger resident = pipeline.resident();
+        std::printf("\nestimated resident memory: %llu KiB in %zu container(s), %u open handle(s)\n",
+                    (unsigned long long)(resident.total().total() + 1023) / 1024, resident.entries().size(),
+                    resident.total().open_handles);
+        for (const auto& [mod, cost] : resident.largest_mods(10)) {
+            std::printf("  %10llu KiB  %s\n", (unsigned long long)(cost.total() + 1023) / 1024, narrow(mod).c_str());
+        }
+    }
+    return r;
+}
+
+static double
+median(std::vector<double> v)
+{
+    if (v.empty()) {
+        return 0;
+    }
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+int
+main(int argc, char** argv)
+{
+    fs::path mod_root;
+    int      iterations = 5;
+    bool     verbose    = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (a == "--verbose") {
+            verbose = true;
+        } else if (!a.empty() && a[0] != '-' && mod_root.empty()) {
+            mod_root = fs::absolute(a).lexically_normal();
+        } else {
+            mod_root.clear();
+            break;
+        }
+    }
+
+    if (mod_root.empty()) {
+        std::fprintf(stderr, "usage: mount_sim <mod_root> [--iterations N] [--verbose]\n");
+        return 2;
+    }
+
+    std::vector<RunResult> runs;
+    for (int i = 0; i < iterations; ++i) {
+        runs.push_back(run_once(mod_root, i == 0, verbose));
+    }
+
+    struct Row {
+        const char* name;
+        double (*get)(const RunResult&);
+    };
+    static const Row kRows[] = {
+        { "discover", [](const RunResult& r) { return r.phases.discover; } },
+        { "zip",      [](const RunResult& r) { return r.phases.zip; } },
+        { "plan",     [](const RunResult& r) { return r.phases.plan; } },
+        { "dedupe",   [](const RunResult& r) { return r.phases.dedupe; } },
+        { "intern",   [](const RunResult& r) { return r.phases.intern; } },
+        { "index",    [](const RunResult& r) { return r.phases.index; } },
+        { "mount",    [](const RunResult& r) { return r.phases.mount; } },
+        { "  engine", [](const RunResult& r) { return r.engine; } },
+        { "report",   [](const RunResult& r) { return r.phases.report; } },
+        { "total",    [](const RunResult& r) { return r.total; } },
+        { "first use", [](const RunResult& r) { return r.first_use; } },
+    };
+
+    std::printf("\n%-10s %12s %12s\n", "ms", "first", runs.size() > 1 ? "median rest" : "");
+    for (const Row& row : kRows) {
+        std::vector<double> rest;
+        for (size_t i = 1; i < runs.size(); ++i) {
+            rest.push_back(row.get(runs[i]));
+        }
+        std::printf("%-10s %12.2f", row.name, row.get(runs[0]) * 1000.0);
+        if (!rest.empty()) {
+            std::printf(" %12.2f", median(rest) * 1000.0);
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+// Builds the loader's cross-mod override index for a mod folder and writes the override report
+// the loader writes at startup (Mods/IoStoreLoaderMod/overrides.txt).
+//
+//   override_report <mod_root> [--out FILE] [--touch]
+//
+// Orders follow mount_all_user_mods_once(): mods sorted by discover_mod_dirs(), base order 200,
+// duplicate containers skipped. --touch bumps the mtime of one container's .utoc afterwards and
+// times the incremental update that re-reads only that container.
+
+#include "loader/content_hash.hpp"
+#include "loader/mod_discovery.hpp"
+#include "loader/override_index.hpp"
+#include "loader/zip_cache.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static double
+ms_since(std::chrono::steady_clock::time_point t0)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void
+print_update(const char* what, const loader::OverrideUpdateStats& s, double ms)
+{
+    std::printf("%-18s %9.1f ms  containers %zu (parsed %zu, reused %zu, removed %zu, failed %zu), chunks %zu\n",
+                what, ms, s.containers, s.parsed, s.reused, s.removed, s.failed, s.chunks);
+}
+
+int
+main(int argc, char** argv)
+{
+    fs::path root;
+    fs::path out;
+    bool     touch = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--out" && i + 1 < argc) {
+            out = argv[++i];
+        } else if (a == "--touch") {
+            touch = true;
+        } else if (!a.empty() && a[0] != '-') {
+            root = a;
+        } else {
+            root.clear();
+            break;
+        }
+    }
+
+    if (root.empty()) {
+        std::fprintf(stderr, "usage: override_report <mod_root> [--out FILE] [--touch]\n");
+        return 2;
+    }
+    if (out.empty()) {
+        out = root / "overrides.txt";
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    loader::HashCache cache;
+    cache.load(root / ".hashcache");
+
+    auto mods = loader::discover_mod_dirs(root);
+    loader::prepare_zip_mods(mods, root / ".zipcache", cache);
+
+    std::vector<loader::MountEntry> plan;
+    for (size_t i = 0; i < mods.size(); ++i) {
+        if (!mods[i].dir.empty()) {
+            loader::plan_mod_folder(mods[i], 200 + (int)i, plan);
+        }
+    }
+    loader::dedupe_mount_plan(plan, cache);
+    std::printf("%-18s %9.1f ms  %zu mod(s), %zu container(s)\n", "plan", ms_since(t0), mods.size(), plan.size());
+
+    loader::OverrideIndex index;
+
+    t0 = std::chrono::steady_clock::now();
+    auto stats = index.update(plan);
+    print_update("index build", stats, ms_since(t0));
+
+    t0 = std::chrono::steady_clock::now();
+    loader::OverrideReportStats report;
+    if (!loader::write_override_report(index, out, &report)) {
+        std::fprintf(stderr, "cannot write %s\n", out.c_str());
+        return 1;
+    }
+    std::printf("%-18s %9.1f ms  %zu contested package(s), %zu chunk(s), %zu split, %zu tie(s) -> %s\n",
+                "report", ms_since(t0), report.contested_packages, report.contested_chunks,
+                report.split_packages, report.order_ties, out.c_str());
+    std::printf("%-18s %9.1f MiB\n", "index memory", index.table_bytes() / (1024.0 * 1024.0));
+
+    t0 = std::chrono::steady_clock::now();
+    stats = index.update(plan);
+    print_update("update (no change)", stats, ms_since(t0));
+
+    if (touch) {
+        const loader::OverrideIndex::Container* pick = nullptr;
+        for (const auto& c : index.containers()) {
+            if (c.live && (!pick || c.keys.size() > pick->keys.size())) {
+                pick = &c;
+            }
+        }
+
+        if (pick) {
+            fs::path utoc = pick->utoc;
+            std::error_code ec;
+            fs::last_write_time(utoc, fs::file_time_type::clock::now(), ec);
+
+            t0 = std::chrono::steady_clock::now();
+            stats = index.update(plan);
+            print_update("update (1 touched)", stats, ms_since(t0));
+        }
+    }
+    return 0;
+}
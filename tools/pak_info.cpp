@@ -0,0 +1,62 @@
+// Prints a .pak's footer and primary index summary with the loader's pak reader, and the
+// load_index decision the loader makes for it.
+//
+//   pak_info <file.pak>...
+
+#include "loader/mod_discovery.hpp"
+#include "loader/pak.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace fs = std::filesystem;
+
+int
+main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: pak_info <file.pak>...\n");
+        return 2;
+    }
+
+    int rc = 0;
+    for (int a = 1; a < argc; ++a) {
+        fs::path path = argv[a];
+
+        auto t0 = std::chrono::steady_clock::now();
+
+        std::string        err;
+        loader::PakSummary pak;
+        bool ok = loader::read_pak_summary(path, pak, err);
+
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+
+        if (!ok) {
+            std::printf("%s: %s\n", path.c_str(), err.c_str());
+            rc = 1;
+            continue;
+        }
+
+        bool has_utoc = loader::file_exists(loader::base_to_ext(fs::path(path).replace_extension(""), L".utoc"));
+
+        const char* decision = "mount, load index";
+        switch (loader::pak_mount_mode(pak, has_utoc)) {
+        case loader::PakMountMode::LoadIndex: break;
+        case loader::PakMountMode::SkipIndex: decision = "mount, skip index (stub pak for the .utoc)"; break;
+        case loader::PakMountMode::Skip:      decision = "skip (no entries, no .utoc)"; break;
+        }
+
+        std::printf("%s\n", path.c_str());
+        std::printf("  version:      %d\n", pak.info.version);
+        std::printf("  index:        %llu bytes at %llu%s\n", (unsigned long long)pak.info.index_size,
+                    (unsigned long long)pak.info.index_offset, pak.info.encrypted_index ? " (encrypted)" : "");
+        if (pak.index_readable) {
+            std::printf("  mount point:  %s\n", pak.mount_point.c_str());
+            std::printf("  entries:      %u\n", pak.entry_count);
+        }
+        std::printf("  loader:       %s\n", decision);
+        std::printf("  read in:      %.1f us\n", us);
+    }
+    return rc;
+}
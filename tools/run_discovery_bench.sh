@@ -0,0 +1,30 @@
+#!/bin/sh
+# Generates synthetic mod trees of several sizes on tmpfs and on disk and runs modbench on each.
+#
+#   tools/run_discovery_bench.sh <build_dir> [tmpfs_dir] [disk_dir]
+#
+# Defaults: /dev/shm and /var/tmp. For cold page cache numbers on disk, run as root with
+# DROP_CACHES=1 (writes /proc/sys/vm/drop_caches before each disk run).
+set -eu
+
+BUILD=${1:?usage: run_discovery_bench.sh <build_dir> [tmpfs_dir] [disk_dir]}
+TMPFS=${2:-/dev/shm}
+DISK=${3:-/var/tmp}
+SIZES=${SIZES:-"1000 10000 50000"}
+ITER=${ITER:-3}
+
+for base in "$TMPFS" "$DISK"; do
+    for n in $SIZES; do
+        root="$base/iostore-modbench-$n/Mods/IoStoreLoaderMod"
+        if [ ! -d "$root" ]; then
+            "$BUILD/modgen" "$root" --mods "$n" --size 2048
+        fi
+        if [ "$base" = "$DISK" ] && [ "${DROP_CACHES:-0}" = 1 ]; then
+            sync
+            echo 3 > /proc/sys/vm/drop_caches
+        fi
+        echo "== $n mods on $base =="
+        "$BUILD/modbench" "$root" --iterations "$ITER"
+        echo
+    done
+done
@@ -0,0 +1,268 @@
+// Rewrites mod .ucas files so chunks sit in the order a play session first read them, taken
+// from the read_order.bin the loader records with `record_reads` in config.ini, and patches
+// the block offsets in the .utoc to match. Chunks the log does not list follow in their
+// current order.
+//
+//   ucas_reorder <read_order.bin> <mod_root | file.utoc>... [--dry-run]
+//
+// Blocks are moved as they are (compressed, and encrypted if the container is), so chunk ids,
+// hashes, the directory index and the rest of the .utoc are unchanged. Memory-mapped bulk data
+// keeps the 16 KiB alignment the source gave it. Signed and multi-partition containers are left
+// alone. "Jumps" counts the logged reads that do not continue where the previous one ended.
+
+#include "container_args.hpp"
+#include "loader/iostore_container.hpp"
+#include "loader/read_order.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct ReorderStats {
+    uint32_t logged       = 0;   // chunks placed from the log
+    uint32_t unknown      = 0;   // logged chunks the container no longer has
+    uint32_t jumps_before = 0;
+    uint32_t jumps_after  = 0;
+    uint64_t ucas_bytes   = 0;
+    bool     unchanged    = false;
+};
+
+// reads of consecutive logged chunks that do not start where the previous chunk's blocks end
+static uint32_t
+count_jumps(const loader::TocView& toc, const std::vector<uint32_t>& order, size_t logged, const std::vector<uint64_t>& block_offset)
+{
+    uint32_t jumps = 0;
+    uint64_t at    = UINT64_MAX;
+    for (size_t k = 0; k < logged; ++k) {
+        uint64_t first = 0, count = 0;
+        toc.chunk_blocks(order[k], first, count);
+        if (!count) {
+            continue;
+        }
+
+        if (at != UINT64_MAX && block_offset[first] != at) {
+            ++jumps;
+        }
+        loader::TocCompressedBlock last = toc.block((uint32_t)(first + count - 1));
+        at = block_offset[first + count - 1] + toc.block_disk_size(last);
+    }
+    return jumps;
+}
+
+static bool
+reorder(const fs::path& base, const loader::ReadOrderLog& log, bool dry_run, ReorderStats& st, std::string& err)
+{
+    loader::IoStoreContainer c;
+    if (!c.open(base, err)) {
+        return false;
+    }
+
+    const auto& toc = c.toc();
+    const auto& h   = toc.header();
+    if (toc.is_signed()) {
+        err = "signed, left as is";
+        return false;
+    }
+    if (h.partition_count != 1) {
+        err = "multi-partition, left as is";
+        return false;
+    }
+
+    const loader::ReadOrderContainer* logged = log.find(h.container_id, loader::path_to_utf8(base.filename()));
+    if (!logged) {
+        err = "not in the read order log";
+        return false;
+    }
+
+    std::unordered_map<std::string_view, uint32_t> by_id;
+    by_id.reserve(toc.chunk_count());
+    for (uint32_t i = 0; i < toc.chunk_count(); ++i) {
+        by_id.emplace(std::string_view(reinterpret_cast<const char*>(toc.chunk_id(i).p), 12), i);
+    }
+
+    // logged chunks first, in first-read order, then the rest in .ucas order
+    std::vector<uint32_t> order;
+    std::vector<uint8_t>  placed(toc.chunk_count(), 0);
+    order.reserve(toc.chunk_count());
+    for (size_t k = 0; k < logged->chunk_count(); ++k) {
+        auto it = by_id.find(std::string_view(reinterpret_cast<const char*>(logged->chunk_ids.data()) + k * 12, 12));
+        if (it == by_id.end()) {
+            ++st.unknown;
+        } else if (!placed[it->second]) {
+            placed[it->second] = 1;
+            order.push_back(it->second);
+        }
+    }
+    st.logged = (uint32_t)order.size();
+
+    auto disk_offset = [&](uint32_t i) {
+        uint64_t first = 0, count = 0;
+        toc.chunk_blocks(i, first, count);
+        return count ? toc.block((uint32_t)first).offset : 0;
+    };
+    std::vector<uint32_t> rest;
+    for (uint32_t i = 0; i < toc.chunk_count(); ++i) {
+        if (!placed[i]) {
+            rest.push_back(i);
+        }
+    }
+    std::stable_sort(rest.begin(), rest.end(), [&](uint32_t a, uint32_t b) { return disk_offset(a) < disk_offset(b); });
+    order.insert(order.end(), rest.begin(), rest.end());
+
+    // new .ucas as a list of source ranges; nullptr ranges are alignment padding. Block entries
+    // that share one copy on disk (see utoc_compact) keep sharing it.
+    std::vector<const uint8_t*>            parts;
+    std::vector<uint32_t>                  sizes;
+    std::vector<uint64_t>                  old_offset(toc.block_count());
+    std::vector<uint64_t>                  new_offset(toc.block_count(), UINT64_MAX);
+    std::unordered_map<uint64_t, uint64_t> moved_to;
+    uint64_t                               ucas_size = 0;
+
+    auto place = [&](uint32_t b) {
+        if (new_offset[b] != UINT64_MAX) {
+            return;
+        }
+        loader::TocCompressedBlock blk = toc.block(b);
+        auto [it, fresh] = moved_to.emplace(blk.offset, ucas_size);
+        if (fresh) {
+            uint32_t size = (uint32_t)toc.block_disk_size(blk);
+            parts.push_back(c.block_data(blk));
+            sizes.push_back(size);
+            ucas_size += size;
+        }
+        new_offset[b] = it->second;
+    };
+
+    for (uint32_t b = 0; b < toc.block_count(); ++b) {
+        old_offset[b] = toc.block(b).offset;
+    }
+
+    for (uint32_t i : order) {
+        uint64_t first = 0, count = 0;
+        toc.chunk_blocks(i, first, count);
+
+        const bool mapped  = toc.chunk_id(i).type() == loader::IoChunkType::MemoryMappedBulkData;
+        const bool aligned = mapped && count && old_offset[first] % 16384 == 0 && new_offset[first] == UINT64_MAX;
+        if (aligned && ucas_size % 16384) {
+            uint32_t pad = (uint32_t)(16384 - ucas_size % 16384);
+            parts.push_back(nullptr);
+            sizes.push_back(pad);
+            ucas_size += pad;
+        }
+
+        for (uint64_t b = first; b < first + count; ++b) {
+            place((uint32_t)b);
+        }
+    }
+
+    // blocks no chunk references stay, at the end
+    for (uint32_t b = 0; b < toc.block_count(); ++b) {
+        place(b);
+    }
+
+    st.jumps_before = count_jumps(toc, order, st.logged, old_offset);
+    st.jumps_after  = count_jumps(toc, order, st.logged, new_offset);
+    st.ucas_bytes   = ucas_size;
+    st.unchanged    = new_offset == old_offset && ucas_size == c.ucas_bytes();
+
+    if (dry_run || st.unchanged) {
+        return true;
+    }
+
+    // only the 40-bit block offsets change
+    std::vector<uint8_t> toc_bytes(toc.data(), toc.data() + toc.size());
+    uint8_t*             blocks = toc_bytes.data() + loader::kTocHeaderSize + (size_t)toc.chunk_count() * 22;
+    for (uint32_t b = 0; b < toc.block_count(); ++b) {
+        uint8_t* p = blocks + (size_t)b * loader::kTocBlockEntrySize;
+        for (int k = 0; k < 5; ++k) {
+            p[k] = (uint8_t)(new_offset[b] >> (8 * k));
+        }
+    }
+
+    fs::path utoc = base;
+    fs::path ucas = loader::ucas_partition_path(base, 0);
+    utoc += ".utoc";
+
+    if (!write_tmp(ucas, parts, sizes, err) ||
+        !write_tmp(utoc, { toc_bytes.data() }, { (uint32_t)toc_bytes.size() }, err)) {
+        return false;
+    }
+
+    // unmap the sources before replacing them
+    c = loader::IoStoreContainer{};
+    return replace_with_tmp(ucas, err) && replace_with_tmp(utoc, err);
+}
+
+int
+main(int argc, char** argv)
+{
+    fs::path              log_path;
+    std::vector<fs::path> args;
+    bool                  dry_run = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--dry-run") {
+            dry_run = true;
+        } else if (!a.empty() && a[0] != '-') {
+            if (log_path.empty()) {
+                log_path = a;
+            } else {
+                args.emplace_back(a);
+            }
+        } else {
+            args.clear();
+            break;
+        }
+    }
+
+    if (args.empty()) {
+        std::fprintf(stderr, "usage: ucas_reorder <read_order.bin> <mod_root | file.utoc>... [--dry-run]\n");
+        return 2;
+    }
+
+    std::string          err;
+    loader::ReadOrderLog log;
+    if (!loader::read_read_order_log(log_path, log, err)) {
+        std::fprintf(stderr, "%s: %s\n", loader::path_to_utf8(log_path).c_str(), err.c_str());
+        return 1;
+    }
+
+    std::vector<fs::path> bases;
+    for (const auto& a : args) {
+        collect_containers(a, bases);
+    }
+
+    size_t   done = 0, skipped = 0;
+    uint64_t jumps_before = 0, jumps_after = 0;
+
+    for (const auto& base : bases) {
+        ReorderStats st;
+        std::string  name = loader::path_to_utf8(base.filename());
+
+        if (!reorder(base, log, dry_run, st, err)) {
+            std::printf("%-32s %s\n", name.c_str(), err.c_str());
+            ++skipped;
+            continue;
+        }
+
+        std::printf("%-32s %u logged chunk(s) first%s, jumps %u -> %u, .ucas %llu bytes%s\n",
+                    name.c_str(), st.logged, st.unknown ? (" (" + std::to_string(st.unknown) + " unknown)").c_str() : "",
+                    st.jumps_before, st.jumps_after, (unsigned long long)st.ucas_bytes,
+                    st.unchanged ? ", already in order" : "");
+
+        jumps_before += st.jumps_before;
+        jumps_after  += st.jumps_after;
+        ++done;
+    }
+
+    std::printf("\n%zu container(s)%s, %zu left as is; jumps between logged reads %llu -> %llu\n",
+                done, dry_run ? " (dry run)" : " reordered", skipped,
+                (unsigned long long)jumps_before, (unsigned long long)jumps_after);
+    return 0;
+}
@@ -0,0 +1,69 @@
+// Runs the loader's .ucas integrity check (config.ini: verify = background | block) on
+// containers and prints per-container results and throughput.
+//
+//   ucas_verify <mod_root | file.utoc>...
+
+#include "container_args.hpp"
+#include "loader/content_hash.hpp"
+#include "loader/ucas_verify.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+int
+main(int argc, char** argv)
+{
+    std::vector<fs::path> bases;
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i][0] == '-') {
+            bases.clear();
+            break;
+        }
+        collect_containers(argv[i], bases);
+    }
+
+    if (bases.empty()) {
+        std::fprintf(stderr, "usage: ucas_verify <mod_root | file.utoc>...\n");
+        return 2;
+    }
+
+    uint64_t bytes = 0;
+    size_t   bad   = 0;
+    auto     t0    = std::chrono::steady_clock::now();
+
+    for (const auto& base : bases) {
+        std::string              name = loader::path_to_utf8(base.filename());
+        std::string              err;
+        loader::UcasVerifyResult r;
+
+        if (!loader::verify_iostore_container(base, r, err)) {
+            std::printf("%-32s cannot verify: %s\n", name.c_str(), err.c_str());
+            ++bad;
+            continue;
+        }
+
+        std::printf("%-32s %s  %llu chunk(s), %llu block signature(s), %llu unhashed, %llu skipped, %.1f MiB (%.1f MiB decompressed) in %.1f ms (%.0f MiB/s)\n",
+                    name.c_str(), r.ok() ? "ok     " : "CORRUPT",
+                    (unsigned long long)r.chunks, (unsigned long long)r.blocks,
+                    (unsigned long long)r.chunks_unhashed, (unsigned long long)r.chunks_skipped,
+                    r.bytes / (1024.0 * 1024.0), r.hashed / (1024.0 * 1024.0), r.seconds * 1000.0, r.mib_per_s());
+        for (const auto& e : r.errors) {
+            std::printf("    %s\n", e.c_str());
+        }
+        if (r.failures > r.errors.size()) {
+            std::printf("    ... %llu more\n", (unsigned long long)(r.failures - r.errors.size()));
+        }
+
+        bytes += r.bytes;
+        bad   += r.ok() ? 0 : 1;
+    }
+
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("\n%zu container(s), %zu corrupt, %.1f MiB in %.2f s (%.0f MiB/s)\n",
+                bases.size(), bad, bytes / (1024.0 * 1024.0), s, s > 0 ? bytes / (1024.0 * 1024.0) / s : 0.0);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,270 @@
+// Audits how mod containers are compressed: per-method ratios, block fill and on-disk size
+// distribution, block layout, and (with --bench) decode throughput of the methods the loader
+// can decode (None, Zlib, LZ4). Flags layouts that are likely to hurt streaming.
+//
+//   utoc_audit <mod_root | file.utoc>... [--bench] [--sample-mib N]
+
+#include "container_args.hpp"
+#include "loader/content_hash.hpp"
+#include "loader/iostore_container.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static constexpr uint32_t kAuditMinBlockSize   = 64 * 1024;   // UE's default compression block size
+static constexpr uint64_t kAuditSmallDiskBlock = 4 * 1024;
+static constexpr double   kAuditPoorRatio      = 0.95;
+
+struct MethodStats {
+    uint64_t blocks    = 0;
+    uint64_t raw       = 0;   // uncompressed bytes
+    uint64_t disk      = 0;
+    double   decode_s  = 0;
+    uint64_t decoded   = 0;   // bytes decoded by --bench
+    bool     failed    = false;
+};
+
+struct Audit {
+    uint32_t                           block_size = 0;
+    uint64_t                           blocks     = 0;
+    uint64_t                           chunks     = 0;
+    uint64_t                           raw        = 0;
+    uint64_t                           disk       = 0;
+    std::map<std::string, MethodStats> methods;
+    uint64_t                           fill[5]    = {};   // <25%, <50%, <75%, <100%, full
+    uint64_t                           sizes[4]   = {};   // on disk: <4K, <16K, <64K, >=64K
+    uint64_t                           out_of_order = 0;
+    uint64_t                           straddling   = 0;  // cross a 64 KiB file boundary
+    std::vector<std::string>           flags;
+};
+
+static void
+audit_layout(const loader::IoStoreContainer& c, Audit& a)
+{
+    const auto& toc = c.toc();
+    a.block_size = toc.header().compression_block_size;
+    a.blocks     = toc.block_count();
+    a.chunks     = toc.chunk_count();
+
+    uint64_t prev_end = 0;
+    for (uint32_t i = 0; i < toc.block_count(); ++i) {
+        loader::TocCompressedBlock b    = toc.block(i);
+        uint64_t                   disk = toc.block_disk_size(b);
+
+        MethodStats& m = a.methods[std::string(toc.method_name(b.method))];
+        ++m.blocks;
+        m.raw  += b.uncompressed_size;
+        m.disk += disk;
+        a.raw  += b.uncompressed_size;
+        a.disk += disk;
+
+        uint64_t fill = (uint64_t)b.uncompressed_size * 4 / a.block_size;
+        a.fill[b.uncompressed_size == a.block_size ? 4 : (std::min)(fill, (uint64_t)3)]++;
+        a.sizes[disk < 4096 ? 0 : disk < 16384 ? 1 : disk < 65536 ? 2 : 3]++;
+
+        if (b.offset < prev_end) {
+            ++a.out_of_order;
+        }
+        prev_end = b.offset + disk;
+
+        if (disk && b.offset / 65536 != (b.offset + disk - 1) / 65536) {
+            ++a.straddling;
+        }
+    }
+}
+
+static void
+bench_decode(const loader::IoStoreContainer& c, Audit& a, uint64_t sample_bytes)
+{
+    const auto& toc = c.toc();
+    if (toc.encrypted()) {
+        return;
+    }
+
+    std::vector<uint8_t> out(toc.header().compression_block_size);
+    for (uint32_t i = 0; i < toc.block_count(); ++i) {
+        loader::TocCompressedBlock b    = toc.block(i);
+        std::string_view           name = toc.method_name(b.method);
+        MethodStats&               m    = a.methods[std::string(name)];
+        if (m.failed || m.decoded >= sample_bytes || !loader::block_method_supported(name)) {
+            continue;
+        }
+
+        auto        t0 = std::chrono::steady_clock::now();
+        const char* e  = nullptr;
+        bool        ok = loader::decode_block(name, c.block_data(b), b.compressed_size, out.data(), b.uncompressed_size, &e);
+        m.decode_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        m.decoded  += b.uncompressed_size;
+        m.failed    = !ok;
+    }
+}
+
+static void
+flag_layout(Audit& a)
+{
+    auto pct = [](uint64_t n, uint64_t of) { return of ? 100.0 * n / of : 0.0; };
+    char buf[256];
+
+    if (a.block_size < kAuditMinBlockSize) {
+        std::snprintf(buf, sizeof(buf), "%u KiB compression blocks (UE default %u KiB): %.0fx the block entries and read requests per MiB",
+                      a.block_size / 1024, kAuditMinBlockSize / 1024, (double)kAuditMinBlockSize / a.block_size);
+        a.flags.push_back(buf);
+    }
+
+    auto none = a.methods.find("None");
+    if (none != a.methods.end() && none->second.raw > (1u << 20) && none->second.raw * 2 > a.raw) {
+        std::snprintf(buf, sizeof(buf), "%.0f%% of the data (%.1f MiB) is stored uncompressed",
+                      pct(none->second.raw, a.raw), none->second.raw / 1048576.0);
+        a.flags.push_back(buf);
+    }
+
+    for (const auto& [name, m] : a.methods) {
+        if (name != "None" && m.raw && (double)m.disk / m.raw > kAuditPoorRatio) {
+            std::snprintf(buf, sizeof(buf), "%s blocks only shrink to %.0f%%: decode cost for almost no read savings",
+                          name.c_str(), 100.0 * m.disk / m.raw);
+            a.flags.push_back(buf);
+        }
+        if (m.failed) {
+            std::snprintf(buf, sizeof(buf), "%s blocks fail to decode", name.c_str());
+            a.flags.push_back(buf);
+        }
+    }
+
+    if (a.blocks >= 64 && a.disk / a.blocks < kAuditSmallDiskBlock) {
+        std::snprintf(buf, sizeof(buf), "average block is %llu bytes on disk: per-request overhead dominates reads",
+                      (unsigned long long)(a.disk / a.blocks));
+        a.flags.push_back(buf);
+    }
+
+    if (a.out_of_order) {
+        std::snprintf(buf, sizeof(buf), "%llu block(s) are out of order on disk: chunk reads seek backwards",
+                      (unsigned long long)a.out_of_order);
+        a.flags.push_back(buf);
+    }
+}
+
+static void
+print_audit(const std::string& name, const Audit& a, bool bench)
+{
+    std::printf("%s: %u KiB blocks, %llu block(s), %llu chunk(s), %.1f MiB on disk for %.1f MiB (%.0f%%)\n",
+                name.c_str(), a.block_size / 1024, (unsigned long long)a.blocks, (unsigned long long)a.chunks,
+                a.disk / 1048576.0, a.raw / 1048576.0, a.raw ? 100.0 * a.disk / a.raw : 0.0);
+
+    for (const auto& [method, m] : a.methods) {
+        std::printf("  %-8s %8llu block(s) %10.1f MiB -> %10.1f MiB  ratio %5.1f%%", method.c_str(), (unsigned long long)m.blocks,
+                    m.raw / 1048576.0, m.disk / 1048576.0, m.raw ? 100.0 * m.disk / m.raw : 0.0);
+        if (bench && m.decode_s > 0) {
+            std::printf("  decode %7.0f MiB/s", m.decoded / 1048576.0 / m.decode_s);
+        } else if (bench && !loader::block_method_supported(method)) {
+            std::printf("  decode n/a");
+        }
+        std::printf("\n");
+    }
+
+    std::printf("  block fill:   <25%% %llu, <50%% %llu, <75%% %llu, <100%% %llu, full %llu\n",
+                (unsigned long long)a.fill[0], (unsigned long long)a.fill[1], (unsigned long long)a.fill[2],
+                (unsigned long long)a.fill[3], (unsigned long long)a.fill[4]);
+    std::printf("  size on disk: <4K %llu, <16K %llu, <64K %llu, >=64K %llu; %llu cross a 64 KiB file boundary\n",
+                (unsigned long long)a.sizes[0], (unsigned long long)a.sizes[1], (unsigned long long)a.sizes[2],
+                (unsigned long long)a.sizes[3], (unsigned long long)a.straddling);
+    for (const auto& f : a.flags) {
+        std::printf("  ! %s\n", f.c_str());
+    }
+}
+
+int
+main(int argc, char** argv)
+{
+    std::vector<fs::path> bases;
+    bool                  bench  = false;
+    uint64_t              sample = 64ull << 20;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--bench") {
+            bench = true;
+        } else if (a == "--sample-mib" && i + 1 < argc) {
+            sample = std::stoull(argv[++i]) << 20;
+        } else if (!a.empty() && a[0] != '-') {
+            collect_containers(a, bases);
+        } else {
+            bases.clear();
+            break;
+        }
+    }
+
+    if (bases.empty()) {
+        std::fprintf(stderr, "usage: utoc_audit <mod_root | file.utoc>... [--bench] [--sample-mib N]\n");
+        return 2;
+    }
+
+    Audit                    total;
+    std::vector<std::string> flagged;
+
+    for (const auto& base : bases) {
+        std::string              name = loader::path_to_utf8(base.filename());
+        std::string              err;
+        loader::IoStoreContainer c;
+        if (!c.open(base, err)) {
+            std::printf("%s: %s\n\n", name.c_str(), err.c_str());
+            continue;
+        }
+
+        Audit a;
+        audit_layout(c, a);
+        if (bench) {
+            bench_decode(c, a, sample);
+        }
+        flag_layout(a);
+        print_audit(name, a, bench);
+        std::printf("\n");
+
+        if (!a.flags.empty()) {
+            flagged.push_back(name);
+        }
+
+        total.blocks += a.blocks;
+        total.chunks += a.chunks;
+        total.raw    += a.raw;
+        total.disk   += a.disk;
+        for (const auto& [method, m] : a.methods) {
+            MethodStats& t = total.methods[method];
+            t.blocks   += m.blocks;
+            t.raw      += m.raw;
+            t.disk     += m.disk;
+            t.decode_s += m.decode_s;
+            t.decoded  += m.decoded;
+        }
+        for (int k = 0; k < 5; ++k) {
+            total.fill[k] += a.fill[k];
+        }
+        for (int k = 0; k < 4; ++k) {
+            total.sizes[k] += a.sizes[k];
+        }
+        total.straddling += a.straddling;
+    }
+
+    if (bases.size() > 1) {
+        std::printf("all %zu container(s): %llu block(s), %.1f MiB on disk for %.1f MiB\n", bases.size(),
+                    (unsigned long long)total.blocks, total.disk / 1048576.0, total.raw / 1048576.0);
+        for (const auto& [method, m] : total.methods) {
+            std::printf("  %-8s %8llu block(s) %10.1f MiB -> %10.1f MiB  ratio %5.1f%%", method.c_str(), (unsigned long long)m.blocks,
+                        m.raw / 1048576.0, m.disk / 1048576.0, m.raw ? 100.0 * m.disk / m.raw : 0.0);
+            if (bench && m.decode_s > 0) {
+                std::printf("  decode %7.0f MiB/s", m.decoded / 1048576.0 / m.decode_s);
+            }
+            std::printf("\n");
+        }
+    }
+
+    std::printf("%zu of %zu container(s) flagged%s\n", flagged.size(), bases.size(), flagged.empty() ? "" : ":");
+    for (const auto& f : flagged) {
+        std::printf("  %s\n", f.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,259 @@
+// Rewrites IoStore containers with a smaller .utoc, the part the engine keeps resident while the
+// container is mounted.
+//
+//   utoc_compact <mod_root | file.utoc>... [--drop-index] [--dry-run]
+//
+// Per container:
+//   - drops the block signature table (Signed flag cleared); the 4.27 reader keeps it resident
+//     but only checks it for signed builds, which do not accept mod containers anyway
+//   - drops compression method names no block uses
+//   - drops .ucas blocks no chunk references and stores byte-identical blocks once, with
+//     every block entry pointing at the single copy (memory-mapped bulk data is left contiguous)
+//   - rebuilds the directory index with a deduplicated string table, or drops it with
+//     --drop-index (only for containers nothing looks up by file name)
+// Chunk ids, lengths and metas are kept as they are. Encrypted and multi-partition containers
+// are left alone. --dry-run prints the savings without writing anything.
+
+#include "container_args.hpp"
+#include "loader/content_hash.hpp"
+#include "loader/iostore_container.hpp"
+#include "loader/utoc_writer.hpp"
+#include "loader/xxhash64.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct CompactStats {
+    uint64_t toc_before      = 0;
+    uint64_t toc_after       = 0;
+    uint64_t ucas_before     = 0;
+    uint64_t ucas_after      = 0;
+    uint64_t signature_bytes = 0;
+    uint64_t index_before    = 0;
+    uint64_t index_after     = 0;
+    uint32_t methods_dropped = 0;
+    uint32_t blocks_aliased  = 0;
+};
+
+struct Options {
+    bool drop_index = false;
+    bool dry_run    = false;
+};
+
+static bool
+compact(const fs::path& base, const Options& opt, CompactStats& st, std::string& err)
+{
+    loader::IoStoreContainer c;
+    if (!c.open(base, err)) {
+        return false;
+    }
+
+    const auto& toc = c.toc();
+    const auto& h   = toc.header();
+    if (toc.encrypted()) {
+        err = "encrypted, left as is";
+        return false;
+    }
+    if (h.partition_count != 1) {
+        err = "multi-partition, left as is";
+        return false;
+    }
+
+    st.toc_before      = c.toc_bytes();
+    st.ucas_before     = c.ucas_bytes();
+    st.signature_bytes = toc.is_signed() ? 4 + 2ull * toc.signature_size() + (uint64_t)toc.block_count() * loader::kTocShaHashSize : 0;
+    st.index_before    = toc.indexed() ? toc.directory_index_size() : 0;
+
+    loader::TocWriter writer(h.compression_block_size);
+
+    // new .ucas as a list of source ranges; nullptr ranges are alignment padding
+    std::vector<const uint8_t*> parts;
+    std::vector<uint32_t>       sizes;
+    uint64_t                    ucas_size = 0;
+    bool                        moved     = false;
+
+    struct Stored {
+        uint64_t       offset;
+        const uint8_t* data;
+        uint32_t       size;
+        uint32_t       usize;
+        uint8_t        method;
+    };
+    std::unordered_multimap<uint64_t, Stored> stored;
+
+    for (uint32_t i = 0; i < toc.chunk_count(); ++i) {
+        loader::IoChunkId       id = toc.chunk_id(i);
+        loader::TocOffsetLength ol = toc.offset_length(i);
+        if (ol.offset % h.compression_block_size) {
+            err = "chunk " + std::to_string(i) + " does not start on a block boundary, left as is";
+            return false;
+        }
+
+        uint64_t first = 0, count = 0;
+        toc.chunk_blocks(i, first, count);
+
+        // memory-mapped bulk data is read straight from the .ucas: keep it contiguous, and keep
+        // the 16 KiB alignment the source gave it
+        const bool mapped  = id.type() == loader::IoChunkType::MemoryMappedBulkData;
+        const bool aligned = mapped && count && toc.block((uint32_t)first).offset % 16384 == 0;
+        if (aligned && ucas_size % 16384) {
+            uint32_t pad = (uint32_t)(16384 - ucas_size % 16384);
+            parts.push_back(nullptr);
+            sizes.push_back(pad);
+            ucas_size += pad;
+        }
+
+        writer.add_chunk(id.p, ol.length, toc.chunk_hash(i));
+
+        for (uint64_t b = first; b < first + count; ++b) {
+            loader::TocCompressedBlock blk    = toc.block((uint32_t)b);
+            const uint8_t*             data   = c.block_data(blk);
+            uint8_t                    method = writer.method(toc.method_name(blk.method));
+
+            uint64_t offset = UINT64_MAX;
+            uint64_t key    = loader::XXH64::hash(data, blk.compressed_size, blk.uncompressed_size);
+            if (!mapped) {
+                auto range = stored.equal_range(key);
+                for (auto it = range.first; it != range.second; ++it) {
+                    const Stored& s = it->second;
+                    if (s.size == blk.compressed_size && s.usize == blk.uncompressed_size && s.method == method && std::memcmp(s.data, data, s.size) == 0) {
+                        offset = s.offset;
+                        ++st.blocks_aliased;
+                        break;
+                    }
+                }
+            }
+
+            if (offset == UINT64_MAX) {
+                offset = ucas_size;
+                parts.push_back(data);
+                sizes.push_back(blk.compressed_size);
+                ucas_size += blk.compressed_size;
+                stored.emplace(key, Stored{ offset, data, blk.compressed_size, blk.uncompressed_size, method });
+            }
+
+            moved = moved || offset != blk.offset;
+            writer.add_block(offset, blk.compressed_size, blk.uncompressed_size, method);
+        }
+    }
+
+    st.methods_dropped = h.compression_method_name_count - writer.method_count();
+
+    if (toc.indexed() && !opt.drop_index) {
+        loader::TocDirectoryIndex dir;
+        if (!dir.parse(toc.directory_index(), toc.directory_index_size(), err)) {
+            return false;
+        }
+
+        std::string                   mount = dir.mount_point().utf8();
+        loader::DirectoryIndexBuilder builder;
+        dir.for_each_file([&](std::string_view path, uint32_t entry) {
+            builder.add_file(path.substr(mount.size()), entry);
+        });
+
+        std::vector<uint8_t> index = builder.serialize(mount);
+        if (index.size() < toc.directory_index_size()) {
+            writer.set_directory_index(std::move(index));
+        } else {
+            writer.set_directory_index(std::vector<uint8_t>(toc.directory_index(), toc.directory_index() + toc.directory_index_size()));
+        }
+    }
+
+    std::vector<uint8_t> toc_bytes = writer.serialize(h.container_id);
+    st.toc_after   = toc_bytes.size();
+    st.ucas_after  = ucas_size;
+    st.index_after = writer.directory_index_size();
+
+    if (opt.dry_run) {
+        return true;
+    }
+
+    fs::path   utoc         = base;
+    fs::path   ucas         = loader::ucas_partition_path(base, 0);
+    const bool rewrite_ucas = moved || ucas_size != st.ucas_before;
+    utoc += ".utoc";
+
+    if ((rewrite_ucas && !write_tmp(ucas, parts, sizes, err)) ||
+        !write_tmp(utoc, { toc_bytes.data() }, { (uint32_t)toc_bytes.size() }, err)) {
+        return false;
+    }
+
+    // unmap the sources before replacing them
+    c = loader::IoStoreContainer{};
+    return (!rewrite_ucas || replace_with_tmp(ucas, err)) && replace_with_tmp(utoc, err);
+}
+
+int
+main(int argc, char** argv)
+{
+    Options               opt;
+    std::vector<fs::path> args;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--drop-index") {
+            opt.drop_index = true;
+        } else if (a == "--dry-run") {
+            opt.dry_run = true;
+        } else if (!a.empty() && a[0] != '-') {
+            args.emplace_back(a);
+        } else {
+            args.clear();
+            break;
+        }
+    }
+
+    if (args.empty()) {
+        std::fprintf(stderr, "usage: utoc_compact <mod_root | file.utoc>... [--drop-index] [--dry-run]\n");
+        return 2;
+    }
+
+    std::vector<fs::path> bases;
+    for (const auto& a : args) {
+        collect_containers(a, bases);
+    }
+
+    CompactStats total;
+    size_t       done = 0, failed = 0;
+
+    for (const auto& base : bases) {
+        CompactStats st;
+        std::string  err;
+        std::string  name = loader::path_to_utf8(base.filename());
+
+        if (!compact(base, opt, st, err)) {
+            std::printf("%-32s %s\n", name.c_str(), err.c_str());
+            ++failed;
+            continue;
+        }
+
+        std::printf("%-32s utoc %9llu -> %9llu (signatures -%llu, index %llu -> %llu, methods -%u)  ucas %11llu -> %11llu (%u block(s) aliased)\n",
+                    name.c_str(),
+                    (unsigned long long)st.toc_before, (unsigned long long)st.toc_after,
+                    (unsigned long long)st.signature_bytes,
+                    (unsigned long long)st.index_before, (unsigned long long)st.index_after,
+                    st.methods_dropped,
+                    (unsigned long long)st.ucas_before, (unsigned long long)st.ucas_after,
+                    st.blocks_aliased);
+
+        total.toc_before  += st.toc_before;
+        total.toc_after   += st.toc_after;
+        total.ucas_before += st.ucas_before;
+        total.ucas_after  += st.ucas_after;
+        ++done;
+    }
+
+    std::printf("\n%zu container(s)%s, %zu left as is\n", done, opt.dry_run ? " (dry run)" : " compacted", failed);
+    std::printf("  .utoc (resident while mounted): %llu -> %llu bytes, %lld saved\n",
+                (unsigned long long)total.toc_before, (unsigned long long)total.toc_after,
+                (long long)(total.toc_before - total.toc_after));
+    std::printf("  .ucas:                          %llu -> %llu bytes, %lld saved\n",
+                (unsigned long long)total.ucas_before, (unsigned long long)total.ucas_after,
+                (long long)(total.ucas_before - total.ucas_after));
+    return 0;
+}
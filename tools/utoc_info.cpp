@@ -0,0 +1,226 @@
+// Dumps and validates a UE 4.27 .utoc with the loader's TOC reader, and times the parse.
+//
+//   utoc_info <file.utoc> [--files] [--iterations N] [--keys keys.txt]
+//
+// Validation is the same check the loader runs before handing a container to the engine.
+// Timings are medians over N runs on the already-mapped (warm) file. With --keys, an encrypted
+// container's key is looked up and checked the way the loader does before mounting it.
+
+#include "loader/key_ring.hpp"
+#include "loader/mapped_file.hpp"
+#include "loader/resident.hpp"
+#include "loader/utoc.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static const char*
+chunk_type_name(loader::IoChunkType t)
+{
+    switch (t) {
+    case loader::IoChunkType::Invalid:                return "Invalid";
+    case loader::IoChunkType::InstallManifest:        return "InstallManifest";
+    case loader::IoChunkType::ExportBundleData:       return "ExportBundleData";
+    case loader::IoChunkType::BulkData:               return "BulkData";
+    case loader::IoChunkType::OptionalBulkData:       return "OptionalBulkData";
+    case loader::IoChunkType::MemoryMappedBulkData:   return "MemoryMappedBulkData";
+    case loader::IoChunkType::LoaderGlobalMeta:       return "LoaderGlobalMeta";
+    case loader::IoChunkType::LoaderInitialLoadMeta:  return "LoaderInitialLoadMeta";
+    case loader::IoChunkType::LoaderGlobalNames:      return "LoaderGlobalNames";
+    case loader::IoChunkType::LoaderGlobalNameHashes: return "LoaderGlobalNameHashes";
+    case loader::IoChunkType::ContainerHeader:        return "ContainerHeader";
+    }
+    return "Unknown";
+}
+
+template <typename Fn>
+static double
+median_us(int iterations, Fn&& fn)
+{
+    std::vector<double> t;
+    for (int i = 0; i < iterations; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+        fn();
+        t.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count());
+    }
+    std::sort(t.begin(), t.end());
+    return t[t.size() / 2];
+}
+
+int
+main(int argc, char** argv)
+{
+    fs::path path;
+    fs::path keys_path;
+    bool     list_files = false;
+    int      iterations = 101;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--files") {
+            list_files = true;
+        } else if (a == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (a == "--keys" && i + 1 < argc) {
+            keys_path = argv[++i];
+        } else if (!a.empty() && a[0] != '-') {
+            path = a;
+        } else {
+            path.clear();
+            break;
+        }
+    }
+
+    if (path.empty()) {
+        std::fprintf(stderr, "usage: utoc_info <file.utoc> [--files] [--iterations N] [--keys keys.txt]\n");
+        return 2;
+    }
+
+    loader::MappedFile file;
+    if (!file.open(path)) {
+        std::fprintf(stderr, "cannot open %s\n", path.c_str());
+        return 1;
+    }
+
+    std::string     err;
+    loader::TocView toc;
+    if (!toc.parse(file.data(), file.size(), err)) {
+        std::fprintf(stderr, "%s: %s\n", path.c_str(), err.c_str());
+        return 1;
+    }
+
+    const loader::TocHeader& h = toc.header();
+    std::printf("file:              %s (%llu bytes)\n", path.c_str(), (unsigned long long)file.size());
+    std::printf("version:           %u\n", h.version);
+    std::printf("container id:      %016llx\n", (unsigned long long)h.container_id);
+    std::printf("flags:             %s%s%s%s\n",
+                (h.container_flags & loader::TocCompressed) ? "compressed " : "",
+                (h.container_flags & loader::TocEncrypted) ? "encrypted " : "",
+                (h.container_flags & loader::TocSigned) ? "signed " : "",
+                (h.container_flags & loader::TocIndexed) ? "indexed" : "");
+    std::printf("chunks:            %u\n", h.entry_count);
+    std::printf("blocks:            %u x %u bytes\n", h.compressed_block_entry_count, h.compression_block_size);
+    std::printf("partitions:        %u", h.partition_count);
+    if (h.partition_size != UINT64_MAX) {
+        std::printf(" (max %llu bytes)", (unsigned long long)h.partition_size);
+    }
+    std::printf("\n");
+    std::printf("directory index:   %u bytes\n", h.directory_index_size);
+
+    for (uint32_t m = 1; m <= h.compression_method_name_count; ++m) {
+        std::string name(toc.method_name(m));
+        std::printf("method %u:          %s\n", m, name.c_str());
+    }
+
+    uint32_t types[256] = {};
+    for (uint32_t i = 0; i < toc.chunk_count(); ++i) {
+        ++types[(uint8_t)toc.chunk_id(i).type()];
+    }
+    for (int t = 0; t < 256; ++t) {
+        if (types[t]) {
+            std::printf("  %-22s %u\n", chunk_type_name((loader::IoChunkType)t), types[t]);
+        }
+    }
+
+    fs::path base = path;
+    base.replace_extension("");
+
+    std::vector<uint64_t> sizes;
+    for (uint32_t i = 0; i < h.partition_count; ++i) {
+        std::error_code ec;
+        uint64_t n = fs::file_size(loader::ucas_partition_path(base, i), ec);
+        if (ec) {
+            break;
+        }
+        sizes.push_back(n);
+    }
+
+    bool valid = loader::validate_toc(toc, sizes.data(), (uint32_t)sizes.size(), err);
+    std::printf("validation:        %s\n", valid ? "ok" : err.c_str());
+
+    loader::TocDirectoryIndex dir;
+    bool have_dir = toc.indexed() && !toc.encrypted() &&
+                    dir.parse(toc.directory_index(), toc.directory_index_size(), err);
+    if (have_dir) {
+        std::printf("mount point:       %s\n", dir.mount_point().utf8().c_str());
+        std::printf("index:             %u dir(s), %u file(s)\n", dir.dir_count(), dir.file_count());
+        if (list_files) {
+            bool ok = dir.for_each_file([&](std::string_view p, uint32_t entry) {
+                std::printf("  %6u  %.*s\n", entry, (int)p.size(), p.data());
+            });
+            if (!ok) {
+                std::printf("  <directory index is corrupt>\n");
+            }
+        }
+    } else if (toc.indexed()) {
+        std::printf("directory index:   %s\n", toc.encrypted() ? "encrypted" : err.c_str());
+    }
+
+    if (toc.encrypted()) {
+        std::printf("encryption key:    %s\n", loader::guid_to_string(h.encryption_key_guid).c_str());
+    }
+    if (toc.encrypted() && !keys_path.empty()) {
+        std::vector<std::string> warnings;
+        loader::KeyRing          ring;
+        ring.load(keys_path, warnings);
+        for (const auto& w : warnings) {
+            std::printf("  %s: %s\n", keys_path.c_str(), w.c_str());
+        }
+
+        const uint8_t*           key = ring.find(h.encryption_key_guid);
+        loader::IoStoreContainer c;
+        if (!key) {
+            std::printf("key check:         no key for this GUID in %s\n", keys_path.c_str());
+        } else if (!c.open(base, err)) {
+            std::printf("key check:         %s\n", err.c_str());
+        } else {
+            std::string      detail;
+            loader::KeyCheck r  = loader::KeyCheck::Ok;
+            double           us = median_us(iterations, [&] { r = loader::check_container_key(c, key, detail); });
+            std::printf("key check:         %s%s%s (%.2f us, %s)\n",
+                        r == loader::KeyCheck::Ok ? "ok" : r == loader::KeyCheck::WrongKey ? "wrong key" : "unverifiable",
+                        detail.empty() ? "" : ": ", detail.c_str(), us,
+                        loader::Aes256Decryptor::has_aesni() ? "AES-NI" : "portable AES");
+        }
+    }
+
+    loader::ResidentCost rc = loader::estimate_iostore_resident(toc, base);
+    std::printf("resident estimate: %llu bytes (chunk map %llu, blocks %llu, signatures %llu, directory index %llu, package store %llu, partitions %llu)\n",
+                (unsigned long long)rc.total(), (unsigned long long)rc.chunk_map, (unsigned long long)rc.compression_blocks,
+                (unsigned long long)rc.block_signatures, (unsigned long long)rc.directory_index,
+                (unsigned long long)rc.package_store, (unsigned long long)(rc.partitions + rc.compression_methods));
+
+    // timings, all on the warm mapping
+    loader::TocView scratch;
+    std::string     scratch_err;
+    double t_parse = median_us(iterations, [&] { scratch.parse(file.data(), file.size(), scratch_err); });
+    double t_valid = median_us(iterations, [&] { loader::validate_toc(toc, sizes.data(), (uint32_t)sizes.size(), scratch_err); });
+
+    std::printf("\nparse:             %.2f us\n", t_parse);
+    std::printf("validate:          %.2f us\n", t_valid);
+
+    if (have_dir) {
+        size_t files = 0;
+        double t_index = median_us(iterations, [&] {
+            loader::TocDirectoryIndex d;
+            d.parse(toc.directory_index(), toc.directory_index_size(), scratch_err);
+            files = 0;
+            d.for_each_file([&](std::string_view, uint32_t) { ++files; });
+        });
+        std::printf("index walk:        %.2f us (%zu files)\n", t_index, files);
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    bool ok = loader::check_iostore_container(base, scratch_err);
+    double t_cold = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("map+parse+check:   %.2f us (%s)\n", t_cold, ok ? "ok" : scratch_err.c_str());
+
+    return valid ? 0 : 1;
+}
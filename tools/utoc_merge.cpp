@@ -0,0 +1,432 @@
+// Merges the IoStore containers of a mod folder into a single .utoc/.ucas pair.
+//
+//   utoc_merge <mod_root> <out_dir> [--name NAME]
+//
+// Mods are taken in the order the loader mounts them (discover_mod_dirs(), base order 200,
+// duplicate containers skipped). For every chunk id only the winning copy under those orders
+// is kept, so mounting the merged container gives the same assets as mounting all sources.
+// Compressed blocks are copied as they are, without recompressing. The sources' container
+// headers are merged into one, and their directory indices into one.
+//
+// A mod is left out, and keeps being mounted on its own, when any of its containers cannot be
+// merged: a .pak with entries, an encrypted container, or a different compression block size.
+// <NAME>.actors lists the merged containers so the loader still spawns each one's ModActor.
+
+#include "loader/container_header.hpp"
+#include "loader/content_hash.hpp"
+#include "loader/iostore_container.hpp"
+#include "loader/mod_discovery.hpp"
+#include "loader/override_index.hpp"
+#include "loader/pak.hpp"
+#include "loader/utoc.hpp"
+#include "loader/utoc_writer.hpp"
+#include "loader/xxhash64.hpp"
+#include "loader/zip_cache.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct Source {
+    const loader::MountEntry*        entry = nullptr;
+    loader::IoStoreContainer         container;
+    std::vector<std::wstring>        actors;
+    uint32_t                         index_container = 0;   // in OverrideIndex::containers()
+};
+
+static std::string
+utf8(const std::wstring& s)
+{
+    return loader::path_to_utf8(fs::path(s));
+}
+
+int
+main(int argc, char** argv)
+{
+    fs::path    root;
+    fs::path    out_dir;
+    std::string name = "MergedMods";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--name" && i + 1 < argc) {
+            name = argv[++i];
+        } else if (!a.empty() && a[0] != '-' && root.empty()) {
+            root = a;
+        } else if (!a.empty() && a[0] != '-' && out_dir.empty()) {
+            out_dir = a;
+        } else {
+            root.clear();
+            break;
+        }
+    }
+
+    if (root.empty() || out_dir.empty()) {
+        std::fprintf(stderr, "usage: utoc_merge <mod_root> <out_dir> [--name NAME]\n");
+        return 2;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    // the loader's mount plan
+    loader::HashCache cache;
+    cache.load(root / ".hashcache");
+
+    auto mods = loader::discover_mod_dirs(root);
+    loader::prepare_zip_mods(mods, root / ".zipcache", cache);
+
+    std::vector<loader::MountEntry> plan;
+    for (size_t i = 0; i < mods.size(); ++i) {
+        if (!mods[i].dir.empty()) {
+            loader::plan_mod_folder(mods[i], 200 + (int)i, plan);
+        }
+    }
+    loader::dedupe_mount_plan(plan, cache);
+
+    // which containers can go in; a mod is merged whole or not at all
+    std::vector<std::unique_ptr<Source>>  sources;
+    std::map<std::wstring, std::string>   left_out;   // mod -> reason
+    std::set<std::wstring>                merged_mods;
+    uint32_t                              block_size = 0;
+
+    for (const auto& e : plan) {
+        if (e.skip) {
+            continue;
+        }
+
+        fs::path base = e.path;
+        base.replace_extension("");
+
+        std::string reason;
+        if (e.kind == loader::ContainerKind::Pak) {
+            loader::PakSummary pak;
+            std::string        err;
+            if (!loader::read_pak_summary(e.path, pak, err)) {
+                reason = utf8(e.name) + ".pak: " + err;
+            } else {
+                switch (loader::pak_mount_mode(pak, loader::file_exists(loader::base_to_ext(base, L".utoc")))) {
+                case loader::PakMountMode::LoadIndex: reason = utf8(e.name) + ".pak has its own entries"; break;
+                case loader::PakMountMode::Skip:      continue;
+                case loader::PakMountMode::SkipIndex: break;
+                }
+            }
+        }
+
+        auto src   = std::make_unique<Source>();
+        src->entry = &e;
+
+        std::string err;
+        if (reason.empty() && !src->container.open(base, err)) {
+            reason = utf8(e.name) + ": " + err;
+        }
+        if (reason.empty() && src->container.toc().encrypted()) {
+            reason = utf8(e.name) + " is encrypted";
+        }
+        if (reason.empty()) {
+            uint32_t bs = src->container.toc().header().compression_block_size;
+            if (block_size == 0) {
+                block_size = bs;
+            } else if (bs != block_size) {
+                reason = utf8(e.name) + " uses " + std::to_string(bs) + "-byte blocks, not " + std::to_string(block_size);
+            }
+        }
+
+        if (!reason.empty()) {
+            left_out.emplace(e.mod_name, reason);
+            continue;
+        }
+
+        src->actors = loader::container_actor_names(e);
+        sources.push_back(std::move(src));
+    }
+
+    std::erase_if(sources, [&](const std::unique_ptr<Source>& s) { return left_out.count(s->entry->mod_name) != 0; });
+    if (sources.empty()) {
+        std::fprintf(stderr, "nothing to merge\n");
+        return 1;
+    }
+
+    // winners among the merged containers only
+    std::vector<loader::MountEntry> merge_plan = plan;
+    std::unordered_set<const loader::MountEntry*> in_merge;
+    for (const auto& s : sources) {
+        in_merge.insert(s->entry);
+    }
+    for (size_t i = 0; i < plan.size(); ++i) {
+        merge_plan[i].skip = merge_plan[i].skip || !in_merge.count(&plan[i]);
+    }
+
+    loader::OverrideIndex index;
+    index.update(merge_plan);
+
+    std::unordered_map<fs::path::string_type, uint32_t> by_utoc;
+    for (uint32_t c = 0; c < index.containers().size(); ++c) {
+        if (index.containers()[c].live) {
+            by_utoc.emplace(index.containers()[c].utoc.native(), c);
+        }
+    }
+    for (auto& s : sources) {
+        fs::path utoc = s->container.base();
+        utoc += ".utoc";
+        s->index_container = by_utoc.at(utoc.native());
+    }
+
+    const uint64_t container_id = loader::XXH64::hash(name.data(), name.size(), 0);
+
+    std::error_code ec;
+    fs::create_directories(out_dir, ec);
+    fs::path out_base = out_dir / loader::path_from_utf8(name);
+    fs::path ucas_tmp = out_base;
+    ucas_tmp += ".ucas.tmp";
+
+    std::ofstream ucas(ucas_tmp, std::ios::binary | std::ios::trunc);
+    if (!ucas) {
+        std::fprintf(stderr, "cannot write %s\n", ucas_tmp.c_str());
+        return 1;
+    }
+
+    loader::TocWriter             writer(block_size);
+    loader::DirectoryIndexBuilder dir;
+    std::vector<std::pair<std::string, uint32_t>> files;   // full path, merged entry
+
+    loader::ContainerHeader merged;
+    merged.container_id = container_id;
+    std::unordered_set<uint64_t> merged_packages;
+    bool have_names = false;
+
+    uint64_t ucas_size = 0, chunks_in = 0, chunks_kept = 0, bytes_in = 0, toc_in = 0;
+
+    for (const auto& sp : sources) {
+        const Source& s   = *sp;
+        const auto&   toc = s.container.toc();
+
+        toc_in   += s.container.toc_bytes();
+        bytes_in += s.container.ucas_bytes();
+
+        std::vector<uint32_t> remap(toc.chunk_count(), loader::kTocNone);
+
+        for (uint32_t i = 0; i < toc.chunk_count(); ++i) {
+            ++chunks_in;
+            loader::IoChunkId id = toc.chunk_id(i);
+            loader::ChunkKey  key{ id.id(), loader::rd_le32(id.p + 8) };
+
+            if (id.type() == loader::IoChunkType::ContainerHeader) {
+                std::vector<uint8_t>    bytes;
+                loader::ContainerHeader h;
+                std::string             err;
+                if (!s.container.read_chunk(i, bytes, err) || !loader::parse_container_header(bytes.data(), bytes.size(), h, err)) {
+                    std::fprintf(stderr, "%s: container header: %s\n", utf8(s.entry->name).c_str(), err.c_str());
+                    return 1;
+                }
+
+                if (!h.names.empty()) {
+                    if (!have_names) {
+                        merged.names       = h.names;
+                        merged.name_hashes = h.name_hashes;
+                        have_names         = true;
+                    } else if (h.names != merged.names || h.name_hashes != merged.name_hashes) {
+                        std::fprintf(stderr, "%s: container header name batch differs from the other containers; cannot merge\n",
+                                     utf8(s.entry->name).c_str());
+                        return 1;
+                    }
+                }
+
+                std::unordered_set<uint64_t> won;   // packages this container provides to the merged one
+                for (size_t p = 0; p < h.package_ids.size(); ++p) {
+                    uint64_t pkg = h.package_ids[p];
+                    int64_t  win = index.resolve(loader::ChunkKey{ pkg, (uint32_t)loader::IoChunkType::ExportBundleData << 24 });
+                    if ((win < 0 || (uint32_t)win == s.index_container) && merged_packages.insert(pkg).second) {
+                        merged.package_ids.push_back(pkg);
+                        merged.store_entries.push_back(std::move(h.store_entries[p]));
+                        won.insert(pkg);
+                    }
+                }
+
+                // source -> localized package pairs, kept only with the localized package they point at
+                for (const auto& c : h.culture_package_map) {
+                    auto it = std::find_if(merged.culture_package_map.begin(), merged.culture_package_map.end(),
+                                           [&](const auto& m) { return m.first == c.first; });
+                    for (const auto& pair : c.second) {
+                        if (!won.count(pair.second)) {
+                            continue;
+                        }
+                        if (it == merged.culture_package_map.end()) {
+                            merged.culture_package_map.emplace_back(c.first, std::vector<loader::PackageIdPair>{});
+                            it = merged.culture_package_map.end() - 1;
+                        }
+                        if (std::find(it->second.begin(), it->second.end(), pair) == it->second.end()) {
+                            it->second.push_back(pair);
+                        }
+                    }
+                }
+                for (const auto& r : h.package_redirects) {
+                    if (std::find(merged.package_redirects.begin(), merged.package_redirects.end(), r) == merged.package_redirects.end()) {
+                        merged.package_redirects.push_back(r);
+                    }
+                }
+                continue;
+            }
+
+            if (index.resolve(key) != (int64_t)s.index_container) {
+                continue;   // shadowed by a later mod
+            }
+
+            // memory-mapped bulk data must stay page-aligned in the .ucas
+            uint64_t align = id.type() == loader::IoChunkType::MemoryMappedBulkData ? 16384 : 1;
+            if (ucas_size % align) {
+                uint64_t pad = align - ucas_size % align;
+                static const char zeros[16384] = {};
+                ucas.write(zeros, (std::streamsize)pad);
+                ucas_size += pad;
+            }
+
+            remap[i] = writer.chunk_count();
+            writer.add_chunk(id.p, toc.offset_length(i).length, toc.chunk_hash(i));
+            ++chunks_kept;
+
+            uint64_t first = 0, count = 0;
+            toc.chunk_blocks(i, first, count);
+            for (uint64_t b = first; b < first + count; ++b) {
+                loader::TocCompressedBlock blk = toc.block((uint32_t)b);
+                ucas.write(reinterpret_cast<const char*>(s.container.block_data(blk)), blk.compressed_size);
+                writer.add_block(ucas_size, blk.compressed_size, blk.uncompressed_size, writer.method(toc.method_name(blk.method)));
+                ucas_size += blk.compressed_size;
+            }
+        }
+
+        if (toc.indexed()) {
+            loader::TocDirectoryIndex src_dir;
+            std::string               err;
+            if (src_dir.parse(toc.directory_index(), toc.directory_index_size(), err)) {
+                src_dir.for_each_file([&](std::string_view p, uint32_t entry) {
+                    if (entry < remap.size() && remap[entry] != loader::kTocNone) {
+                        files.emplace_back(std::string(p), remap[entry]);
+                    }
+                });
+            }
+        }
+
+        merged_mods.insert(s.entry->mod_name);
+    }
+
+    // merged container header, stored uncompressed
+    {
+        std::vector<uint8_t> bytes = loader::serialize_container_header(merged);
+
+        uint8_t id[12] = {};
+        std::memcpy(id, &container_id, 8);
+        id[11] = (uint8_t)loader::IoChunkType::ContainerHeader;
+
+        writer.add_chunk(id, bytes.size(), nullptr);
+        for (size_t at = 0; at < bytes.size(); at += block_size) {
+            uint32_t n = (uint32_t)(std::min)((size_t)block_size, bytes.size() - at);
+            ucas.write(reinterpret_cast<const char*>(bytes.data() + at), n);
+            writer.add_block(ucas_size, n, n, 0);
+            ucas_size += n;
+        }
+    }
+
+    // directory index under the longest common directory of all file paths
+    if (!files.empty()) {
+        std::string_view prefix = files[0].first;
+        prefix = prefix.substr(0, prefix.rfind('/') + 1);
+        for (const auto& f : files) {
+            size_t n = 0;
+            while (n < prefix.size() && n < f.first.size() && prefix[n] == f.first[n]) {
+                ++n;
+            }
+            prefix = prefix.substr(0, n);
+        }
+        prefix = prefix.substr(0, prefix.rfind('/') + 1);
+
+        for (const auto& f : files) {
+            dir.add_file(std::string_view(f.first).substr(prefix.size()), f.second);
+        }
+        writer.set_directory_index(dir.serialize(prefix));
+    }
+
+    ucas.close();
+    if (!ucas) {
+        std::fprintf(stderr, "write failed: %s\n", ucas_tmp.c_str());
+        return 1;
+    }
+
+    std::vector<uint8_t> toc_bytes = writer.serialize(container_id);
+
+    fs::path utoc_tmp = out_base;
+    utoc_tmp += ".utoc.tmp";
+    {
+        std::ofstream out(utoc_tmp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(toc_bytes.data()), (std::streamsize)toc_bytes.size());
+        if (!out) {
+            std::fprintf(stderr, "write failed: %s\n", utoc_tmp.c_str());
+            return 1;
+        }
+    }
+
+    {
+        fs::path actors = out_base;
+        actors += ".actors";
+        std::ofstream out(actors, std::ios::binary | std::ios::trunc);
+        for (const auto& s : sources) {
+            for (const auto& a : s->actors) {
+                out << utf8(a) << '\n';
+            }
+        }
+    }
+
+    fs::path ucas_final = out_base, utoc_final = out_base;
+    ucas_final += ".ucas";
+    utoc_final += ".utoc";
+    fs::rename(ucas_tmp, ucas_final, ec);
+    if (ec) {
+        std::fprintf(stderr, "cannot replace %s: %s\n", ucas_final.c_str(), ec.message().c_str());
+        return 1;
+    }
+    fs::rename(utoc_tmp, utoc_final, ec);
+    if (ec) {
+        std::fprintf(stderr, "cannot replace %s: %s\n", utoc_final.c_str(), ec.message().c_str());
+        return 1;
+    }
+
+    std::string err;
+    bool valid = loader::check_iostore_container(out_base, err);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    std::printf("merged %zu container(s) from %zu mod(s) into %s.utoc/.ucas in %.0f ms\n",
+                sources.size(), merged_mods.size(), out_base.c_str(), ms);
+    std::printf("  chunks:   %llu in, %llu kept, %llu shadowed or replaced by the merged container header\n",
+                (unsigned long long)chunks_in, (unsigned long long)writer.chunk_count(),
+                (unsigned long long)(chunks_in - chunks_kept));
+    std::printf("  packages: %zu in the merged container header\n", merged.package_ids.size());
+    std::printf("  .utoc:    %llu -> %zu bytes\n", (unsigned long long)toc_in, toc_bytes.size());
+    std::printf("  .ucas:    %llu -> %llu bytes\n", (unsigned long long)bytes_in, (unsigned long long)ucas_size);
+    std::printf("  check:    %s\n", valid ? "ok" : err.c_str());
+
+    std::printf("\nmove these mods to disabled/ and install %s as a mod folder:\n", name.c_str());
+    for (const auto& m : merged_mods) {
+        std::printf("  %s\n", utf8(m).c_str());
+    }
+
+    if (!left_out.empty()) {
+        std::printf("\nleft out (still mounted on their own):\n");
+        for (const auto& [mod, reason] : left_out) {
+            std::printf("  %s: %s\n", utf8(mod).c_str(), reason.c_str());
+        }
+        std::printf("the merged container mounts at the order of the folder it is installed in; name it so it\n"
+                    "sorts where the left-out mods expect it\n");
+    }
+    return valid ? 0 : 1;
+}